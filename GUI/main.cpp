@@ -18,92 +18,20 @@
 #include <QtGui/QFont>
 #include <QtGui/QIcon>
 
-#include <windows.h>
+#include "core/session.h"
+
 #include <string>
 #include <vector>
-#include <sstream>
 
+// Thin adapter over the shared core session used by the CLI.
 class PathManager {
 public:
-    void loadPaths() {
-        std::string userPath = getEnvironmentVariable("PATH", HKEY_CURRENT_USER);
-        std::string systemPath = getEnvironmentVariable("PATH", HKEY_LOCAL_MACHINE);
-        
-        if (userPath == systemPath) {
-            userPaths = splitPath(userPath);
-            systemPaths.clear(); // don't double-count
-        } else {
-            userPaths = splitPath(userPath);
-            systemPaths = splitPath(systemPath);
-        }
-    }
+    void loadPaths() { session.load("PATH"); }
 
-    const std::vector<std::string>& getUserPaths() const { return userPaths; }
-    const std::vector<std::string>& getSystemPaths() const { return systemPaths; }
+    const pathcore::PathTable& table() const { return session.table(); }
 
 private:
-    std::vector<std::string> userPaths;
-    std::vector<std::string> systemPaths;
-
-    std::string getEnvironmentVariable(const std::string& name, HKEY hKey) {
-        HKEY key;
-        LONG result = RegOpenKeyExA(hKey, 
-            hKey == HKEY_CURRENT_USER ? "Environment" : "SYSTEM\\CurrentControlSet\\Control\\Session Manager\\Environment",
-            0, KEY_READ, &key);
-        
-        if (result != ERROR_SUCCESS) {
-            return "";
-        }
-
-        DWORD valueType;
-        DWORD dataSize = 0;
-        result = RegQueryValueExA(key, name.c_str(), nullptr, &valueType, nullptr, &dataSize);
-        
-        if (result != ERROR_SUCCESS || dataSize == 0) {
-            RegCloseKey(key);
-            return "";
-        }
-
-        std::string value(dataSize, '\0');
-        result = RegQueryValueExA(key, name.c_str(), nullptr, &valueType, 
-                                  reinterpret_cast<LPBYTE>(&value[0]), &dataSize);
-        
-        RegCloseKey(key);
-        
-        if (result == ERROR_SUCCESS) {
-            // Remove null terminator if present
-            if (!value.empty() && value.back() == '\0') {
-                value.pop_back();
-            }
-            return value;
-        }
-        
-        return "";
-    }
-
-    std::vector<std::string> splitPath(const std::string &path) {
-        std::vector<std::string> parts;
-        std::stringstream iss(path);
-        std::string token;
-
-        while (std::getline(iss, token, ';')) {
-            if (!token.empty()) {
-                // Expand environment variables
-                std::string expanded = expandEnvironmentStrings(token);
-                parts.push_back(expanded);
-            }
-        }
-        return parts;
-    }
-
-    std::string expandEnvironmentStrings(const std::string &str) {
-        char buffer[32768];
-        DWORD result = ExpandEnvironmentStringsA(str.c_str(), buffer, sizeof(buffer));
-        if (result > 0 && result <= sizeof(buffer)) {
-            return std::string(buffer);
-        }
-        return str;
-    }
+    pathcore::Session session;
 };
 
 class EnvironmentViewer : public QMainWindow
@@ -501,38 +429,23 @@ private:
         pathTable->setRowCount(0);
         pathManager->loadPaths();
         
-        const auto& userPaths = pathManager->getUserPaths();
-        const auto& systemPaths = pathManager->getSystemPaths();
-        
-        int totalRows = userPaths.size() + systemPaths.size();
-        pathTable->setRowCount(totalRows);
+        const auto& table = pathManager->table();
         
-        int row = 0;
-        
-        // Add user paths
-        for (const auto& path : userPaths) {
-            QTableWidgetItem* typeItem = new QTableWidgetItem("User");
-            QTableWidgetItem* pathItem = new QTableWidgetItem(QString::fromStdString(path));
-            
-            typeItem->setIcon(QIcon()); // You can add icons here
-            pathItem->setToolTip(QString::fromStdString(path));
-            
-            pathTable->setItem(row, 0, typeItem);
-            pathTable->setItem(row, 1, pathItem);
-            row++;
-        }
+        pathTable->setRowCount(static_cast<int>(table.size()));
         
-        // Add system paths
-        for (const auto& path : systemPaths) {
-            QTableWidgetItem* typeItem = new QTableWidgetItem("System");
-            QTableWidgetItem* pathItem = new QTableWidgetItem(QString::fromStdString(path));
+        // One row per entry, user entries first
+        for (uint32_t row = 0; row < table.size(); ++row) {
+            bool user = table.scope(row) == pathcore::Scope::User;
+            QString path = QString::fromUtf8(table.expanded(row).data(),
+                                             static_cast<int>(table.expanded(row).size()));
+            QTableWidgetItem* typeItem = new QTableWidgetItem(user ? "User" : "System");
+            QTableWidgetItem* pathItem = new QTableWidgetItem(path);
             
             typeItem->setIcon(QIcon()); // You can add icons here
-            pathItem->setToolTip(QString::fromStdString(path));
+            pathItem->setToolTip(path);
             
             pathTable->setItem(row, 0, typeItem);
             pathTable->setItem(row, 1, pathItem);
-            row++;
         }
         
         updatePathStatusLabel();
@@ -561,14 +474,13 @@ private:
             }
         }
         
-        const auto& userPaths = pathManager->getUserPaths();
-        const auto& systemPaths = pathManager->getSystemPaths();
+        const auto& table = pathManager->table();
         
         QString pathStatus = QString(" | PATH: %1 of %2 entries (%3 user, %4 system)")
                            .arg(visibleRows)
                            .arg(pathTable->rowCount())
-                           .arg(userPaths.size())
-                           .arg(systemPaths.size());
+                           .arg(table.count(pathcore::Scope::User))
+                           .arg(table.count(pathcore::Scope::System));
         
         statusLabel->setText(statusLabel->text() + pathStatus);
     }
@@ -0,0 +1,98 @@
+// N writer processes appending to the user PATH of one file-backed store.
+// Compare-and-swap updates must lose nothing; blind read-modify-write (the
+// old behaviour) is run alongside for contrast.
+//
+//   build/concurrent_writers [ops-per-writer] [max-writers]
+
+#include "core/session.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace pathcore;
+namespace fs = std::filesystem;
+
+#ifndef _WIN32
+static void writer(const std::string &root, int id, int ops, bool cas) {
+  Session session(std::make_unique<FileStore>(root));
+  session.setNotify(false);
+  for (int k = 0; k < ops; ++k) {
+    std::string entry = "/w" + std::to_string(id) + "/" + std::to_string(k);
+    if (cas) {
+      session.load("PATH");
+      session.update(Scope::User, [&](std::vector<std::string> &entries) {
+        entries.push_back(entry);
+        return EditResult::Changed;
+      });
+    } else {
+      StoreValue v;
+      session.store().read(Scope::User, "PATH", v);
+      v.data += (v.data.empty() ? "" : ";") + entry;
+      session.store().write(Scope::User, "PATH", v.data,
+                            ValueKind::ExpandString);
+    }
+  }
+}
+
+// Returns how many of the expected entries are missing afterwards.
+static size_t run(int writers, int ops, bool cas, double &seconds) {
+  std::string root =
+      (fs::temp_directory_path() / ("pathmgr-stress-" + std::to_string(getpid())))
+          .string();
+  fs::remove_all(root);
+  fs::create_directories(root);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int id = 0; id < writers; ++id) {
+    if (fork() == 0) {
+      writer(root, id, ops, cas);
+      _exit(0);
+    }
+  }
+  for (int id = 0; id < writers; ++id)
+    wait(nullptr);
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          start)
+                .count();
+
+  FileStore store(root);
+  StoreValue v;
+  store.read(Scope::User, "PATH", v);
+  size_t found = splitPath(v.data).size();
+  fs::remove_all(root);
+  return static_cast<size_t>(writers) * ops - found;
+}
+#endif
+
+int main(int argc, char *argv[]) {
+#ifdef _WIN32
+  std::puts("concurrent_writers needs fork(); run it on the stand-in store.");
+  return 0;
+#else
+  int ops = argc > 1 ? std::atoi(argv[1]) : 200;
+  int maxWriters = argc > 2 ? std::atoi(argv[2]) : 8;
+
+  std::printf("%-8s %-6s %10s %10s %12s\n", "mode", "N", "updates", "lost",
+              "updates/s");
+  bool ok = true;
+  for (int n = 1; n <= maxWriters; n *= 2) {
+    for (bool cas : {true, false}) {
+      double secs = 0;
+      size_t lost = run(n, ops, cas, secs);
+      std::printf("%-8s %-6d %10d %10zu %12.0f\n", cas ? "cas" : "blind", n,
+                  n * ops, lost, n * ops / secs);
+      if (cas && lost != 0)
+        ok = false;
+    }
+  }
+  return ok ? 0 : 1;
+#endif
+}
@@ -0,0 +1,96 @@
+// Finding identical tool copies: hash throughput of fastHash against the
+// byte-wise FNV-1a used for short strings, then scanContent over a tree of
+// copied tool directories, cold and again with the hash cache.
+//
+//   build/content_bench [directories] [tools] [megabytes-per-tool] [threads]
+
+#include "core/content.h"
+#include "core/text.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pathcore;
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+int main(int argc, char *argv[]) {
+  int dirCount = argc > 1 ? std::atoi(argv[1]) : 8;
+  int tools = argc > 2 ? std::atoi(argv[2]) : 20;
+  int megabytes = argc > 3 ? std::atoi(argv[3]) : 2;
+  unsigned threads = argc > 4 ? static_cast<unsigned>(std::atoi(argv[4]))
+                              : std::max(1u, std::thread::hardware_concurrency());
+
+  std::string block(size_t(64) << 20, '\0');
+  for (size_t k = 0; k < block.size(); ++k)
+    block[k] = static_cast<char>(k * 2654435761u >> 13);
+  auto start = Clock::now();
+  uint64_t fast = fastHash(block.data(), block.size());
+  double fastMs = millisSince(start);
+  start = Clock::now();
+  uint64_t fnv = contentHash(block);
+  double fnvMs = millisSince(start);
+
+  // Every other directory is a copy of dir0; the rest differ in one byte
+  // per tool, so sizes match everywhere and every tool must be read.
+  fs::path root = fs::temp_directory_path() / "pathmgr-content-bench";
+  fs::remove_all(root);
+  std::vector<std::string> dirs;
+  std::string body(size_t(megabytes) << 20, 'x');
+  for (int d = 0; d < dirCount; ++d) {
+    fs::path dir = root / ("dir" + std::to_string(d));
+    fs::create_directories(dir);
+    dirs.push_back(dir.string());
+    for (int k = 0; k < tools; ++k) {
+      body[0] = static_cast<char>(k);
+      body[1] = static_cast<char>(d % 2 ? d : 0);
+      fs::path file = dir / ("tool" + std::to_string(k) + ".exe");
+      std::ofstream(file, std::ios::binary) << body;
+      fs::permissions(file, fs::perms::owner_all);
+    }
+  }
+
+  ContentHashCache cache((root / "content.cache").string());
+  ContentScanOptions options;
+  options.threads = threads;
+  options.cache = &cache;
+  start = Clock::now();
+  ContentReport cold = scanContent(dirs, options);
+  double coldMs = millisSince(start);
+  std::string error;
+  cache.save(error);
+
+  ContentHashCache reloaded(cache.path());
+  reloaded.load(error);
+  options.cache = &reloaded;
+  start = Clock::now();
+  ContentReport warm = scanContent(dirs, options);
+  double warmMs = millisSince(start);
+
+  std::printf("hash of 64 MB: fastHash %.1f ms (%.0f MB/s), FNV-1a %.1f ms "
+              "(%.0f MB/s)\n\n",
+              fastMs, 64000 / fastMs, fnvMs, 64000 / fnvMs);
+  std::printf("%d directories x %d tools x %d MB, %u threads\n", dirCount,
+              tools, megabytes, threads);
+  std::printf("%-12s %10s %10s %10s %10s\n", "scan", "ms", "read MB", "cached",
+              "groups");
+  std::printf("%-12s %10.1f %10.1f %10zu %10zu\n", "cold", coldMs,
+              cold.bytesRead / 1048576.0, cold.cached, cold.groups.size());
+  std::printf("%-12s %10.1f %10.1f %10zu %10zu\n", "cached", warmMs,
+              warm.bytesRead / 1048576.0, warm.cached, warm.groups.size());
+  fs::remove_all(root);
+  bool same = cold.groups == warm.groups &&
+              cold.sameDirectories == warm.sameDirectories;
+  return same && fast != fnv ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+// Resolving PATH-like entries through a symlinked prefix: weakly_canonical
+// on each entry, as remove used to, against IdentityCache, which resolves
+// each shared prefix once, serially and on a worker pool.
+//
+//   build/identity_bench [entries] [threads]
+
+#include "core/identity.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pathcore;
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+int main(int argc, char *argv[]) {
+  int count = argc > 1 ? std::atoi(argv[1]) : 2000;
+  unsigned threads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2]))
+                              : std::max(1u, std::thread::hardware_concurrency());
+
+  // root/real/app<k>/bin exists for every other k; root/link -> root/real
+  fs::path root = fs::temp_directory_path() / "pathmgr-identity-bench";
+  fs::remove_all(root);
+  std::vector<std::string> entries;
+  for (int k = 0; k < count; ++k) {
+    fs::path dir = root / "real" / ("app" + std::to_string(k % 500)) / "bin";
+    if (k % 2 == 0)
+      fs::create_directories(dir);
+    entries.push_back(
+        (root / (k % 3 ? "link" : "real") / ("app" + std::to_string(k % 500)) /
+         (k % 4 ? "bin" : "lib"))
+            .string());
+  }
+  std::error_code ec;
+  fs::create_directory_symlink(root / "real", root / "link", ec);
+  if (ec) {
+    std::printf("Cannot create a symlink here (%s).\n", ec.message().c_str());
+    fs::remove_all(root);
+    return 0;
+  }
+
+  auto start = Clock::now();
+  size_t chars = 0;
+  for (const auto &e : entries)
+    chars += fs::weakly_canonical(e, ec).native().size();
+  double canonicalMs = millisSince(start);
+
+  IdentityCache serial;
+  start = Clock::now();
+  auto keys = serial.keys(entries, 1);
+  double serialMs = millisSince(start);
+
+  IdentityCache parallel;
+  start = Clock::now();
+  auto parallelKeys = parallel.keys(entries, threads);
+  double parallelMs = millisSince(start);
+
+  std::printf("%d entries under a symlinked prefix\n\n", count);
+  std::printf("%-28s %10s\n", "method", "ms");
+  std::printf("%-28s %10.2f\n", "weakly_canonical per entry", canonicalMs);
+  std::printf("%-28s %10.2f\n", "IdentityCache, 1 thread", serialMs);
+  std::printf("%-28s %10.2f\n",
+              ("IdentityCache, " + std::to_string(threads) + " threads").c_str(),
+              parallelMs);
+  fs::remove_all(root);
+  return keys == parallelKeys && chars ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+// Impact of appending one directory to a long PATH: changeImpact with a
+// cold name index (every directory listed), with the index reloaded from
+// its cache file, and a naive re-resolution of every name on the PATH.
+//
+//   build/impact_bench [directories] [tools-per-directory]
+
+#include "core/cost.h"
+#include "core/impact.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace pathcore;
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+int main(int argc, char *argv[]) {
+  int dirCount = argc > 1 ? std::atoi(argv[1]) : 200;
+  int tools = argc > 2 ? std::atoi(argv[2]) : 100;
+
+  // dir<d>/tool<d*7+k>: neighbouring directories share some names, and
+  // the appended directory shadows nothing but adds ten new tools.
+  fs::path root = fs::temp_directory_path() / "pathmgr-impact-bench";
+  fs::remove_all(root);
+  std::vector<std::string> before;
+  auto make = [&](const fs::path &dir, int first, int count) {
+    fs::create_directories(dir);
+    for (int k = 0; k < count; ++k) {
+      fs::path file = dir / ("tool" + std::to_string(first + k) + ".exe");
+      std::ofstream(file) << "";
+      fs::permissions(file, fs::perms::owner_all);
+    }
+  };
+  for (int d = 0; d < dirCount; ++d) {
+    fs::path dir = root / ("dir" + std::to_string(d));
+    make(dir, d * 7, tools);
+    before.push_back(dir.string());
+  }
+  fs::path extra = root / "extra";
+  make(extra, dirCount * 7 + tools - 5, 10);
+  std::vector<std::string> after = before;
+  after.push_back(extra.string());
+
+  std::vector<std::string> exts = lookupExtensions();
+  std::string cacheFile = (root / "names.cache").string(), error;
+
+  NameIndex cold(cacheFile);
+  auto start = Clock::now();
+  ImpactReport coldReport = changeImpact(before, after, exts, cold);
+  double coldMs = millisSince(start);
+  cold.save(error);
+
+  NameIndex warm(cacheFile);
+  start = Clock::now();
+  warm.load(error);
+  ImpactReport warmReport = changeImpact(before, after, exts, warm);
+  double warmMs = millisSince(start);
+
+  // Every name on the new PATH, resolved in both orders
+  NameIndex naive;
+  start = Clock::now();
+  std::unordered_set<std::string> all;
+  for (const auto &dir : after)
+    for (const auto &name : naive.names(dir))
+      all.insert(name);
+  size_t differing = 0;
+  for (const auto &name : all) {
+    auto files = lookupNames(name, exts);
+    auto first = [&](const std::vector<std::string> &order) -> std::string {
+      for (const auto &dir : order) {
+        const auto &names = naive.names(dir);
+        for (const auto &f : files)
+          if (std::binary_search(names.begin(), names.end(), f))
+            return dir;
+      }
+      return "";
+    };
+    differing += first(before) != first(after);
+  }
+  double naiveMs = millisSince(start);
+
+  std::printf("%d directories x %d tools, one directory appended\n\n",
+              dirCount, tools);
+  std::printf("%-22s %10s %10s %10s\n", "method", "ms", "names", "impact");
+  std::printf("%-22s %10.2f %10zu %10zu\n", "index, cold", coldMs,
+              coldReport.checked, coldReport.gained.size());
+  std::printf("%-22s %10.2f %10zu %10zu\n", "index, from cache", warmMs,
+              warmReport.checked, warmReport.gained.size());
+  std::printf("%-22s %10.2f %10zu %10zu\n", "every name", naiveMs, all.size(),
+              differing);
+  fs::remove_all(root);
+  return coldReport.gained.size() == differing &&
+                 warmReport.gained.size() == differing
+             ? 0
+             : 1;
+}
@@ -0,0 +1,99 @@
+// Pulling Environment keys out of a whole-hive .reg export: a synthetic
+// UTF-16LE dump with the keys buried among thousands of others, read once
+// raw (the disk-speed floor) and once through importEnvironment.
+//
+//   build/reg_bench [megabytes]
+
+#include "core/regfile.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace pathcore;
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+static long peakKilobytes() {
+#ifdef _WIN32
+  return 0;
+#else
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+#endif
+}
+
+int main(int argc, char *argv[]) {
+  int megabytes = argc > 1 ? std::atoi(argv[1]) : 200;
+  fs::path file = fs::temp_directory_path() / "pathmgr-reg-bench.reg";
+
+  // Keys of plain values and long hex blobs, as software hives hold, with
+  // the user and system Environment keys in the middle.
+  {
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    RegWriter reg(out, RegEncoding::Utf16);
+    std::string blob(400, 'x');
+    uint64_t target = uint64_t(megabytes) << 20;
+    for (int k = 0; uint64_t(out.tellp()) < target; ++k) {
+      if (k == 5000) {
+        reg.key("HKEY_USERS\\S-1-5-21-1000\\Environment");
+        reg.value("Path", "%USERPROFILE%\\bin;C:\\Tools", ValueKind::ExpandString);
+        reg.key("HKEY_LOCAL_MACHINE\\SYSTEM\\ControlSet001\\Control\\"
+                "Session Manager\\Environment");
+        reg.value("Path", "%SystemRoot%\\system32;%SystemRoot%",
+                  ValueKind::ExpandString);
+      }
+      reg.key("HKEY_LOCAL_MACHINE\\SOFTWARE\\Vendor\\Product" +
+              std::to_string(k));
+      reg.value("InstallDir", "C:\\Program Files\\Product" + std::to_string(k),
+                ValueKind::String);
+      reg.value("Data", blob, ValueKind::ExpandString);
+    }
+  }
+  double size = static_cast<double>(fs::file_size(file)) / (1 << 20);
+
+  auto start = Clock::now();
+  {
+    std::ifstream in(file, std::ios::binary);
+    std::vector<char> buf(size_t(1) << 20);
+    while (in.read(buf.data(), static_cast<std::streamsize>(buf.size())) ||
+           in.gcount() > 0) {
+    }
+  }
+  double rawMs = millisSince(start);
+
+  long before = peakKilobytes();
+  RegEnvironment env;
+  std::string error;
+  start = Clock::now();
+  bool ok = importEnvironment(file.string(), "", env, error);
+  double parseMs = millisSince(start);
+  long after = peakKilobytes();
+
+  std::printf("%.0f MB UTF-16LE export\n\n", size);
+  std::printf("%-20s %10s %10s\n", "pass", "ms", "MB/s");
+  std::printf("%-20s %10.1f %10.0f\n", "raw read", rawMs, size * 1000 / rawMs);
+  std::printf("%-20s %10.1f %10.0f\n", "importEnvironment", parseMs,
+              size * 1000 / parseMs);
+  std::printf("\npeak memory grew by %ld KB while parsing\n", after - before);
+  fs::remove(file);
+  if (!ok) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  return env.values[0].size() == 1 && env.values[1].size() == 1 ? 0 : 1;
+}
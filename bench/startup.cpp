@@ -0,0 +1,120 @@
+// Wall time of whole CLI runs, from exec to exit, against a file-backed
+// store of realistic size. Login scripts run the tool on every shell start,
+// so the commands they use must stay within the startup budget.
+//
+//   build/startup [cli] [user-entries] [system-entries] [budget-ms]
+
+#include "core/store.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace pathcore;
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+#ifndef _WIN32
+static std::string entries(const char *prefix, int n) {
+  std::string s;
+  for (int i = 0; i < n; ++i)
+    s += (i ? ";" : "") + std::string(prefix) + std::to_string(i);
+  return s;
+}
+
+// Runs `args` with output discarded; returns elapsed milliseconds.
+static double run(const std::vector<std::string> &args) {
+  std::vector<char *> argv;
+  for (const auto &a : args)
+    argv.push_back(const_cast<char *>(a.c_str()));
+  argv.push_back(nullptr);
+
+  auto start = Clock::now();
+  pid_t pid = fork();
+  if (pid == 0) {
+    int null = open("/dev/null", O_RDWR);
+    dup2(null, 0);
+    dup2(null, 1);
+    dup2(null, 2);
+    execv(argv[0], argv.data());
+    _exit(127);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+#endif
+
+int main(int argc, char *argv[]) {
+#ifdef _WIN32
+  std::puts("startup needs fork(); run it on the stand-in store.");
+  return 0;
+#else
+  std::string cli = fs::absolute(argc > 1 ? argv[1] : "main").string();
+  int userCount = argc > 2 ? std::atoi(argv[2]) : 60;
+  int systemCount = argc > 3 ? std::atoi(argv[3]) : 200;
+  double budget = argc > 4 ? std::atof(argv[4]) : 5.0;
+  if (!fs::exists(cli)) {
+    std::fprintf(stderr, "No CLI at %s; build it with 'make' first.\n",
+                 cli.c_str());
+    return 1;
+  }
+
+  std::string root =
+      (fs::temp_directory_path() / ("pathmgr-startup-" + std::to_string(getpid())))
+          .string();
+  fs::remove_all(root);
+  fs::create_directories(root);
+  FileStore store(root);
+  store.write(Scope::User, "PATH", entries("/opt/user/bin", userCount),
+              ValueKind::ExpandString);
+  store.write(Scope::System, "PATH", entries("%SystemRoot%/sys", systemCount),
+              ValueKind::ExpandString);
+  setenv("PATHMGR_STORE", root.c_str(), 1);
+
+  // What login scripts run: nothing below writes the store
+  struct Case {
+    const char *name;
+    std::vector<std::string> args;
+    bool budgeted;
+  } cases[] = {
+      {"version", {cli, "version"}, true},
+      {"add (present)", {cli, "add", "/opt/user/bin1"}, true},
+      {"remove (absent)", {cli, "remove", "/opt/none"}, true},
+      {"search", {cli, "search", "sys1"}, false},
+      {"show", {cli, "show"}, false},
+  };
+
+  const int runs = 31;
+  std::printf("%d user + %d system entries, %d runs, budget %.1f ms\n\n",
+              userCount, systemCount, runs, budget);
+  std::printf("%-18s %10s %10s %10s\n", "command", "median ms", "p90 ms",
+              "budget");
+  bool ok = true;
+  for (const auto &c : cases) {
+    run(c.args); // warm the page cache
+    std::vector<double> ms;
+    for (int k = 0; k < runs; ++k)
+      ms.push_back(run(c.args));
+    std::sort(ms.begin(), ms.end());
+    double median = ms[runs / 2], p90 = ms[runs * 9 / 10];
+    const char *verdict = !c.budgeted ? "-" : median <= budget ? "ok" : "OVER";
+    if (c.budgeted && median > budget)
+      ok = false;
+    std::printf("%-18s %10.2f %10.2f %10s\n", c.name, median, p90, verdict);
+  }
+  fs::remove_all(root);
+  return ok ? 0 : 1;
+#endif
+}
@@ -0,0 +1,492 @@
+// Reproducible benchmark suite: synthetic PATHs of every shape and size run
+// through each stage a command goes through, with the time and heap
+// allocations per operation written as JSON and compared against a stored
+// baseline.
+//
+//   build/suite [--json FILE] [--baseline FILE] [--threshold PERCENT]
+//               [--sizes N,N,...] [--filter TEXT]
+//
+// Shapes are generated from a fixed seed, so two runs time the same input:
+//   plain       distinct directories, the first 4096 existing
+//   variables   entries built from %PMBENCH_*% references
+//   duplicates  a quarter as many directories, respelled in case and with
+//               trailing separators
+//   deep        24 levels below the root, the first 256 existing
+//   missing     four in five entries name nothing
+//
+// With --baseline, exits 1 if any operation got slower than the baseline
+// by more than the threshold (default 15%), judged on the fastest sample.
+// A regression is re-measured twice before it counts, so one noisy run
+// does not fail a check. Exits 2 if the baseline has no results or none
+// of them was run.
+
+#include "core/identity.h"
+#include "core/probe.h"
+#include "core/render.h"
+#include "core/screen.h"
+#include "core/session.h"
+#include "core/store.h"
+#include "core/table.h"
+#include "core/text.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pathcore;
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Allocation counting
+// ─────────────────────────────────────────────────────────────────────────────
+// Only this program replaces the allocator; the CLI and library keep the
+// standard one.
+static std::atomic<uint64_t> allocations{0};
+
+void *operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+static double microsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - start)
+      .count();
+}
+
+static void setVariable(const std::string &name, const std::string &value) {
+#ifdef _WIN32
+  _putenv_s(name.c_str(), value.c_str());
+#else
+  setenv(name.c_str(), value.c_str(), 1);
+#endif
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Synthetic PATHs
+// ─────────────────────────────────────────────────────────────────────────────
+static const char *const kShapes[] = {"plain", "variables", "duplicates",
+                                      "deep", "missing"};
+static const int kExisting = 4096, kDeepExisting = 256, kDeepLevels = 24,
+                 kVariables = 32;
+
+static std::string deepPrefix(const fs::path &root) {
+  fs::path p = root / "deep";
+  for (int level = 0; level < kDeepLevels; ++level)
+    p /= "level" + std::to_string(level);
+  return p.string();
+}
+
+// Directories the shapes point at; variables PMBENCH_ROOT and PMBENCH_V<k>
+// name some of them.
+static void makeTree(const fs::path &root) {
+  for (int k = 0; k < kExisting; ++k)
+    fs::create_directories(root / "tree" / ("app" + std::to_string(k)) / "bin");
+  fs::path deep = deepPrefix(root);
+  for (int k = 0; k < kDeepExisting; ++k)
+    fs::create_directories(deep / ("app" + std::to_string(k)));
+  setVariable("PMBENCH_ROOT", root.string());
+  for (int k = 0; k < kVariables; ++k)
+    setVariable("PMBENCH_V" + std::to_string(k),
+                (root / "tree" / ("app" + std::to_string(k * 97))).string());
+}
+
+static std::vector<std::string> generate(const std::string &shape, size_t n,
+                                         const fs::path &root) {
+  std::mt19937_64 rng(42 + n * 31 + shape.size());
+  const char sep = fs::path::preferred_separator;
+  std::string tree = (root / "tree").string() + sep, deep = deepPrefix(root);
+  auto app = [&](size_t k) { return "app" + std::to_string(k); };
+
+  std::vector<std::string> out;
+  out.reserve(n);
+  for (size_t k = 0; k < n; ++k) {
+    std::string entry;
+    if (shape == "plain") {
+      entry = tree + app(k) + sep + "bin";
+    } else if (shape == "variables") {
+      if (rng() % 2)
+        entry = std::string("%PMBENCH_ROOT%") + sep + "tree" + sep + app(k) +
+                sep + "bin";
+      else
+        entry = "%PMBENCH_V" + std::to_string(rng() % kVariables) + "%" + sep +
+                "bin";
+    } else if (shape == "duplicates") {
+      entry = tree + app(rng() % std::max<size_t>(1, n / 4)) + sep + "bin";
+      if (rng() % 3 == 0)
+        entry += sep;
+      if (rng() % 3 == 0)
+        std::transform(entry.begin(), entry.end(), entry.begin(), [](char c) {
+          return static_cast<char>(toupper(static_cast<unsigned char>(c)));
+        });
+    } else if (shape == "deep") {
+      entry = deep + sep + app(k);
+    } else {
+      entry = rng() % 5 ? (root / ("gone" + std::to_string(k)) / "bin").string()
+                        : tree + app(rng() % kExisting) + sep + "bin";
+    }
+    out.push_back(std::move(entry));
+  }
+  return out;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Fixtures and operations
+// ─────────────────────────────────────────────────────────────────────────────
+// One generated PATH with everything the operations start from, so each
+// operation times only its own stage.
+struct Fixture {
+  std::string value;
+  std::vector<std::string> raw, expanded;
+  std::vector<uint64_t> hashes;
+  std::vector<char> exists; // probed once, for the render ops
+  PathTable table;
+  std::unique_ptr<Session> session;
+};
+
+static void buildFixture(Fixture &f, const std::string &shape, size_t n,
+                         const fs::path &root) {
+  f.raw = generate(shape, n, root);
+  f.value = joinPath(f.raw);
+  Expander expander;
+  ProbeCache probes;
+  for (const auto &entry : f.raw) {
+    f.expanded.push_back(expander.expand(entry));
+    f.hashes.push_back(canonicalHash(f.expanded.back()));
+    f.exists.push_back(
+        probes.directoryExists(f.expanded.back(), f.hashes.back()));
+    f.table.append(Scope::User, entry, f.expanded.back());
+  }
+
+  fs::path store = root / ("store-" + shape + "-" + std::to_string(n));
+  fs::create_directories(store);
+  auto backing = std::make_unique<FileStore>(store.string());
+  backing->write(Scope::User, "PATH", f.value, ValueKind::ExpandString);
+  f.session = std::make_unique<Session>(std::move(backing));
+  // The write path is the store's version check and rename; the journal
+  // and broadcast are timed by concurrent_writers and startup.
+  f.session->setNotify(false);
+  f.session->setJournaling(false);
+  f.session->load("PATH");
+}
+
+// Keeps results observable so the optimizer cannot drop the work.
+static volatile size_t sink;
+
+struct Operation {
+  const char *name;
+  std::function<void(Fixture &)> run;
+};
+
+static std::vector<Operation> operations() {
+  return {
+      {"split", [](Fixture &f) { sink = splitPath(f.value).size(); }},
+      {"expand",
+       [](Fixture &f) {
+         Expander expander;
+         size_t bytes = 0;
+         for (const auto &entry : f.raw)
+           bytes += expander.expand(entry).size();
+         sink = bytes;
+       }},
+      {"duplicates",
+       [](Fixture &f) {
+         PathTable table;
+         table.reserve(f.raw.size(), f.value.size() * 2);
+         for (size_t i = 0; i < f.raw.size(); ++i)
+           table.append(Scope::User, f.raw[i], f.expanded[i]);
+         table.markDuplicates();
+         sink = table.size();
+       }},
+      {"identity",
+       [](Fixture &f) {
+         IdentityCache cache;
+         sink = cache.keys(f.expanded, 1).size();
+       }},
+      {"search",
+       [](Fixture &f) { sink = searchEntries(f.table, "APP1").size(); }},
+      {"validate",
+       [](Fixture &f) {
+         ProbeCache probes;
+         size_t found = 0;
+         for (size_t i = 0; i < f.expanded.size(); ++i)
+           found += probes.directoryExists(f.expanded[i], f.hashes[i]);
+         sink = found;
+       }},
+      {"render-list",
+       [](Fixture &f) {
+         // The rows of `show`, colored as on a terminal.
+         static const ListStyle style = {"\x1b[35m", "\x1b[96m", "\x1b[92m",
+                                         "\x1b[91m", "\x1b[36m", "\x1b[96m",
+                                         "\x1b[37m", "\x1b[0m"};
+         std::string out;
+         for (uint32_t i = 0; i < f.table.size(); ++i)
+           appendListRow(out, style, f.table, i, f.exists[i] != 0,
+                         i + 1 == f.table.size());
+         sink = out.size();
+       }},
+      {"render-screen",
+       [](Fixture &f) {
+         // A browse page scrolled by one row: two frames, the second diffed.
+         Screen screen;
+         screen.resize(50, 120);
+         uint16_t dim = screen.style("\x1b[90m");
+         size_t bytes = 0;
+         for (uint32_t top = 0; top < 2; ++top) {
+           screen.clear();
+           for (int row = 0; row < 50; ++row) {
+             uint32_t i = top + static_cast<uint32_t>(row);
+             if (i >= f.table.size())
+               break;
+             int col = screen.put(row, 0, std::to_string(i + 1) + " ", dim);
+             screen.put(row, col, f.table.raw(i));
+           }
+           bytes += screen.flush().size();
+         }
+         sink = bytes;
+       }},
+      {"write",
+       [](Fixture &f) {
+         // Append one entry, or take it back off, so the size stays put.
+         auto result = f.session->update(
+             Scope::User, [](std::vector<std::string> &entries) {
+               if (!entries.empty() && entries.back() == "pmbench-extra")
+                 entries.pop_back();
+               else
+                 entries.push_back("pmbench-extra");
+               return EditResult::Changed;
+             });
+         sink = result.attempts;
+       }},
+  };
+}
+
+struct Timing {
+  double median = 0, fastest = 0; // microseconds per run
+  int samples = 0;
+};
+
+// Times `run` in batches that each span at least 200 µs, sampled for about
+// `budgetUs`. The median is what a run typically costs; the fastest sample
+// is what regressions are judged on, being the one least disturbed by
+// whatever else the machine is doing.
+static Timing measure(const std::function<void()> &run, double budgetUs) {
+  auto start = Clock::now();
+  run();
+  double once = std::max(microsSince(start), 0.01);
+  size_t batch = std::max<size_t>(1, static_cast<size_t>(200 / once));
+  Timing t;
+  t.samples = std::clamp(static_cast<int>(budgetUs / (once * batch)), 3, 31);
+
+  std::vector<double> times;
+  for (int s = 0; s < t.samples; ++s) {
+    start = Clock::now();
+    for (size_t b = 0; b < batch; ++b)
+      run();
+    times.push_back(microsSince(start) / static_cast<double>(batch));
+  }
+  std::sort(times.begin(), times.end());
+  t.median = times[times.size() / 2];
+  t.fastest = times.front();
+  return t;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Baselines
+// ─────────────────────────────────────────────────────────────────────────────
+// Reads the `"name"` and `"fastest_us"` of each result line this program
+// writes; anything else in the file is ignored. False if the file cannot
+// be read or holds no results, so a check never passes by comparing
+// nothing.
+static bool loadBaseline(const std::string &file,
+                         std::map<std::string, double> &out) {
+  std::ifstream in(file);
+  if (!in)
+    return false;
+  std::string line;
+  while (std::getline(in, line)) {
+    size_t name = line.find("\"name\": \"");
+    size_t fastest = line.find("\"fastest_us\": ");
+    if (name == std::string::npos || fastest == std::string::npos)
+      continue;
+    name += 9;
+    size_t end = line.find('"', name);
+    if (end == std::string::npos)
+      continue;
+    const char *number = line.c_str() + fastest + 14;
+    char *parsed = nullptr;
+    double us = std::strtod(number, &parsed);
+    if (parsed == number || !(us > 0))
+      continue;
+    out[line.substr(name, end - name)] = us;
+  }
+  return !out.empty();
+}
+
+static std::vector<size_t> parseSizes(const std::string &list) {
+  std::vector<size_t> sizes;
+  size_t start = 0;
+  while (start <= list.size()) {
+    size_t end = list.find(',', start);
+    if (end == std::string::npos)
+      end = list.size();
+    if (end > start)
+      sizes.push_back(std::strtoul(list.c_str() + start, nullptr, 10));
+    start = end + 1;
+  }
+  return sizes;
+}
+
+struct Result {
+  std::string name, op, shape;
+  size_t entries;
+  Timing timing;
+  uint64_t allocs; // per run
+};
+
+int main(int argc, char *argv[]) {
+  std::string jsonFile, baselineFile, filter;
+  std::string sizeList = "10,100,1000,10000,100000";
+  double threshold = 15;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--json" && hasValue)
+      jsonFile = argv[++i];
+    else if (arg == "--baseline" && hasValue)
+      baselineFile = argv[++i];
+    else if (arg == "--threshold" && hasValue)
+      threshold = std::atof(argv[++i]);
+    else if (arg == "--sizes" && hasValue)
+      sizeList = argv[++i];
+    else if (arg == "--filter" && hasValue)
+      filter = argv[++i];
+    else {
+      std::fprintf(stderr,
+                   "usage: %s [--json FILE] [--baseline FILE] "
+                   "[--threshold PERCENT] [--sizes N,N,...] [--filter TEXT]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+
+  std::map<std::string, double> baseline;
+  if (!baselineFile.empty() && !loadBaseline(baselineFile, baseline)) {
+    std::fprintf(stderr, "cannot read baseline %s, or it has no results\n",
+                 baselineFile.c_str());
+    return 2;
+  }
+
+  fs::path root = fs::temp_directory_path() / "pathmgr-bench-suite";
+  fs::remove_all(root);
+  makeTree(root);
+
+  std::vector<Operation> ops = operations();
+  std::vector<Result> results;
+  size_t regressions = 0, compared = 0;
+  const double budgetUs = 50000;
+
+  std::printf("%-32s %12s %12s %10s %12s %8s\n", "operation/shape/entries",
+              "median us", "fastest us", "allocs", "baseline", "change");
+  for (size_t n : parseSizes(sizeList)) {
+    for (const char *shape : kShapes) {
+      Fixture fixture;
+      bool built = false;
+      for (const auto &op : ops) {
+        std::string name =
+            std::string(op.name) + "/" + shape + "/" + std::to_string(n);
+        if (!filter.empty() && name.find(filter) == std::string::npos)
+          continue;
+        if (!built) {
+          buildFixture(fixture, shape, n, root);
+          built = true;
+        }
+        auto run = [&] { op.run(fixture); };
+        Timing timing = measure(run, budgetUs);
+        uint64_t before = allocations.load();
+        run();
+        uint64_t allocs = allocations.load() - before;
+
+        auto base = baseline.find(name);
+        // Slower by the threshold and by more than timer noise.
+        auto regressed = [&](double t) {
+          return base != baseline.end() &&
+                 t > base->second * (1 + threshold / 100) &&
+                 t - base->second > 1.0;
+        };
+        for (int retry = 0; retry < 2 && regressed(timing.fastest); ++retry) {
+          Timing again = measure(run, budgetUs);
+          if (again.fastest < timing.fastest)
+            timing = again;
+        }
+
+        std::printf("%-32s %12.2f %12.2f %10llu", name.c_str(), timing.median,
+                    timing.fastest, static_cast<unsigned long long>(allocs));
+        if (base != baseline.end()) {
+          double change =
+              (timing.fastest / std::max(base->second, 0.001) - 1) * 100;
+          bool bad = regressed(timing.fastest);
+          regressions += bad;
+          ++compared;
+          std::printf(" %12.2f %+7.1f%%%s", base->second, change,
+                      bad ? "  REGRESSION" : "");
+        }
+        std::printf("\n");
+        results.push_back({name, op.name, shape, n, timing, allocs});
+      }
+    }
+  }
+  fs::remove_all(root);
+
+  if (!jsonFile.empty()) {
+    std::ofstream out(jsonFile, std::ios::trunc);
+    out << "{\n  \"suite\": \"pathmgr\",\n  \"version\": 1,\n"
+        << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+      const Result &r = results[i];
+      char times[96];
+      std::snprintf(times, sizeof times,
+                    "\"median_us\": %.3f, \"fastest_us\": %.3f",
+                    r.timing.median, r.timing.fastest);
+      out << "    {\"name\": " << jsonQuote(r.name)
+          << ", \"op\": " << jsonQuote(r.op)
+          << ", \"shape\": " << jsonQuote(r.shape)
+          << ", \"entries\": " << r.entries << ", " << times
+          << ", \"samples\": " << r.timing.samples
+          << ", \"allocs\": " << r.allocs << "}"
+          << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    if (!out) {
+      std::fprintf(stderr, "cannot write %s\n", jsonFile.c_str());
+      return 2;
+    }
+  }
+
+  if (!baseline.empty()) {
+    if (compared == 0) {
+      std::fprintf(stderr, "no operation run is in baseline %s\n",
+                   baselineFile.c_str());
+      return 2;
+    }
+    std::printf("\n%zu of %zu operations regressed by more than %.0f%%\n",
+                regressions, compared, threshold);
+    return regressions ? 1 : 0;
+  }
+  return 0;
+}
@@ -0,0 +1,107 @@
+// Footprint and scan time of the columnar PathTable against the
+// vector<pair<string, string>> layout the commands used to build.
+//
+//   build/table_bench [entries]
+
+#include "core/table.h"
+#include "core/text.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace pathcore;
+using Clock = std::chrono::steady_clock;
+
+static std::string syntheticEntry(size_t i) {
+  static const char *roots[] = {"C:\\Program Files\\", "C:\\Users\\svc-build\\",
+                                "D:\\Tools\\", "C:\\Windows\\"};
+  std::string s = roots[i % 4];
+  s += "Vendor" + std::to_string(i % 997) + "\\Product" +
+       std::to_string(i / 7) + "\\bin";
+  return s;
+}
+
+static size_t stringBytes(const std::string &s) {
+  // Heap bytes beyond the small-string buffer.
+  return s.capacity() > 15 ? s.capacity() + 1 : 0;
+}
+
+template <typename F> static double timeMs(F &&f) {
+  auto start = Clock::now();
+  f();
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+int main(int argc, char *argv[]) {
+  size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+  std::vector<std::string> raw;
+  raw.reserve(n);
+  for (size_t i = 0; i < n; ++i)
+    raw.push_back(syntheticEntry(i));
+
+  // Old layout: one pair per entry, tagged with a scope string.
+  std::vector<std::pair<std::string, std::string>> pairs;
+  pairs.reserve(n);
+  for (size_t i = 0; i < n; ++i)
+    pairs.emplace_back(raw[i], i < n / 2 ? "USER" : "SYS ");
+  size_t pairBytes = pairs.capacity() * sizeof(pairs[0]);
+  for (auto &p : pairs)
+    pairBytes += stringBytes(p.first) + stringBytes(p.second);
+
+  PathTable table;
+  table.reserve(n, n * 48);
+  for (size_t i = 0; i < n; ++i)
+    table.append(i < n / 2 ? Scope::User : Scope::System, raw[i], raw[i]);
+  table.markDuplicates();
+
+  size_t dupPairs = 0, dupTable = 0, hitsPairs = 0, hitsTable = 0;
+  double pairDupMs = timeMs([&] {
+    std::set<std::string> seen;
+    for (auto &e : pairs) {
+      auto low = e.first;
+      std::transform(low.begin(), low.end(), low.begin(), ::tolower);
+      if (!seen.insert(low).second)
+        dupPairs++;
+    }
+  });
+  double tableDupMs = timeMs([&] {
+    table.markDuplicates();
+    for (uint32_t i = 0; i < table.size(); ++i)
+      dupTable += (table.flags(i) & Duplicate) != 0;
+  });
+  double pairScanMs = timeMs([&] {
+    for (auto &e : pairs) {
+      auto low = e.first;
+      std::transform(low.begin(), low.end(), low.begin(), ::tolower);
+      hitsPairs += low.find("product42") != std::string::npos;
+    }
+  });
+  double tableScanMs = timeMs([&] {
+    const char needle[] = "product42";
+    for (uint32_t i = 0; i < table.size(); ++i) {
+      auto e = table.expanded(i);
+      auto it = std::search(e.begin(), e.end(), needle, needle + 9,
+                            [](char a, char b) { return tolower(a) == b; });
+      hitsTable += it != e.end();
+    }
+  });
+
+  std::printf("entries            %zu\n", n);
+  std::printf("footprint   pairs  %10zu bytes  (%.1f B/entry)\n", pairBytes,
+              double(pairBytes) / n);
+  std::printf("            table  %10zu bytes  (%.1f B/entry)\n",
+              table.memoryBytes(), double(table.memoryBytes()) / n);
+  std::printf("duplicates  pairs  %8.2f ms  (%zu)\n", pairDupMs, dupPairs);
+  std::printf("            table  %8.2f ms  (%zu)\n", tableDupMs, dupTable);
+  std::printf("search      pairs  %8.2f ms  (%zu hits)\n", pairScanMs, hitsPairs);
+  std::printf("            table  %8.2f ms  (%zu hits)\n", tableScanMs, hitsTable);
+  return dupPairs == dupTable && hitsPairs == hitsTable ? 0 : 1;
+}
@@ -0,0 +1,322 @@
+#include "pathmgr.h"
+
+#include "core/compact.h"
+#include "core/edits.h"
+#include "core/session.h"
+
+#include <chrono>
+#include <exception>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace pathcore;
+
+namespace {
+
+enum class OpKind : uint8_t { Add, Remove, RemoveKeys };
+
+struct Op {
+  OpKind kind;
+  std::string entry;                 // Add, Remove
+  std::unordered_set<uint64_t> keys; // RemoveKeys
+};
+
+} // namespace
+
+struct pm_session {
+  Session session;
+  std::string variable;
+  unsigned flags = 0;
+  std::vector<Op> staged[2];
+  std::string error;
+  std::string raw, expanded; // returned by pm_entry
+};
+
+namespace {
+
+Scope toScope(pm_scope scope) {
+  return scope == PM_SYSTEM ? Scope::System : Scope::User;
+}
+
+bool validScope(pm_scope scope) { return scope == PM_USER || scope == PM_SYSTEM; }
+
+pm_status fail(pm_session *s, pm_status status, std::string message) {
+  s->error = std::move(message);
+  return status;
+}
+
+// Runs `body` with the session's error cleared, turning anything thrown
+// into PM_ERR_INTERNAL so no exception crosses the C boundary.
+template <typename Body> pm_status guarded(pm_session *s, Body &&body) {
+  if (!s)
+    return PM_ERR_ARGUMENT;
+  s->error.clear();
+  try {
+    return body();
+  } catch (const std::bad_alloc &) {
+    return fail(s, PM_ERR_INTERNAL, "Out of memory");
+  } catch (const std::exception &e) {
+    return fail(s, PM_ERR_INTERNAL, e.what());
+  } catch (...) {
+    return fail(s, PM_ERR_INTERNAL, "Unknown failure");
+  }
+}
+
+pm_status reload(pm_session *s) {
+  if (!s->session.load(s->variable))
+    return fail(s, PM_ERR_STORE, s->session.lastError());
+  return PM_OK;
+}
+
+// Commits the staged ops of one scope as a single update. Every op is
+// re-applied if the update has to retry.
+pm_status commitScope(pm_session *s, Scope scope) {
+  auto &ops = s->staged[static_cast<int>(scope)];
+  if (ops.empty())
+    return PM_UNCHANGED;
+
+  size_t budget = s->flags & PM_ALLOW_OVER_BUDGET ? LengthBudget::MaxValue
+                                                  : LengthBudget::configured();
+  std::vector<EditOutcome> outcomes(ops.size());
+  std::vector<Edit> edits;
+  edits.reserve(ops.size());
+  for (size_t k = 0; k < ops.size(); ++k) {
+    const Op &op = ops[k];
+    switch (op.kind) {
+    case OpKind::Add:
+      edits.push_back(addEntry(s->session, op.entry, budget, outcomes[k]));
+      break;
+    case OpKind::Remove:
+      edits.push_back(removeEntry(s->session, op.entry, outcomes[k]));
+      break;
+    case OpKind::RemoveKeys:
+      edits.push_back(removeKeys(s->session, op.keys, outcomes[k]));
+      break;
+    }
+  }
+
+  size_t refused = ops.size();
+  auto batch = [&](std::vector<std::string> &entries) {
+    bool changed = false;
+    for (size_t k = 0; k < edits.size(); ++k) {
+      changed |= edits[k](entries) == EditResult::Changed;
+      if (outcomes[k].overBudget) {
+        refused = k;
+        return EditResult::Abort;
+      }
+    }
+    return changed ? EditResult::Changed : EditResult::Unchanged;
+  };
+
+  CommitResult result = s->session.update(scope, batch);
+  switch (result.status) {
+  case CommitStatus::Committed:
+    ops.clear();
+    return PM_OK;
+  case CommitStatus::Unchanged:
+    ops.clear();
+    return PM_UNCHANGED;
+  case CommitStatus::Aborted: {
+    std::string message = "Adding \"" + ops[refused].entry + "\" would make " +
+                          s->variable + " " +
+                          std::to_string(outcomes[refused].length) +
+                          " characters long, over the budget of " +
+                          std::to_string(budget);
+    ops.clear();
+    return fail(s, PM_ERR_POLICY, std::move(message));
+  }
+  case CommitStatus::Conflict:
+    ops.clear();
+    return fail(s, PM_ERR_CONFLICT,
+                s->variable + " kept changing during the update; gave up after " +
+                    std::to_string(result.attempts) + " attempts");
+  case CommitStatus::Failed:
+    break;
+  }
+  return fail(s, PM_ERR_STORE, s->session.lastError());
+}
+
+} // namespace
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Sessions
+// ─────────────────────────────────────────────────────────────────────────────
+extern "C" pm_session *pm_open(const char *variable, unsigned flags) {
+  pm_session *s;
+  try {
+    s = new pm_session;
+  } catch (...) {
+    return nullptr;
+  }
+  guarded(s, [&] {
+    s->variable = variable && *variable ? variable : "PATH";
+    s->flags = flags;
+    s->session.setNotify(!(flags & PM_NO_NOTIFY));
+    s->session.setJournaling(!(flags & PM_NO_JOURNAL));
+    return reload(s);
+  });
+  return s;
+}
+
+extern "C" void pm_close(pm_session *s) {
+  if (!s)
+    return;
+  try {
+    s->session.waitForNotifications(std::chrono::seconds(2));
+  } catch (...) {
+  }
+  delete s;
+}
+
+extern "C" pm_status pm_load(pm_session *s) {
+  return guarded(s, [&] { return reload(s); });
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Queries
+// ─────────────────────────────────────────────────────────────────────────────
+extern "C" size_t pm_count(pm_session *s, pm_scope scope) {
+  if (!s || !validScope(scope))
+    return 0;
+  return s->session.table().count(toScope(scope));
+}
+
+extern "C" pm_status pm_entry(pm_session *s, pm_scope scope, size_t index,
+                              const char **raw, const char **expanded,
+                              int *exists) {
+  return guarded(s, [&] {
+    if (!validScope(scope))
+      return fail(s, PM_ERR_ARGUMENT, "Unknown scope");
+    const PathTable &t = s->session.table();
+    if (index >= t.count(toScope(scope)))
+      return fail(s, PM_ERR_RANGE,
+                  "No entry " + std::to_string(index) + " in " +
+                      scopeName(toScope(scope)));
+    uint32_t i = t.begin(toScope(scope)) + static_cast<uint32_t>(index);
+    if (raw) {
+      s->raw = t.raw(i);
+      *raw = s->raw.c_str();
+    }
+    if (expanded) {
+      s->expanded = t.expanded(i);
+      *expanded = s->expanded.c_str();
+    }
+    if (exists)
+      *exists = s->session.exists(i) ? 1 : 0;
+    return PM_OK;
+  });
+}
+
+extern "C" pm_status pm_find(pm_session *s, const char *path, pm_scope *scope,
+                             size_t *index) {
+  return guarded(s, [&] {
+    if (!path || !*path)
+      return fail(s, PM_ERR_ARGUMENT, "No path given");
+    uint64_t key = canonicalHash(s->session.expand(path));
+    const PathTable &t = s->session.table();
+    for (uint32_t i = 0; i < t.size(); ++i) {
+      if (t.keyHash(i) != key)
+        continue;
+      if (scope)
+        *scope = t.scope(i) == Scope::System ? PM_SYSTEM : PM_USER;
+      if (index)
+        *index = i - t.begin(t.scope(i));
+      return PM_OK;
+    }
+    return fail(s, PM_ERR_NOT_FOUND,
+                std::string(path) + " is not in " + s->variable);
+  });
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Staged edits
+// ─────────────────────────────────────────────────────────────────────────────
+extern "C" pm_status pm_add(pm_session *s, pm_scope scope, const char *entry) {
+  return guarded(s, [&] {
+    if (!validScope(scope) || !entry || !*entry)
+      return fail(s, PM_ERR_ARGUMENT, "An entry and a scope are required");
+    std::string e = entry;
+    if (e.find(';') != std::string::npos)
+      return fail(s, PM_ERR_ARGUMENT, "Entries cannot contain ';'");
+    if (!(s->flags & PM_ALLOW_MISSING) &&
+        !s->session.valid(s->session.expand(e)))
+      return fail(s, PM_ERR_POLICY,
+                  "\"" + e + "\" is not a valid " + s->variable + " entry");
+    s->staged[scope].push_back({OpKind::Add, std::move(e), {}});
+    return PM_OK;
+  });
+}
+
+extern "C" pm_status pm_remove(pm_session *s, pm_scope scope,
+                               const char *entry) {
+  return guarded(s, [&] {
+    if (!validScope(scope) || !entry || !*entry)
+      return fail(s, PM_ERR_ARGUMENT, "An entry and a scope are required");
+    s->staged[scope].push_back({OpKind::Remove, entry, {}});
+    return PM_OK;
+  });
+}
+
+extern "C" pm_status pm_remove_invalid(pm_session *s, pm_scope scope,
+                                       size_t *count) {
+  return guarded(s, [&] {
+    if (!validScope(scope))
+      return fail(s, PM_ERR_ARGUMENT, "Unknown scope");
+    const PathTable &t = s->session.table();
+    std::unordered_set<uint64_t> keys;
+    size_t invalid = 0;
+    for (uint32_t i = t.begin(toScope(scope)); i < t.end(toScope(scope)); ++i)
+      if (!s->session.exists(i)) {
+        keys.insert(t.keyHash(i));
+        invalid++;
+      }
+    if (count)
+      *count = invalid;
+    if (keys.empty())
+      return PM_UNCHANGED;
+    s->staged[scope].push_back({OpKind::RemoveKeys, {}, std::move(keys)});
+    return PM_OK;
+  });
+}
+
+extern "C" void pm_discard(pm_session *s) {
+  if (!s)
+    return;
+  s->staged[0].clear();
+  s->staged[1].clear();
+}
+
+extern "C" pm_status pm_commit(pm_session *s) {
+  return guarded(s, [&] {
+    pm_status user = commitScope(s, Scope::User);
+    if (user < 0)
+      return user;
+    pm_status system = commitScope(s, Scope::System);
+    if (system < 0)
+      return system;
+    return user == PM_OK || system == PM_OK ? PM_OK : PM_UNCHANGED;
+  });
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Errors
+// ─────────────────────────────────────────────────────────────────────────────
+extern "C" const char *pm_last_error(const pm_session *s) {
+  return s ? s->error.c_str() : "No session";
+}
+
+extern "C" const char *pm_status_text(pm_status status) {
+  switch (status) {
+  case PM_OK: return "ok";
+  case PM_UNCHANGED: return "unchanged";
+  case PM_ERR_ARGUMENT: return "invalid argument";
+  case PM_ERR_STORE: return "store error";
+  case PM_ERR_CONFLICT: return "concurrent update conflict";
+  case PM_ERR_POLICY: return "refused by policy";
+  case PM_ERR_NOT_FOUND: return "not found";
+  case PM_ERR_RANGE: return "index out of range";
+  case PM_ERR_INTERNAL: return "internal error";
+  }
+  return "unknown status";
+}
@@ -0,0 +1,117 @@
+/*
+ * pathmgr: C interface to the PATH manager core, for installers and other
+ * programs that edit PATH-like variables without a console.
+ *
+ * Nothing here prints, prompts or starts a process. Decisions the CLI asks
+ * about are made by the PM_ALLOW_* flags passed to pm_open(), and every
+ * failure is a pm_status code with details in pm_last_error().
+ *
+ * A session reads a snapshot of both scopes, answers queries from it, and
+ * stages edits until pm_commit() writes each scope at once. A commit that
+ * races another writer is re-applied to the fresh value rather than
+ * overwriting it. Sessions are not thread-safe; use one per thread.
+ *
+ *   pm_session *s = pm_open(NULL, PM_ALLOW_MISSING);
+ *   pm_add(s, PM_USER, "C:\\Program Files\\Tool\\bin");
+ *   pm_remove(s, PM_USER, "C:\\Program Files\\Tool 1.0\\bin");
+ *   if (pm_commit(s) < 0)
+ *     log(pm_last_error(s));
+ *   pm_close(s);
+ */
+#ifndef PATHMGR_H
+#define PATHMGR_H
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#if defined(PATHMGR_BUILD)
+#define PM_API __declspec(dllexport)
+#else
+#define PM_API __declspec(dllimport)
+#endif
+#else
+#define PM_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct pm_session pm_session;
+
+/* Negative values are errors. */
+typedef enum pm_status {
+  PM_OK = 0,
+  PM_UNCHANGED = 1,       /* nothing to do, nothing written */
+  PM_ERR_ARGUMENT = -1,   /* null or malformed argument */
+  PM_ERR_STORE = -2,      /* the store could not be read or written */
+  PM_ERR_CONFLICT = -3,   /* other writers kept winning; nothing written */
+  PM_ERR_POLICY = -4,     /* refused by the session's flags */
+  PM_ERR_NOT_FOUND = -5,  /* no such entry */
+  PM_ERR_RANGE = -6,      /* index out of range */
+  PM_ERR_INTERNAL = -7    /* unexpected failure, e.g. out of memory */
+} pm_status;
+
+typedef enum pm_scope { PM_USER = 0, PM_SYSTEM = 1 } pm_scope;
+
+/* pm_open() flags */
+enum {
+  /* Stage entries that are not valid for the variable (for PATH, missing
+     directories) instead of refusing them. */
+  PM_ALLOW_MISSING = 1 << 0,
+  /* Let a commit grow a value past the configured length budget
+     (PATHMGR_PATH_BUDGET), up to the hard 32767-character limit. */
+  PM_ALLOW_OVER_BUDGET = 1 << 1,
+  /* Do not broadcast the change to running programs. */
+  PM_NO_NOTIFY = 1 << 2,
+  /* Do not record commits in the undo journal. */
+  PM_NO_JOURNAL = 1 << 3
+};
+
+/* Opens the default store (the registry on Windows, or $PATHMGR_STORE) and
+   loads `variable`, PATH if NULL. Returns NULL only when the session
+   cannot be created; a failed load is reported by pm_last_error(). */
+PM_API pm_session *pm_open(const char *variable, unsigned flags);
+/* Waits briefly for pending change broadcasts, then frees the session. */
+PM_API void pm_close(pm_session *s);
+
+/* Re-reads both scopes. Staged edits are kept. */
+PM_API pm_status pm_load(pm_session *s);
+
+/* Entries of `scope` in the snapshot. */
+PM_API size_t pm_count(pm_session *s, pm_scope scope);
+/* Entry `index` of `scope`. Any output may be NULL. The strings stay valid
+   until the next call on this session. */
+PM_API pm_status pm_entry(pm_session *s, pm_scope scope, size_t index,
+                          const char **raw, const char **expanded,
+                          int *exists);
+/* Looks `path` up in both scopes, comparing expanded paths the way
+   Windows does. On PM_OK, *scope and *index name the first match. */
+PM_API pm_status pm_find(pm_session *s, const char *path, pm_scope *scope,
+                         size_t *index);
+
+/* Stage edits for the next commit, applied in the order given. Adding an
+   entry that is already present changes nothing. */
+PM_API pm_status pm_add(pm_session *s, pm_scope scope, const char *entry);
+PM_API pm_status pm_remove(pm_session *s, pm_scope scope, const char *entry);
+/* Stages removal of the snapshot's invalid entries of `scope`; *count, if
+   given, receives how many there are. */
+PM_API pm_status pm_remove_invalid(pm_session *s, pm_scope scope,
+                                   size_t *count);
+/* Drops staged edits. */
+PM_API void pm_discard(pm_session *s);
+
+/* Applies staged edits with one write per scope, user first, and updates
+   the snapshot to match. Each scope's edits are cleared once it is settled;
+   after a store failure the remaining ones stay staged. */
+PM_API pm_status pm_commit(pm_session *s);
+
+/* Message for the last failure on this session; "" if none. */
+PM_API const char *pm_last_error(const pm_session *s);
+PM_API const char *pm_status_text(pm_status status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PATHMGR_H */
@@ -0,0 +1,141 @@
+#include "compact.h"
+#include "text.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace pathcore {
+
+const std::vector<std::string> &prefixVariables() {
+  static const std::vector<std::string> names = {
+      "LOCALAPPDATA",       "APPDATA",       "USERPROFILE",
+      "OneDrive",           "ProgramFiles",  "ProgramFiles(x86)",
+      "ProgramW6432",       "CommonProgramFiles",
+      "CommonProgramFiles(x86)",             "ProgramData",
+      "ALLUSERSPROFILE",    "PUBLIC",        "SystemRoot",
+      "windir",             "HOME",
+  };
+  return names;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  VariableTrie
+// ─────────────────────────────────────────────────────────────────────────────
+VariableTrie::VariableTrie() : nodes(1) {}
+
+namespace {
+
+bool absolute(std::string_view p) {
+  return (p.size() >= 3 && p[1] == ':' && (p[2] == '\\' || p[2] == '/')) ||
+         (!p.empty() && (p[0] == '/' || p[0] == '\\'));
+}
+
+} // namespace
+
+void VariableTrie::insert(const std::string &name, std::string_view value) {
+  if (!absolute(value))
+    return;
+  std::string key = canonicalKey(value);
+  uint32_t at = 0;
+  for (char c : key) {
+    auto &next = nodes[at].next;
+    auto it = std::find_if(next.begin(), next.end(),
+                           [&](const auto &edge) { return edge.first == c; });
+    if (it != next.end()) {
+      at = it->second;
+      continue;
+    }
+    uint32_t fresh = static_cast<uint32_t>(nodes.size());
+    next.emplace_back(c, fresh);
+    nodes.emplace_back();
+    at = fresh;
+  }
+
+  int32_t &slot = nodes[at].variable;
+  if (slot >= 0 && names[slot].size() <= name.size())
+    return;
+  if (slot < 0) {
+    slot = static_cast<int32_t>(names.size());
+    names.push_back(name);
+  } else {
+    names[slot] = name;
+  }
+}
+
+std::string VariableTrie::shorten(std::string_view path) const {
+  std::string key = canonicalKey(path);
+  size_t bestSaving = 0, bestLength = 0;
+  int32_t best = -1;
+
+  uint32_t at = 0;
+  for (size_t depth = 0;; ++depth) {
+    int32_t v = nodes[at].variable;
+    // Only whole components: C:\Program Files must not match the start of
+    // C:\Program Files (x86).
+    bool boundary = depth == key.size() || key[depth] == '\\' ||
+                    (depth > 0 && key[depth - 1] == '\\');
+    if (v >= 0 && boundary && depth > names[v].size() + 2 &&
+        depth - names[v].size() - 2 > bestSaving) {
+      bestSaving = depth - names[v].size() - 2;
+      bestLength = depth;
+      best = v;
+    }
+    if (depth == key.size())
+      break;
+    const auto &next = nodes[at].next;
+    auto it = std::find_if(next.begin(), next.end(), [&](const auto &edge) {
+      return edge.first == key[depth];
+    });
+    if (it == next.end())
+      break;
+    at = it->second;
+  }
+
+  if (best < 0)
+    return std::string(path);
+  return "%" + names[best] + "%" + std::string(path.substr(bestLength));
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  LengthBudget
+// ─────────────────────────────────────────────────────────────────────────────
+LengthBudget::LengthBudget(size_t limit) : cap(limit) {}
+
+size_t LengthBudget::configured() {
+  const char *env = std::getenv("PATHMGR_PATH_BUDGET");
+  if (env && *env) {
+    char *end = nullptr;
+    unsigned long long v = std::strtoull(env, &end, 10);
+    if (*end == '\0' && v > 0)
+      return static_cast<size_t>(v);
+  }
+  return MaxValue;
+}
+
+void LengthBudget::reset(size_t length, size_t entries) {
+  count = entries;
+  chars = entries ? length - (entries - 1) : 0;
+}
+
+void LengthBudget::reset(const std::vector<std::string> &entries) {
+  chars = 0;
+  for (const auto &e : entries)
+    chars += e.size();
+  count = entries.size();
+}
+
+void LengthBudget::add(std::string_view entry) {
+  chars += entry.size();
+  count++;
+}
+
+void LengthBudget::remove(std::string_view entry) {
+  chars -= entry.size();
+  count--;
+}
+
+void LengthBudget::replace(std::string_view from, std::string_view to) {
+  chars = chars - from.size() + to.size();
+}
+
+} // namespace pathcore
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pathcore {
+
+// Variables whose values make good entry prefixes (%USERPROFILE%,
+// %LOCALAPPDATA%, %ProgramFiles%, ...), longest-lived first.
+const std::vector<std::string> &prefixVariables();
+
+// Prefix trie over variable values, keyed like canonicalKey(), used to
+// rewrite absolute entries into their shortest `%VAR%\rest` spelling.
+class VariableTrie {
+public:
+  VariableTrie();
+
+  // Ignores values that are empty or not absolute paths. When several
+  // variables share a value the shortest name wins.
+  void insert(const std::string &name, std::string_view value);
+  size_t variables() const { return names.size(); }
+
+  // Shortest equivalent spelling of `path`: the longest-saving `%VAR%`
+  // prefix that ends on a separator, or `path` unchanged if none is shorter.
+  std::string shorten(std::string_view path) const;
+
+private:
+  struct Node {
+    std::vector<std::pair<char, uint32_t>> next;
+    int32_t variable = -1;
+  };
+  std::vector<Node> nodes;
+  std::vector<std::string> names;
+};
+
+// Running length of one list value, in characters, against a limit. It is
+// updated per entry added, removed or rewritten, so checks never rejoin the
+// list.
+class LengthBudget {
+public:
+  // Maximum length of an environment variable value.
+  static constexpr size_t MaxValue = 32767;
+
+  explicit LengthBudget(size_t limit = configured());
+  // PATHMGR_PATH_BUDGET if set, else MaxValue.
+  static size_t configured();
+
+  void reset(size_t length, size_t entries);
+  void reset(const std::vector<std::string> &entries);
+
+  size_t length() const { return count ? chars + count - 1 : 0; }
+  size_t limit() const { return cap; }
+  // Length after appending `entry`, and whether that stays within the limit.
+  size_t lengthWith(std::string_view entry) const {
+    return chars + entry.size() + count;
+  }
+  bool fits(std::string_view entry) const { return lengthWith(entry) <= cap; }
+
+  void add(std::string_view entry);
+  void remove(std::string_view entry);
+  void replace(std::string_view from, std::string_view to);
+
+private:
+  size_t cap;
+  size_t chars = 0; // entry characters, without separators
+  size_t count = 0;
+};
+
+} // namespace pathcore
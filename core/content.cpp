@@ -0,0 +1,579 @@
+#include "content.h"
+#include "cost.h"
+#include "text.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace pathcore {
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  fastHash
+// ─────────────────────────────────────────────────────────────────────────────
+namespace {
+
+constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t P3 = 0x165667B19E3779F9ull;
+constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t P5 = 0x27D4EB2F165667C5ull;
+
+uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+uint64_t read64(const unsigned char *p) {
+  uint64_t v;
+  std::memcpy(&v, p, 8);
+  return v;
+}
+
+uint32_t read32(const unsigned char *p) {
+  uint32_t v;
+  std::memcpy(&v, p, 4);
+  return v;
+}
+
+uint64_t mixRound(uint64_t acc, uint64_t input) {
+  acc += input * P2;
+  return rotl(acc, 31) * P1;
+}
+
+uint64_t merge(uint64_t acc, uint64_t val) {
+  acc ^= mixRound(0, val);
+  return acc * P1 + P4;
+}
+
+} // namespace
+
+uint64_t fastHash(const void *data, size_t size, uint64_t seed) {
+  const auto *p = static_cast<const unsigned char *>(data);
+  const unsigned char *end = p + size;
+  uint64_t h;
+
+  if (size >= 32) {
+    uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+    for (const unsigned char *limit = end - 32; p <= limit; p += 32) {
+      v1 = mixRound(v1, read64(p));
+      v2 = mixRound(v2, read64(p + 8));
+      v3 = mixRound(v3, read64(p + 16));
+      v4 = mixRound(v4, read64(p + 24));
+    }
+    h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    h = merge(merge(merge(merge(h, v1), v2), v3), v4);
+  } else {
+    h = seed + P5;
+  }
+  h += size;
+
+  for (; p + 8 <= end; p += 8)
+    h = rotl(h ^ mixRound(0, read64(p)), 27) * P1 + P4;
+  if (p + 4 <= end) {
+    h = rotl(h ^ (read32(p) * P1), 23) * P2 + P3;
+    p += 4;
+  }
+  for (; p < end; ++p)
+    h = rotl(h ^ (*p * P5), 11) * P1;
+
+  h ^= h >> 33;
+  h *= P2;
+  h ^= h >> 29;
+  h *= P3;
+  return h ^ (h >> 32);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  ContentHashCache
+// ─────────────────────────────────────────────────────────────────────────────
+// One line per file after a version line:
+//   <hash, 16 hex digits> <size> <mtime> <path>
+bool ContentHashCache::load(std::string &error) {
+  entries.clear();
+  std::ifstream in(file, std::ios::binary);
+  if (!in)
+    return true;
+  std::string line;
+  if (!std::getline(in, line) || line != "pathmgr-content 1") {
+    error = "Unrecognized hash cache " + file + "; it will be rebuilt";
+    return false;
+  }
+  while (std::getline(in, line)) {
+    uint64_t hash, size;
+    int64_t mtime;
+    int used = 0;
+    if (std::sscanf(line.c_str(), "%" SCNx64 " %" SCNu64 " %" SCNd64 " %n",
+                    &hash, &size, &mtime, &used) != 3 ||
+        used <= 0 || static_cast<size_t>(used) >= line.size())
+      continue;
+    entries[line.substr(static_cast<size_t>(used))] =
+        Entry{size, mtime, hash, false};
+  }
+  return true;
+}
+
+bool ContentHashCache::save(std::string &error) const {
+  std::error_code ec;
+  fs::create_directories(fs::path(file).parent_path(), ec);
+  std::string tmp = file + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out << "pathmgr-content 1\n";
+    char buf[64];
+    for (const auto &[path, e] : entries) {
+      if (!e.used)
+        continue;
+      std::snprintf(buf, sizeof(buf), "%016" PRIx64 " %" PRIu64 " %" PRId64 " ",
+                    e.hash, e.size, e.mtime);
+      out << buf << path << "\n";
+    }
+    out.flush();
+    if (!out) {
+      error = "Cannot write " + tmp;
+      return false;
+    }
+  }
+  fs::rename(tmp, file, ec);
+  if (ec) {
+    error = "Cannot replace " + file + ": " + ec.message();
+    fs::remove(tmp, ec);
+    return false;
+  }
+  return true;
+}
+
+bool ContentHashCache::lookup(const std::string &path, uint64_t size,
+                              int64_t mtime, uint64_t &hash) {
+  auto it = entries.find(path);
+  if (it == entries.end() || it->second.size != size ||
+      it->second.mtime != mtime)
+    return false;
+  it->second.used = true;
+  hash = it->second.hash;
+  return true;
+}
+
+void ContentHashCache::store(const std::string &path, uint64_t size,
+                             int64_t mtime, uint64_t hash) {
+  entries[path] = Entry{size, mtime, hash, true};
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  scanContent
+// ─────────────────────────────────────────────────────────────────────────────
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Files are hashed in chunks of this size, each a task of its own; a
+// multiple of the mapping granularity on every platform.
+constexpr uint64_t chunkSize = 16ull << 20;
+
+struct Listed {
+  std::string name;
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  uint64_t device = 0, inode = 0; // both zero if unknown
+};
+
+// Executables directly in `dir`, sorted by name: files with a PATHEXT
+// extension on Windows, files with an execute bit elsewhere.
+std::vector<Listed> listExecutables(const std::string &dir,
+                                    const std::vector<std::string> &exts) {
+  std::vector<Listed> out;
+  std::error_code ec;
+  for (fs::directory_iterator
+           entry(dir, fs::directory_options::skip_permission_denied, ec),
+       end;
+       !ec && entry != end; entry.increment(ec)) {
+    Listed l;
+    l.name = entry->path().filename().string();
+#ifdef _WIN32
+    std::error_code fileEc;
+    size_t dot = l.name.find_last_of('.');
+    if (dot == std::string::npos ||
+        std::none_of(exts.begin(), exts.end(), [&](const std::string &e) {
+          return iequals(std::string_view(l.name).substr(dot), e);
+        }))
+      continue;
+    if (!entry->is_regular_file(fileEc))
+      continue;
+    l.size = entry->file_size(fileEc);
+    l.mtime = static_cast<int64_t>(
+        entry->last_write_time(fileEc).time_since_epoch().count());
+    if (fileEc)
+      continue;
+#else
+    (void)exts;
+    struct stat st;
+    if (::stat(entry->path().c_str(), &st) != 0 || !S_ISREG(st.st_mode) ||
+        !(st.st_mode & 0111))
+      continue;
+    l.size = static_cast<uint64_t>(st.st_size);
+#ifdef __APPLE__
+    l.mtime = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 +
+              st.st_mtimespec.tv_nsec;
+#else
+    l.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+              st.st_mtim.tv_nsec;
+#endif
+    l.device = static_cast<uint64_t>(st.st_dev);
+    l.inode = static_cast<uint64_t>(st.st_ino);
+#endif
+    out.push_back(std::move(l));
+  }
+  std::sort(out.begin(), out.end(),
+            [](const Listed &a, const Listed &b) { return a.name < b.name; });
+  return out;
+}
+
+// Reads `length` bytes at `offset` without mapping, for files that cannot
+// be mapped (some network shares, special files).
+bool readChunk(const std::string &path, uint64_t offset, uint64_t length,
+               uint64_t seed, uint64_t &hash) {
+  std::ifstream in(path, std::ios::binary);
+  std::vector<char> buf(static_cast<size_t>(length));
+  if (!in.seekg(static_cast<std::streamoff>(offset)) ||
+      !in.read(buf.data(), static_cast<std::streamsize>(length)))
+    return false;
+  hash = fastHash(buf.data(), buf.size(), seed);
+  return true;
+}
+
+// Hashes one chunk of a file expected to be `size` bytes long. A file
+// that changed size since it was listed fails rather than being read past
+// its end.
+bool hashChunk(const std::string &path, uint64_t size, uint64_t offset,
+               uint64_t length, uint64_t seed, uint64_t &hash) {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE |
+                                FILE_SHARE_DELETE,
+                            nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER actual;
+  if (!GetFileSizeEx(file, &actual) ||
+      static_cast<uint64_t>(actual.QuadPart) != size) {
+    CloseHandle(file);
+    return false;
+  }
+  bool ok = false;
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping) {
+    const void *view =
+        MapViewOfFile(mapping, FILE_MAP_READ, static_cast<DWORD>(offset >> 32),
+                      static_cast<DWORD>(offset), static_cast<SIZE_T>(length));
+    if (view) {
+      hash = fastHash(view, static_cast<size_t>(length), seed);
+      UnmapViewOfFile(view);
+      ok = true;
+    }
+    CloseHandle(mapping);
+  }
+  CloseHandle(file);
+  return ok || readChunk(path, offset, length, seed, hash);
+#else
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) != size) {
+    ::close(fd);
+    return false;
+  }
+  void *view = ::mmap(nullptr, static_cast<size_t>(length), PROT_READ,
+                      MAP_PRIVATE, fd, static_cast<off_t>(offset));
+  ::close(fd);
+  if (view == MAP_FAILED)
+    return readChunk(path, offset, length, seed, hash);
+  ::madvise(view, static_cast<size_t>(length), MADV_SEQUENTIAL);
+  hash = fastHash(view, static_cast<size_t>(length), seed);
+  ::munmap(view, static_cast<size_t>(length));
+  return true;
+#endif
+}
+
+// One deque of tasks per worker. A worker takes from the back of its own
+// and, once that is empty, steals from the front of the others', so
+// workers that drew small files help those that drew large ones.
+class StealingQueues {
+public:
+  explicit StealingQueues(unsigned workers) : queues(workers) {}
+
+  void push(unsigned worker, uint32_t task) {
+    queues[worker].tasks.push_back(task);
+  }
+
+  bool pop(unsigned self, uint32_t &task) {
+    for (size_t k = 0; k < queues.size(); ++k) {
+      Queue &q = queues[(self + k) % queues.size()];
+      std::lock_guard<std::mutex> lock(q.mu);
+      if (q.tasks.empty())
+        continue;
+      if (k == 0) {
+        task = q.tasks.back();
+        q.tasks.pop_back();
+      } else {
+        task = q.tasks.front();
+        q.tasks.pop_front();
+      }
+      return true;
+    }
+    return false;
+  }
+
+private:
+  struct Queue {
+    std::mutex mu;
+    std::deque<uint32_t> tasks;
+  };
+  std::vector<Queue> queues;
+};
+
+std::string filePath(const ContentReport &r, const ContentFile &f) {
+  return (fs::path(r.directories[f.dir]) / f.name).string();
+}
+
+} // namespace
+
+ContentReport scanContent(const std::vector<std::string> &directories,
+                          const ContentScanOptions &options) {
+  auto start = Clock::now();
+  ContentReport r;
+  r.directories = directories;
+  unsigned threads = std::max(1u, options.threads);
+
+  // List every directory on the pool
+  std::vector<std::vector<Listed>> listed(directories.size());
+  {
+    std::vector<std::string> exts = lookupExtensions();
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+      for (size_t k; (k = next.fetch_add(1)) < directories.size();)
+        listed[k] = listExecutables(directories[k], exts);
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < std::min<size_t>(threads, directories.size()); ++t)
+      pool.emplace_back(work);
+    work();
+    for (auto &t : pool)
+      t.join();
+  }
+
+  // Only sizes that repeat can have copies; the same file reached twice is
+  // hashed through its first path only.
+  std::unordered_map<uint64_t, uint32_t> sizeCount;
+  std::vector<uint32_t> alias; // file -> file whose hash it shares
+  std::unordered_map<uint64_t, uint32_t> firstById;
+  for (uint32_t d = 0; d < listed.size(); ++d) {
+    for (auto &l : listed[d]) {
+      uint32_t i = static_cast<uint32_t>(r.files.size());
+      uint32_t primary = i;
+      if (l.inode) {
+        uint64_t id = l.device * 0x9e3779b97f4a7c15ull ^ l.inode;
+        primary = firstById.emplace(id, i).first->second;
+      }
+      alias.push_back(primary);
+      if (l.size)
+        sizeCount[l.size]++;
+      r.files.push_back(ContentFile{d, std::move(l.name), l.size, l.mtime, 0,
+                                    false});
+    }
+  }
+
+  std::vector<uint32_t> pending; // primaries to read, by file index
+  for (uint32_t i = 0; i < r.files.size(); ++i) {
+    ContentFile &f = r.files[i];
+    if (!f.size || sizeCount[f.size] < 2)
+      continue;
+    r.candidates++;
+    if (alias[i] != i)
+      continue;
+    if (options.cache &&
+        options.cache->lookup(filePath(r, f), f.size, f.mtime, f.hash)) {
+      f.hashed = true;
+      r.cached++;
+    } else {
+      pending.push_back(i);
+    }
+  }
+
+  // Split pending files into chunks and deal them out smallest first, so
+  // each worker starts on its largest.
+  struct Chunk {
+    uint32_t file;
+    uint32_t index;
+    uint8_t state = 0; // 0 not reached, 1 hashed, 2 failed
+    uint64_t hash = 0;
+  };
+  std::vector<Chunk> chunks;
+  std::vector<size_t> firstChunk(pending.size() + 1, 0);
+  std::vector<std::string> paths(pending.size());
+  for (size_t p = 0; p < pending.size(); ++p) {
+    const ContentFile &f = r.files[pending[p]];
+    paths[p] = filePath(r, f);
+    firstChunk[p] = chunks.size();
+    for (uint64_t off = 0; off < f.size; off += chunkSize)
+      chunks.push_back(Chunk{static_cast<uint32_t>(p),
+                             static_cast<uint32_t>(off / chunkSize)});
+  }
+  firstChunk[pending.size()] = chunks.size();
+
+  auto length = [&](const Chunk &c) {
+    uint64_t size = r.files[pending[c.file]].size;
+    return std::min(chunkSize, size - uint64_t(c.index) * chunkSize);
+  };
+  std::vector<uint32_t> order(chunks.size());
+  for (uint32_t k = 0; k < order.size(); ++k)
+    order[k] = k;
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return length(chunks[a]) < length(chunks[b]);
+  });
+  unsigned workers = static_cast<unsigned>(
+      std::max<size_t>(1, std::min<size_t>(threads, chunks.size())));
+  StealingQueues queues(workers);
+  for (uint32_t k = 0; k < order.size(); ++k)
+    queues.push(k % workers, order[k]);
+
+  bool limited = options.timeLimit.count() > 0;
+  auto deadline = start + options.timeLimit;
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<bool> expired{false};
+  auto work = [&](unsigned self) {
+    uint32_t k;
+    while (!expired && queues.pop(self, k)) {
+      if (limited && Clock::now() >= deadline) {
+        expired = true;
+        break;
+      }
+      Chunk &c = chunks[k];
+      uint64_t len = length(c);
+      c.state = hashChunk(paths[c.file], r.files[pending[c.file]].size,
+                          uint64_t(c.index) * chunkSize, len, c.index, c.hash)
+                    ? 1
+                    : 2;
+      if (c.state == 1)
+        bytes += len;
+    }
+  };
+  {
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < workers; ++t)
+      pool.emplace_back(work, t);
+    work(0);
+    for (auto &t : pool)
+      t.join();
+  }
+  r.bytesRead = bytes;
+  r.complete = !expired;
+
+  // A file's hash combines its chunk hashes in order, so it does not depend
+  // on which worker read what.
+  for (size_t p = 0; p < pending.size(); ++p) {
+    ContentFile &f = r.files[pending[p]];
+    std::vector<uint64_t> parts;
+    bool ok = true;
+    for (size_t k = firstChunk[p]; k < firstChunk[p + 1]; ++k) {
+      ok &= chunks[k].state == 1;
+      parts.push_back(chunks[k].hash);
+    }
+    if (!ok) {
+      r.skipped++;
+      continue;
+    }
+    f.hash = fastHash(parts.data(), parts.size() * sizeof(uint64_t), f.size);
+    f.hashed = true;
+    r.hashed++;
+    if (options.cache)
+      options.cache->store(paths[p], f.size, f.mtime, f.hash);
+  }
+  for (uint32_t i = 0; i < r.files.size(); ++i) {
+    if (alias[i] == i || !r.files[alias[i]].hashed ||
+        sizeCount[r.files[i].size] < 2)
+      continue;
+    r.files[i].hash = r.files[alias[i]].hash;
+    r.files[i].hashed = true;
+  }
+
+  // Identical binaries, by size and hash, across two or more directories
+  std::unordered_map<uint64_t, std::vector<uint32_t>> byContent;
+  for (uint32_t i = 0; i < r.files.size(); ++i)
+    if (r.files[i].hashed)
+      byContent[r.files[i].hash ^ r.files[i].size * P1].push_back(i);
+  for (auto &[key, members] : byContent) {
+    (void)key;
+    bool spread = std::any_of(members.begin(), members.end(), [&](uint32_t i) {
+      return r.files[i].dir != r.files[members[0]].dir;
+    });
+    if (spread)
+      r.groups.push_back(std::move(members));
+  }
+  auto wasted = [&](const std::vector<uint32_t> &g) {
+    return r.files[g[0]].size * (g.size() - 1);
+  };
+  std::sort(r.groups.begin(), r.groups.end(),
+            [&](const auto &a, const auto &b) {
+              return wasted(a) != wasted(b) ? wasted(a) > wasted(b)
+                                            : a[0] < b[0];
+            });
+
+  // Identical directories: every executable hashed, and the same names
+  // with the same contents. Files are listed sorted, so a running hash of
+  // (name, content) pairs is a signature.
+  std::unordered_map<uint64_t, std::vector<uint32_t>> bySignature;
+  std::vector<uint64_t> signatures;
+  {
+    std::vector<uint64_t> signature(directories.size(), 0);
+    std::vector<uint8_t> usable(directories.size(), 0);
+    for (uint32_t d = 0; d < directories.size(); ++d)
+      usable[d] = !listed[d].empty();
+    for (const ContentFile &f : r.files) {
+      if (!f.hashed) {
+        usable[f.dir] = 0;
+        continue;
+      }
+#ifdef _WIN32
+      std::string name = toLower(f.name);
+#else
+      const std::string &name = f.name;
+#endif
+      uint64_t pair[2] = {fastHash(name.data(), name.size()), f.hash};
+      signature[f.dir] = fastHash(pair, sizeof(pair), signature[f.dir]);
+    }
+    for (uint32_t d = 0; d < directories.size(); ++d) {
+      if (!usable[d])
+        continue;
+      auto &members = bySignature[signature[d]];
+      members.push_back(d);
+      if (members.size() == 2)
+        signatures.push_back(signature[d]);
+    }
+  }
+  for (uint64_t s : signatures)
+    r.sameDirectories.push_back(std::move(bySignature[s]));
+  return r;
+}
+
+} // namespace pathcore
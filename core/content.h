@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pathcore {
+
+// 64-bit non-cryptographic hash of a byte range (xxHash64). Fast enough
+// that reading the file, not hashing it, is the cost.
+uint64_t fastHash(const void *data, size_t size, uint64_t seed = 0);
+
+// Content hashes of files by path, trusted while the file's size and
+// modification time are unchanged. Kept in a small text file, so a rescan
+// of an unchanged toolchain reads no file contents at all.
+class ContentHashCache {
+public:
+  explicit ContentHashCache(std::string file) : file(std::move(file)) {}
+
+  // A missing file is an empty cache, not an error.
+  bool load(std::string &error);
+  // Writes the entries looked up or stored since load(); files that left
+  // the scanned directories drop out.
+  bool save(std::string &error) const;
+
+  bool lookup(const std::string &path, uint64_t size, int64_t mtime,
+              uint64_t &hash);
+  void store(const std::string &path, uint64_t size, int64_t mtime,
+             uint64_t hash);
+
+  const std::string &path() const { return file; }
+
+private:
+  struct Entry {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    uint64_t hash = 0;
+    bool used = false;
+  };
+  std::string file;
+  std::unordered_map<std::string, Entry> entries;
+};
+
+struct ContentFile {
+  uint32_t dir = 0; // index into ContentReport::directories
+  std::string name;
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  uint64_t hash = 0;
+  bool hashed = false; // false for unique sizes and files not reached
+};
+
+struct ContentScanOptions {
+  unsigned threads = 1;
+  // Files not hashed by then are reported as skipped; zero means no limit.
+  std::chrono::milliseconds timeLimit{0};
+  ContentHashCache *cache = nullptr;
+};
+
+struct ContentReport {
+  std::vector<std::string> directories;
+  std::vector<ContentFile> files; // executables of every directory
+  // Files with identical content in two or more directories, as indexes
+  // into `files`, largest first.
+  std::vector<std::vector<uint32_t>> groups;
+  // Directories whose executables are all identical, by name and content.
+  std::vector<std::vector<uint32_t>> sameDirectories;
+
+  size_t candidates = 0; // files sharing their size with another
+  size_t hashed = 0;     // read and hashed by this scan
+  size_t cached = 0;     // hash reused from the cache
+  size_t skipped = 0;    // unreadable, or left when the time limit hit
+  uint64_t bytesRead = 0;
+  bool complete = true;
+};
+
+// Lists the executables of each directory (not subdirectories) and finds
+// identical copies. Sizes are compared first; only files whose size
+// repeats are read, memory-mapped in chunks on a work-stealing pool so one
+// large binary does not hold up the others. The same file reached twice
+// (hard links, symlinked files) is read once.
+ContentReport scanContent(const std::vector<std::string> &directories,
+                          const ContentScanOptions &options);
+
+} // namespace pathcore
@@ -0,0 +1,298 @@
+#include "cost.h"
+#include "text.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace pathcore {
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Workload
+// ─────────────────────────────────────────────────────────────────────────────
+void Workload::add(const std::string &name, double count) {
+  for (size_t i = 0; i < names.size(); ++i) {
+    if (iequals(names[i], name)) {
+      counts[i] += count;
+      return;
+    }
+  }
+  names.push_back(name);
+  counts.push_back(count);
+}
+
+double Workload::launches() const {
+  double total = 0;
+  for (double c : counts)
+    total += c;
+  return total;
+}
+
+namespace {
+
+// Program name from the start of a command line: quoted or up to the first
+// blank, without its directory.
+std::string programName(const std::string &line) {
+  std::string token;
+  if (line[0] == '"') {
+    size_t close = line.find('"', 1);
+    token = line.substr(1, close == std::string::npos ? std::string::npos
+                                                      : close - 1);
+  } else {
+    token = line.substr(0, line.find_first_of(" \t"));
+  }
+  size_t slash = token.find_last_of("\\/");
+  return slash == std::string::npos ? token : token.substr(slash + 1);
+}
+
+std::string fold(std::string s) {
+#ifdef _WIN32
+  return toLower(s);
+#else
+  return s;
+#endif
+}
+
+} // namespace
+
+bool loadWorkload(const std::string &file, Workload &out, std::string &error) {
+  std::ifstream in(file);
+  if (!in) {
+    error = "Cannot open workload file: " + file;
+    return false;
+  }
+
+  // Counts are merged through a map; Workload::add is linear per name.
+  std::unordered_map<std::string, size_t> slot;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line[start] == '#')
+      continue;
+    line.erase(0, start);
+
+    // Only a tab-separated trailing number is a count, so a captured
+    // `sleep 5` stays one launch of sleep.
+    double count = 1;
+    size_t tab = line.rfind('\t');
+    if (tab != std::string::npos) {
+      const char *field = line.c_str() + tab + 1;
+      char *end = nullptr;
+      double parsed = std::strtod(field, &end);
+      while (end != field && *end == ' ')
+        ++end;
+      if (end != field && *end == '\0' && parsed > 0) {
+        count = parsed;
+        line.erase(tab);
+      }
+    }
+    std::string name = programName(line);
+    if (name.empty())
+      continue;
+
+    auto [it, fresh] = slot.emplace(toLower(name), out.names.size());
+    if (fresh) {
+      out.names.push_back(name);
+      out.counts.push_back(count);
+    } else {
+      out.counts[it->second] += count;
+    }
+  }
+  if (out.names.empty()) {
+    error = "Workload file lists no commands: " + file;
+    return false;
+  }
+  return true;
+}
+
+Workload defaultWorkload() {
+  Workload w;
+  for (const char *name : {"git", "python", "node", "cmd", "powershell",
+                           "where", "code", "cargo", "make", "ssh"})
+    w.add(name, 1);
+  return w;
+}
+
+std::vector<std::string> lookupExtensions() {
+  const char *env = std::getenv("PATHEXT");
+#ifdef _WIN32
+  std::string value =
+      env ? env : ".COM;.EXE;.BAT;.CMD;.VBS;.VBE;.JS;.JSE;.WSF;.WSH;.MSC";
+#else
+  std::string value = env ? env : "";
+#endif
+  return splitPath(value);
+}
+
+std::vector<uint32_t> searchOrder(const PathTable &table) {
+  std::vector<uint32_t> order;
+  order.reserve(table.size());
+  for (Scope scope : {Scope::System, Scope::User})
+    for (uint32_t i = table.begin(scope); i < table.end(scope); ++i)
+      order.push_back(i);
+  return order;
+}
+
+std::vector<std::string> listFiles(const std::string &dir) {
+  std::vector<std::string> files;
+  std::error_code ec;
+  for (fs::directory_iterator
+           entry(dir, fs::directory_options::skip_permission_denied, ec),
+       end;
+       !ec && entry != end; entry.increment(ec)) {
+    std::error_code typeEc;
+    if (!entry->is_directory(typeEc))
+      files.push_back(fold(entry->path().filename().string()));
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+std::vector<std::string> lookupNames(const std::string &name,
+                                     const std::vector<std::string> &exts) {
+  // A name that already carries a known extension is tried as-is.
+  size_t dot = name.find_last_of('.');
+  if (exts.empty() || (dot != std::string::npos &&
+                       std::any_of(exts.begin(), exts.end(), [&](const auto &e) {
+                         return iequals(name.substr(dot), e);
+                       })))
+    return {fold(name)};
+
+  std::vector<std::string> out;
+  out.reserve(exts.size());
+  for (const auto &ext : exts)
+    out.push_back(fold(name + ext));
+  return out;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  LookupProfiler
+// ─────────────────────────────────────────────────────────────────────────────
+LookupProfiler::LookupProfiler(const PathTable &table,
+                               std::vector<std::string> extensions,
+                               const std::vector<uint64_t> *keys)
+    : exts(std::move(extensions)) {
+  // Entries that name the same directory share one listing.
+  std::unordered_map<uint64_t, uint32_t> byKey;
+  dirOf.resize(table.size());
+  for (uint32_t i = 0; i < table.size(); ++i) {
+    auto [it, fresh] = byKey.emplace(keys ? (*keys)[i] : table.keyHash(i),
+                                     static_cast<uint32_t>(dirs.size()));
+    dirOf[i] = it->second;
+    if (!fresh)
+      continue;
+
+    Directory dir;
+    dir.path = std::string(table.expanded(i));
+    dir.files = listFiles(dir.path);
+    dirs.push_back(std::move(dir));
+  }
+}
+
+void LookupProfiler::measure(int samples) {
+  using Clock = std::chrono::steady_clock;
+  std::vector<double> times(static_cast<size_t>(std::max(samples, 1)));
+  for (auto &dir : dirs) {
+    for (size_t k = 0; k < times.size(); ++k) {
+      fs::path probe =
+          fs::path(dir.path) / (".pathmgr-probe-" + std::to_string(k) + ".exe");
+      std::error_code ec;
+      auto start = Clock::now();
+      (void)fs::status(probe, ec);
+      times[k] =
+          std::chrono::duration<double, std::micro>(Clock::now() - start)
+              .count();
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2,
+                     times.end());
+    dir.probeMicros = times[times.size() / 2];
+  }
+}
+
+bool LookupProfiler::contains(const Directory &dir,
+                              const std::string &file) const {
+  return std::binary_search(dir.files.begin(), dir.files.end(), file);
+}
+
+std::string LookupProfiler::launchName(const std::string &file) const {
+  size_t dot = file.find_last_of('.');
+  if (dot != std::string::npos)
+    for (const auto &ext : exts)
+      if (iequals(std::string_view(file).substr(dot), ext))
+        return file.substr(0, dot);
+  return file;
+}
+
+LookupCost LookupProfiler::resolve(const std::string &name,
+                                   const std::vector<uint32_t> &order) const {
+  LookupCost cost;
+  std::vector<std::string> files = candidates(name);
+  for (uint32_t i : order) {
+    const Directory &dir = dirs[dirOf[i]];
+    for (const auto &file : files) {
+      cost.probes++;
+      cost.micros += dir.probeMicros;
+      if (contains(dir, file)) {
+        cost.resolvedAt = i;
+        cost.file = file;
+        return cost;
+      }
+    }
+  }
+  return cost;
+}
+
+CostReport LookupProfiler::profile(const Workload &workload,
+                                   const std::vector<uint32_t> &order) const {
+  CostReport report;
+  report.entries.resize(order.size());
+  std::vector<size_t> position(dirOf.size());
+  for (size_t k = 0; k < order.size(); ++k) {
+    report.entries[k].entry = order[k];
+    report.entries[k].probeMicros = dirs[dirOf[order[k]]].probeMicros;
+    position[order[k]] = k;
+  }
+
+  size_t n = workload.names.size();
+  report.lookups.reserve(n);
+  for (size_t w = 0; w < n; ++w) {
+    double count = workload.counts[w];
+    LookupCost cost = resolve(workload.names[w], order);
+
+    // Charge each directory passed over for every candidate, and the
+    // resolving one for the misses before its hit.
+    size_t stop = cost.resolvedAt < 0
+                      ? order.size()
+                      : position[static_cast<size_t>(cost.resolvedAt)];
+    size_t perDir = candidates(workload.names[w]).size();
+    for (size_t k = 0; k < stop; ++k)
+      report.entries[k].missProbes += count * perDir;
+    if (cost.resolvedAt >= 0) {
+      size_t before = cost.probes - stop * perDir;
+      report.entries[stop].missProbes += count * (before - 1);
+      report.entries[stop].hits += count;
+    }
+
+    report.launches += count;
+    report.probesPerLaunch += count * cost.probes;
+    report.microsPerLaunch += count * cost.micros;
+    report.lookups.push_back(std::move(cost));
+  }
+
+  for (auto &e : report.entries)
+    e.micros = (e.missProbes + e.hits) * e.probeMicros;
+  if (report.launches > 0) {
+    report.probesPerLaunch /= report.launches;
+    report.microsPerLaunch /= report.launches;
+  }
+  return report;
+}
+
+} // namespace pathcore
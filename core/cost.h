@@ -0,0 +1,119 @@
+#pragma once
+
+#include "table.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pathcore {
+
+// Command names and how many launches each accounts for.
+struct Workload {
+  std::vector<std::string> names;
+  std::vector<double> counts;
+
+  void add(const std::string &name, double count);
+  double launches() const;
+};
+
+// Reads a workload file. A line is either `<name><TAB><count>` or a
+// captured command line, which counts as one launch; either way only the
+// program's base name is kept. Blank lines and `#` comments are skipped.
+bool loadWorkload(const std::string &file, Workload &out, std::string &error);
+// A handful of common tools, one launch each, for when no file is given.
+Workload defaultWorkload();
+
+// Extensions tried for a bare command name, from PATHEXT. Outside Windows
+// an unset PATHEXT means names are looked up as-is.
+std::vector<std::string> lookupExtensions();
+
+// Order a launched process searches the table in: the process PATH is the
+// system value followed by the user value.
+std::vector<uint32_t> searchOrder(const PathTable &table);
+
+// File names in `dir` (not subdirectories), sorted and, on Windows,
+// case-folded. Empty if it cannot be listed.
+std::vector<std::string> listFiles(const std::string &dir);
+// File names a lookup of `name` tries in each directory, in order, folded
+// like listFiles(): the name as-is if it already carries one of `exts`,
+// else the name with each extension appended.
+std::vector<std::string> lookupNames(const std::string &name,
+                                     const std::vector<std::string> &exts);
+
+struct EntryCost {
+  uint32_t entry = 0;
+  double missProbes = 0;  // probes that found nothing here, summed over launches
+  double hits = 0;        // launches resolved here
+  double probeMicros = 0; // measured cost of one probe in this directory
+  double micros = 0;      // (missProbes + hits) * probeMicros
+};
+
+struct LookupCost {
+  uint32_t probes = 0;     // per launch
+  double micros = 0;       // per launch
+  int64_t resolvedAt = -1; // table index, or -1 if not found anywhere
+  std::string file;        // name that matched
+};
+
+struct CostReport {
+  std::vector<EntryCost> entries;  // in search order
+  std::vector<LookupCost> lookups; // parallel to the workload
+  double launches = 0;
+  double probesPerLaunch = 0;
+  double microsPerLaunch = 0;
+};
+
+// Simulates the PATH search a process launch performs: each directory in
+// order, each PATHEXT extension within it, until a file matches. Every
+// distinct directory is listed once up front, so the simulation itself
+// never touches the disk; measure() then times real probes per directory
+// to turn probe counts into latency.
+class LookupProfiler {
+public:
+  // Entries with equal `keys` (one per table entry, e.g.
+  // Session::identityKeys()) share a directory; by default those with
+  // equal keyHash do.
+  LookupProfiler(const PathTable &table, std::vector<std::string> extensions,
+                 const std::vector<uint64_t> *keys = nullptr);
+
+  // Times `samples` lookups of a missing file in each distinct directory
+  // and keeps the median.
+  void measure(int samples = 5);
+
+  // Costs `workload` against the table searched in `order`.
+  CostReport profile(const Workload &workload,
+                     const std::vector<uint32_t> &order) const;
+  // Where `name` resolves when the table is searched in `order`.
+  LookupCost resolve(const std::string &name,
+                     const std::vector<uint32_t> &order) const;
+
+  const std::vector<std::string> &extensions() const { return exts; }
+  // Directory entry `i` reaches; equal for entries that share one.
+  uint32_t directory(uint32_t i) const { return dirOf[i]; }
+  // Listing of entry `i`'s directory: sorted, case-folded on Windows.
+  const std::vector<std::string> &files(uint32_t i) const {
+    return dirs[dirOf[i]].files;
+  }
+  // Name `file` is launched by: its stem if it carries a PATHEXT
+  // extension, else the whole name.
+  std::string launchName(const std::string &file) const;
+
+private:
+  struct Directory {
+    std::string path;
+    std::vector<std::string> files; // sorted, case-folded on Windows
+    double probeMicros = 0;
+  };
+
+  bool contains(const Directory &dir, const std::string &file) const;
+  std::vector<std::string> candidates(const std::string &name) const {
+    return lookupNames(name, exts);
+  }
+
+  std::vector<std::string> exts;
+  std::vector<uint32_t> dirOf; // table index -> directory
+  std::vector<Directory> dirs;
+};
+
+} // namespace pathcore
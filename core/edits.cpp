@@ -0,0 +1,153 @@
+#include "edits.h"
+#include "compact.h"
+#include "text.h"
+
+#include <algorithm>
+
+namespace pathcore {
+
+Edit addEntry(Session &session, std::string entry, size_t budget,
+              EditOutcome &outcome) {
+  return [&session, entry = std::move(entry), budget,
+          &outcome](std::vector<std::string> &entries) {
+    outcome = EditOutcome{};
+    std::string expanded = session.expand(entry);
+    for (const auto &e : entries)
+      if (iequals(session.expand(e), expanded)) {
+        outcome.present = true;
+        return EditResult::Unchanged;
+      }
+    LengthBudget length(budget);
+    length.reset(entries);
+    outcome.length = length.lengthWith(entry);
+    if (!length.fits(entry)) {
+      outcome.overBudget = true;
+      return EditResult::Unchanged;
+    }
+    entries.push_back(entry);
+    return EditResult::Changed;
+  };
+}
+
+Edit removeEntry(Session &session, std::string entry, EditOutcome &outcome) {
+  std::string expanded = session.expand(entry);
+  uint64_t target = session.identityCache().key(expanded);
+  return [&session, expanded = std::move(expanded), target,
+          &outcome](std::vector<std::string> &entries) {
+    size_t before = entries.size();
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [&](const std::string &e) {
+                                   std::string path = session.expand(e);
+                                   return iequals(path, expanded) ||
+                                          session.identityCache().key(path) ==
+                                              target;
+                                 }),
+                  entries.end());
+    outcome = EditOutcome{};
+    outcome.removed = before - entries.size();
+    return outcome.removed ? EditResult::Changed : EditResult::Unchanged;
+  };
+}
+
+Edit removeKeys(Session &session, std::unordered_set<uint64_t> keys,
+                EditOutcome &outcome) {
+  return [&session, keys = std::move(keys),
+          &outcome](std::vector<std::string> &entries) {
+    size_t before = entries.size();
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [&](const std::string &e) {
+                                   return keys.count(
+                                       canonicalHash(session.expand(e)));
+                                 }),
+                  entries.end());
+    outcome = EditOutcome{};
+    outcome.removed = before - entries.size();
+    return outcome.removed ? EditResult::Changed : EditResult::Unchanged;
+  };
+}
+
+std::vector<uint32_t> duplicateEntries(const PathTable &table,
+                                       const std::vector<uint64_t> &keys,
+                                       DedupePolicy policy) {
+  Scope preferred =
+      policy == DedupePolicy::PreferUser ? Scope::User : Scope::System;
+  Scope other = preferred == Scope::User ? Scope::System : Scope::User;
+
+  std::unordered_set<uint64_t> seen[2]; // keys met so far, per scope
+  std::vector<uint32_t> drop;
+  for (Scope scope : {preferred, other}) {
+    auto &mine = seen[static_cast<int>(scope)];
+    mine.reserve(table.count(scope));
+    for (uint32_t i = table.begin(scope); i < table.end(scope); ++i) {
+      if (!mine.insert(keys[i]).second ||
+          (scope == other && policy != DedupePolicy::KeepBoth &&
+           seen[static_cast<int>(preferred)].count(keys[i])))
+        drop.push_back(i);
+    }
+  }
+  std::sort(drop.begin(), drop.end());
+  return drop;
+}
+
+Edit dedupeEntries(Session &session, std::unordered_set<uint64_t> elsewhere,
+                   EditOutcome &outcome) {
+  return [&session, elsewhere = std::move(elsewhere),
+          &outcome](std::vector<std::string> &entries) {
+    std::unordered_set<uint64_t> seen;
+    seen.reserve(entries.size());
+    size_t kept = 0;
+    for (size_t k = 0; k < entries.size(); ++k) {
+      uint64_t key = session.identityCache().key(session.expand(entries[k]));
+      if (elsewhere.count(key) || !seen.insert(key).second)
+        continue;
+      if (kept != k)
+        entries[kept] = std::move(entries[k]);
+      kept++;
+    }
+    outcome = EditOutcome{};
+    outcome.removed = entries.size() - kept;
+    entries.resize(kept);
+    return outcome.removed ? EditResult::Changed : EditResult::Unchanged;
+  };
+}
+
+Edit selectEntries(Session &session, const EntryMatcher &matcher,
+                   Selection action, EditOutcome &outcome) {
+  return [&session, &matcher, action,
+          &outcome](std::vector<std::string> &entries) {
+    std::vector<std::string> selected, rest;
+    for (const auto &e : entries)
+      (matcher.matches(e, session.expand(e)) ? selected : rest).push_back(e);
+    outcome = EditOutcome{};
+    outcome.matched = selected.size();
+    // A retry after a concurrent write may match nothing; keeping nothing
+    // would write an empty value.
+    if (action == Selection::Keep && selected.empty())
+      return EditResult::Abort;
+
+    std::vector<std::string> before = std::move(entries);
+    switch (action) {
+    case Selection::Remove:
+      entries = std::move(rest);
+      outcome.removed = selected.size();
+      break;
+    case Selection::Keep:
+      entries = std::move(selected);
+      outcome.removed = rest.size();
+      break;
+    case Selection::MoveFront:
+      entries = std::move(selected);
+      entries.insert(entries.end(), std::make_move_iterator(rest.begin()),
+                     std::make_move_iterator(rest.end()));
+      break;
+    case Selection::MoveBack:
+      entries = std::move(rest);
+      entries.insert(entries.end(), std::make_move_iterator(selected.begin()),
+                     std::make_move_iterator(selected.end()));
+      break;
+    }
+    return entries != before ? EditResult::Changed : EditResult::Unchanged;
+  };
+}
+
+} // namespace pathcore
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "match.h"
+#include "session.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace pathcore {
+
+// Why an edit from this file changed nothing, or how much it did.
+struct EditOutcome {
+  bool present = false;    // addEntry: already in the list
+  bool overBudget = false; // addEntry: would exceed the length budget
+  size_t length = 0;       // addEntry: value length with the entry added
+  size_t removed = 0;      // removeEntry / removeKeys / dedupeEntries
+  size_t matched = 0;      // selectEntries
+};
+
+// Which copy survives when both scopes hold the same entry. Windows
+// searches the system value first, so a user copy of a system entry is
+// never reached.
+enum class DedupePolicy : uint8_t {
+  PreferSystem, // drop user entries the system value has
+  PreferUser,   // drop system entries the user value has
+  KeepBoth,     // only repeats within one scope
+};
+
+// The logical changes behind add, remove, clean, dedupe and the --match
+// commands, shared by the CLI and the C API. Each Edit may run again on a
+// fresh value after a conflicting write, so `outcome` reflects the last
+// run. Entries are compared after expansion through `session`.
+
+// Appends `entry` unless an entry expanding to the same path is present,
+// or the value would grow past `budget` characters.
+Edit addEntry(Session &session, std::string entry, size_t budget,
+              EditOutcome &outcome);
+// Removes every entry that reaches the same directory as `entry`, by
+// file identity where it exists (Session::identityCache()).
+Edit removeEntry(Session &session, std::string entry, EditOutcome &outcome);
+// Removes every entry whose canonicalHash is in `keys`.
+Edit removeKeys(Session &session, std::unordered_set<uint64_t> keys,
+                EditOutcome &outcome);
+
+// Entries of `table` that dedupe drops under `policy`, in table order: each
+// repeat of an earlier entry of its scope, and each entry the preferred
+// scope also has. `keys` holds one identity key per entry
+// (Session::identityKeys()); one pass over them.
+std::vector<uint32_t> duplicateEntries(const PathTable &table,
+                                       const std::vector<uint64_t> &keys,
+                                       DedupePolicy policy);
+// Drops repeats within the value, keeping the first occurrence, and every
+// entry whose identity key is in `elsewhere` (the preferred scope's keys).
+Edit dedupeEntries(Session &session, std::unordered_set<uint64_t> elsewhere,
+                   EditOutcome &outcome);
+
+// What the --match commands do with the entries a pattern selects.
+enum class Selection : uint8_t {
+  Remove,    // drop them
+  Keep,      // drop everything else
+  MoveFront, // move them ahead of the rest
+  MoveBack,  // move them after the rest
+};
+
+// Applies `action` to the entries `matcher` selects, in one pass. Both the
+// selected and the other entries keep their relative order. Keep aborts
+// when nothing matches.
+Edit selectEntries(Session &session, const EntryMatcher &matcher,
+                   Selection action, EditOutcome &outcome);
+
+} // namespace pathcore
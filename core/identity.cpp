@@ -0,0 +1,239 @@
+#include "identity.h"
+#include "text.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <climits>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace pathcore {
+
+namespace {
+
+// Symlink hops before a path is treated as a loop.
+constexpr int maxHops = 40;
+
+#ifdef _WIN32
+// Prefixes are cached by canonicalKey, so spellings that differ only in
+// case or separators share an entry.
+std::string cacheKey(const std::string &path) { return canonicalKey(path); }
+
+// GetFinalPathNameByHandle returns \\?\C:\... or \\?\UNC\server\...
+std::string stripVerbatim(std::string path) {
+  if (path.rfind("\\\\?\\UNC\\", 0) == 0)
+    return "\\\\" + path.substr(8);
+  if (path.rfind("\\\\?\\", 0) == 0)
+    return path.substr(4);
+  return path;
+}
+#else
+const std::string &cacheKey(const std::string &path) { return path; }
+#endif
+
+// Spreads a FileId over 64 bits (splitmix64 finalizer).
+uint64_t mix(uint64_t h) {
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ull;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebull;
+  return h ^ (h >> 31);
+}
+
+} // namespace
+
+std::string IdentityCache::resolve(const std::string &path) {
+  bool missing;
+  return resolve(path, 0, missing);
+}
+
+std::string IdentityCache::resolve(const std::string &path, int depth,
+                                   bool &missing) {
+  std::error_code ec;
+  fs::path absolute = fs::absolute(fs::path(path), ec);
+  if (ec) {
+    missing = true;
+    return path;
+  }
+  return resolveAbsolute(absolute.string(), depth, missing);
+}
+
+// Resolves the parent first, so siblings find it cached with one lookup
+// and a shared prefix is walked once.
+std::string IdentityCache::resolveAbsolute(const std::string &path, int depth,
+                                           bool &missing) {
+  {
+    std::shared_lock<std::shared_mutex> lock(mu);
+    auto it = prefixes.find(cacheKey(path));
+    if (it != prefixes.end()) {
+      missing = it->second.missing;
+      return it->second.resolved;
+    }
+  }
+  fs::path spelled(path);
+  if (!spelled.has_relative_path()) {
+    missing = false;
+    return path; // a root
+  }
+
+  std::string parent = resolveAbsolute(spelled.parent_path().string(), depth,
+                                       missing);
+  std::string name = spelled.filename().string();
+  std::string out;
+  if (name.empty() || name == ".")
+    out = parent; // trailing separator
+  else if (name == "..")
+    // Parent of what the prefix resolved to, not of how it was spelled
+    out = fs::path(parent).parent_path().string();
+  else if (missing)
+    out = (fs::path(parent) / name).string();
+  else
+    return step((fs::path(parent) / name).string(), depth, missing);
+
+  std::unique_lock<std::shared_mutex> lock(mu);
+  prefixes.emplace(cacheKey(path), Step{out, missing});
+  return out;
+}
+
+std::string IdentityCache::step(const std::string &candidate, int depth,
+                                bool &missing) {
+  {
+    std::shared_lock<std::shared_mutex> lock(mu);
+    auto it = prefixes.find(cacheKey(candidate));
+    if (it != prefixes.end()) {
+      missing = it->second.missing;
+      return it->second.resolved;
+    }
+  }
+
+  Step s{candidate, false};
+#ifdef _WIN32
+  (void)depth; // the system follows the whole chain in one call
+  DWORD attrs = GetFileAttributesA(candidate.c_str());
+  if (attrs == INVALID_FILE_ATTRIBUTES) {
+    s.missing = true;
+  } else if (attrs & FILE_ATTRIBUTE_REPARSE_POINT) {
+    HANDLE h = CreateFileA(candidate.c_str(), 0,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE |
+                               FILE_SHARE_DELETE,
+                           nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS,
+                           nullptr);
+    if (h == INVALID_HANDLE_VALUE) {
+      s.missing = true; // dangling junction or link
+    } else {
+      char buf[MAX_PATH * 4];
+      DWORD n = GetFinalPathNameByHandleA(h, buf, sizeof(buf),
+                                          FILE_NAME_NORMALIZED);
+      CloseHandle(h);
+      if (n > 0 && n < sizeof(buf))
+        s.resolved = stripVerbatim(std::string(buf, n));
+    }
+  }
+#else
+  struct stat st;
+  if (::lstat(candidate.c_str(), &st) != 0) {
+    s.missing = true;
+  } else if (S_ISLNK(st.st_mode)) {
+    char buf[PATH_MAX];
+    ssize_t n = ::readlink(candidate.c_str(), buf, sizeof(buf));
+    if (n <= 0 || depth >= maxHops) {
+      s.missing = true;
+    } else {
+      fs::path target(std::string(buf, static_cast<size_t>(n)));
+      if (target.is_relative())
+        target = fs::path(candidate).parent_path() / target;
+      s.resolved = resolve(target.string(), depth + 1, s.missing);
+    }
+  }
+#endif
+
+  std::unique_lock<std::shared_mutex> lock(mu);
+  prefixes.emplace(cacheKey(candidate), s);
+  missing = s.missing;
+  return s.resolved;
+}
+
+FileId IdentityCache::id(const std::string &path) {
+  {
+    std::shared_lock<std::shared_mutex> lock(mu);
+    auto it = ids.find(path);
+    if (it != ids.end())
+      return it->second;
+  }
+
+  FileId found;
+#ifdef _WIN32
+  HANDLE h = CreateFileA(path.c_str(), 0,
+                         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                         nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS,
+                         nullptr);
+  if (h != INVALID_HANDLE_VALUE) {
+    BY_HANDLE_FILE_INFORMATION info;
+    if (GetFileInformationByHandle(h, &info))
+      found = FileId{info.dwVolumeSerialNumber,
+                     (static_cast<uint64_t>(info.nFileIndexHigh) << 32) |
+                         info.nFileIndexLow,
+                     true};
+    CloseHandle(h);
+  }
+#else
+  struct stat st;
+  if (::stat(path.c_str(), &st) == 0)
+    found = FileId{static_cast<uint64_t>(st.st_dev),
+                   static_cast<uint64_t>(st.st_ino), true};
+#endif
+
+  std::unique_lock<std::shared_mutex> lock(mu);
+  ids.emplace(path, found);
+  return found;
+}
+
+uint64_t IdentityCache::key(const std::string &path) {
+  // Resolving first spares the stat of paths under a missing prefix
+  bool missing;
+  std::string resolved = resolve(path, 0, missing);
+  FileId fid = missing ? FileId{} : id(resolved);
+  if (fid.valid)
+    return mix(fid.device * 0x9e3779b97f4a7c15ull ^ fid.file);
+  return canonicalHash(resolved);
+}
+
+std::vector<uint64_t> IdentityCache::keys(const std::vector<std::string> &paths,
+                                          unsigned threads) {
+  std::vector<uint64_t> out(paths.size());
+  std::atomic<size_t> next{0};
+  auto work = [&] {
+    for (size_t k; (k = next.fetch_add(1)) < paths.size();)
+      out[k] = key(paths[k]);
+  };
+  unsigned n = std::max(1u, std::min<unsigned>(
+                                threads, static_cast<unsigned>(paths.size())));
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < n; ++t)
+    pool.emplace_back(work);
+  work();
+  for (auto &t : pool)
+    t.join();
+  return out;
+}
+
+void IdentityCache::clear() {
+  std::unique_lock<std::shared_mutex> lock(mu);
+  prefixes.clear();
+  ids.clear();
+}
+
+} // namespace pathcore
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pathcore {
+
+// What a path refers to on disk: device and inode, or on Windows volume
+// serial number and file index.
+struct FileId {
+  uint64_t device = 0;
+  uint64_t file = 0;
+  bool valid = false; // false if the path does not exist
+
+  bool operator==(const FileId &o) const {
+    return valid == o.valid && device == o.device && file == o.file;
+  }
+};
+
+// Tells whether two paths reach the same directory, through symlinks and
+// junctions as well as spelling. Thread-safe.
+//
+// Each resolved prefix is cached, so the thousand entries under
+// C:\Program Files resolve that prefix once, not once per entry.
+class IdentityCache {
+public:
+  // Absolute path with every symlink and junction resolved. Components
+  // past the first missing one are kept as written, as
+  // std::filesystem::weakly_canonical does.
+  std::string resolve(const std::string &path);
+  FileId id(const std::string &path);
+
+  // Equal for paths that reach the same directory: the FileId where the
+  // path exists, else the canonicalHash of the resolved path.
+  uint64_t key(const std::string &path);
+  // key() of each path, resolved on `threads` workers.
+  std::vector<uint64_t> keys(const std::vector<std::string> &paths,
+                             unsigned threads);
+
+  void clear();
+
+private:
+  // Resolves `path` after `depth` link hops; `missing` is set if some
+  // component does not exist.
+  std::string resolve(const std::string &path, int depth, bool &missing);
+  std::string resolveAbsolute(const std::string &path, int depth,
+                              bool &missing);
+  // Resolves one existing-or-not component under an already resolved
+  // parent; `missing` is set if it does not exist.
+  std::string step(const std::string &candidate, int depth, bool &missing);
+
+  struct Step {
+    std::string resolved;
+    bool missing;
+  };
+  std::shared_mutex mu;
+  std::unordered_map<std::string, Step> prefixes;
+  std::unordered_map<std::string, FileId> ids;
+};
+
+} // namespace pathcore
@@ -0,0 +1,265 @@
+#include "impact.h"
+#include "cost.h"
+#include "journal.h"
+#include "text.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace pathcore {
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  NameIndex
+// ─────────────────────────────────────────────────────────────────────────────
+namespace {
+
+bool modifiedTime(const std::string &dir, int64_t &mtime) {
+  std::error_code ec;
+  auto time = fs::last_write_time(dir, ec);
+  if (ec)
+    return false;
+  mtime = static_cast<int64_t>(time.time_since_epoch().count());
+  return mtime != 0;
+}
+
+std::vector<std::string> listNames(const std::string &dir) {
+#ifdef _WIN32
+  return listFiles(dir);
+#else
+  std::vector<std::string> out;
+  std::error_code ec;
+  for (fs::directory_iterator
+           entry(dir, fs::directory_options::skip_permission_denied, ec),
+       end;
+       !ec && entry != end; entry.increment(ec)) {
+    struct stat st;
+    if (::stat(entry->path().c_str(), &st) == 0 && S_ISREG(st.st_mode) &&
+        (st.st_mode & 0111))
+      out.push_back(entry->path().filename().string());
+  }
+  std::sort(out.begin(), out.end());
+  return out;
+#endif
+}
+
+} // namespace
+
+// A version line, then per directory `<mtime> <dir>` followed by one
+// tab-indented line per name.
+bool NameIndex::load(std::string &error) {
+  dirs.clear();
+  std::ifstream in(file, std::ios::binary);
+  if (file.empty() || !in)
+    return true;
+  std::string line;
+  if (!std::getline(in, line) || line != "pathmgr-names 1") {
+    error = "Unrecognized name index " + file + "; it will be rebuilt";
+    return false;
+  }
+  Listing *current = nullptr;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line[0] == '\t') {
+      if (current)
+        current->names.push_back(line.substr(1));
+      continue;
+    }
+    size_t space = line.find(' ');
+    current = nullptr;
+    if (space == std::string::npos)
+      continue;
+    Listing &l = dirs[line.substr(space + 1)];
+    l.mtime = std::strtoll(line.c_str(), nullptr, 10);
+    current = &l;
+  }
+  return true;
+}
+
+bool NameIndex::save(std::string &error) const {
+  if (file.empty() || !dirty)
+    return true;
+  std::error_code ec;
+  fs::create_directories(fs::path(file).parent_path(), ec);
+  std::string tmp = file + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out << "pathmgr-names 1\n";
+    for (const auto &[key, l] : dirs) {
+      if (!l.mtime)
+        continue;
+      out << l.mtime << " " << key << "\n";
+      for (const auto &name : l.names)
+        out << "\t" << name << "\n";
+    }
+    out.flush();
+    if (!out) {
+      error = "Cannot write " + tmp;
+      return false;
+    }
+  }
+  fs::rename(tmp, file, ec);
+  if (ec) {
+    error = "Cannot replace " + file + ": " + ec.message();
+    fs::remove(tmp, ec);
+    return false;
+  }
+  return true;
+}
+
+const std::vector<std::string> &NameIndex::names(const std::string &dir) {
+  Listing &l = dirs[canonicalKey(dir)];
+  if (l.checked)
+    return l.names;
+  l.checked = true;
+
+  int64_t mtime = 0;
+  if (!modifiedTime(dir, mtime)) {
+    dirty |= l.mtime != 0;
+    l.mtime = 0;
+    l.names.clear();
+  } else if (mtime != l.mtime) {
+    l.mtime = mtime;
+    l.names = listNames(dir);
+    fresh++;
+    dirty = true;
+  }
+  return l.names;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Impact
+// ─────────────────────────────────────────────────────────────────────────────
+namespace {
+
+struct Order {
+  std::vector<std::string> keys, dirs; // first occurrence of each directory
+};
+
+// Later repeats of a directory are never reached, so only the first
+// occurrence counts.
+Order firstOccurrences(const std::vector<std::string> &dirs) {
+  Order o;
+  std::unordered_set<std::string> seen;
+  for (const auto &d : dirs) {
+    std::string key = canonicalKey(d);
+    if (seen.insert(key).second) {
+      o.keys.push_back(std::move(key));
+      o.dirs.push_back(d);
+    }
+  }
+  return o;
+}
+
+// File `name` resolves to in `order`, empty if none: each directory in
+// turn, each lookup name within it.
+std::string resolveIn(const Order &order, const std::vector<std::string> &files,
+                      NameIndex &index) {
+  for (const auto &dir : order.dirs) {
+    const auto &names = index.names(dir);
+    for (const auto &f : files)
+      if (std::binary_search(names.begin(), names.end(), f))
+        return (fs::path(dir) / f).string();
+  }
+  return "";
+}
+
+// Name a file is launched by, or empty if a lookup never reaches it: its
+// stem when it carries one of `exts`, the whole name when there are none.
+std::string launchName(const std::string &file,
+                       const std::vector<std::string> &exts) {
+  if (exts.empty())
+    return file;
+  size_t dot = file.find_last_of('.');
+  if (dot != std::string::npos)
+    for (const auto &ext : exts)
+      if (iequals(std::string_view(file).substr(dot), ext))
+        return file.substr(0, dot);
+  return "";
+}
+
+} // namespace
+
+ImpactReport changeImpact(const std::vector<std::string> &before,
+                          const std::vector<std::string> &after,
+                          const std::vector<std::string> &extensions,
+                          NameIndex &index) {
+  ImpactReport r;
+  Order from = firstOccurrences(before), to = firstOccurrences(after);
+
+  // Directories kept in the same relative order cannot change a winner
+  // among themselves; only names found in the others need resolving.
+  std::unordered_map<std::string, std::string> dirOf;
+  for (size_t k = 0; k < from.keys.size(); ++k)
+    dirOf.emplace(from.keys[k], from.dirs[k]);
+  for (size_t k = 0; k < to.keys.size(); ++k)
+    dirOf.emplace(to.keys[k], to.dirs[k]);
+  std::unordered_set<std::string> touched;
+  for (const auto &op : Delta::between(from.keys, to.keys).ops)
+    touched.insert(op.text);
+  r.touched = touched.size();
+
+  std::unordered_set<std::string> seen;
+  std::vector<std::string> names;
+  for (const auto &key : touched)
+    for (const auto &file : index.names(dirOf[key])) {
+      std::string name = launchName(file, extensions);
+      if (!name.empty() && seen.insert(name).second)
+        names.push_back(std::move(name));
+    }
+  std::sort(names.begin(), names.end());
+  r.checked = names.size();
+
+  for (const auto &name : names) {
+    std::vector<std::string> files = lookupNames(name, extensions);
+    ImpactChange c{name, resolveIn(from, files, index),
+                   resolveIn(to, files, index)};
+    if (c.before.empty() && !c.after.empty())
+      r.gained.push_back(std::move(c));
+    else if (!c.before.empty() && c.after.empty())
+      r.lost.push_back(std::move(c));
+    else if (canonicalKey(c.before) != canonicalKey(c.after))
+      r.changed.push_back(std::move(c));
+  }
+  return r;
+}
+
+ImpactReport previewImpact(Session &session, Scope scope, const Edit &edit,
+                           NameIndex &index, EditResult &result) {
+  Scope other = scope == Scope::User ? Scope::System : Scope::User;
+  const StoreValue *current = session.value(scope);
+  const StoreValue *otherValue = session.value(other);
+  if (!current || !otherValue) {
+    result = EditResult::Abort;
+    return {};
+  }
+  std::vector<std::string> entries = splitPath(current->data);
+  std::vector<std::string> edited = entries;
+  result = edit(edited);
+  if (result != EditResult::Changed)
+    return {};
+
+  std::vector<std::string> fixed = splitPath(otherValue->data);
+  auto order = [&](const std::vector<std::string> &mine) {
+    const auto &system = scope == Scope::System ? mine : fixed;
+    const auto &user = scope == Scope::User ? mine : fixed;
+    std::vector<std::string> dirs;
+    dirs.reserve(system.size() + user.size());
+    for (const auto &e : system)
+      dirs.push_back(session.expand(e));
+    for (const auto &e : user)
+      dirs.push_back(session.expand(e));
+    return dirs;
+  };
+  return changeImpact(order(entries), order(edited), lookupExtensions(),
+                      index);
+}
+
+} // namespace pathcore
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "session.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pathcore {
+
+// Executable names per directory, listed once and kept across runs in a
+// small cache file. A listing is trusted while its directory's
+// modification time holds, which changes whenever a file is added,
+// removed or renamed in it.
+class NameIndex {
+public:
+  // An empty `file` keeps the index in memory only.
+  explicit NameIndex(std::string file = "") : file(std::move(file)) {}
+
+  // A missing file is an empty index, not an error.
+  bool load(std::string &error);
+  // Writes the index if a listing changed since load().
+  bool save(std::string &error) const;
+
+  // File names in `dir` a lookup can launch, sorted and, on Windows,
+  // case-folded: every file there (PATHEXT is applied when resolving),
+  // files with an execute bit elsewhere. Checked against the directory's
+  // mtime once per index.
+  const std::vector<std::string> &names(const std::string &dir);
+
+  // Directories read from disk rather than the cache.
+  size_t listed() const { return fresh; }
+
+private:
+  struct Listing {
+    int64_t mtime = 0;
+    bool checked = false;
+    std::vector<std::string> names;
+  };
+  std::string file;
+  std::unordered_map<std::string, Listing> dirs; // by canonicalKey
+  size_t fresh = 0;
+  bool dirty = false;
+};
+
+struct ImpactChange {
+  std::string name;   // as launched: `git`, not `git.exe`
+  std::string before; // file it resolved to, empty if none
+  std::string after;
+};
+
+struct ImpactReport {
+  std::vector<ImpactChange> changed; // resolves to another file
+  std::vector<ImpactChange> gained;  // found only after
+  std::vector<ImpactChange> lost;    // found only before
+  size_t touched = 0;                // directories added, removed or moved
+  size_t checked = 0;                // names re-resolved
+
+  bool empty() const {
+    return changed.empty() && gained.empty() && lost.empty();
+  }
+};
+
+// Which command names resolve to a different file when the search order
+// goes from `before` to `after` (expanded directories, first searched
+// first). Only names found in directories that were added, removed or
+// moved relative to the others are re-resolved; a name elsewhere keeps
+// its winner, so the cost follows the directories touched.
+ImpactReport changeImpact(const std::vector<std::string> &before,
+                          const std::vector<std::string> &after,
+                          const std::vector<std::string> &extensions,
+                          NameIndex &index);
+
+// Runs `edit` on a copy of the loaded `scope` value and reports its impact
+// on the search order (system value, then user value) without writing.
+// `result` is what the edit returned, or Abort if either value cannot be
+// read; the report is empty unless Changed.
+ImpactReport previewImpact(Session &session, Scope scope, const Edit &edit,
+                           NameIndex &index, EditResult &result);
+
+} // namespace pathcore
@@ -0,0 +1,522 @@
+#include "journal.h"
+#include "lock.h"
+#include "text.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+
+namespace pathcore {
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Delta
+// ─────────────────────────────────────────────────────────────────────────────
+Delta Delta::between(const std::vector<std::string> &before,
+                     const std::vector<std::string> &after) {
+  size_t n = before.size(), m = after.size();
+  std::vector<bool> keptOld(n, false), keptNew(m, false);
+
+  // Common prefix and suffix are kept as-is; only the middle is diffed.
+  size_t p = 0;
+  while (p < n && p < m && before[p] == after[p]) {
+    keptOld[p] = keptNew[p] = true;
+    p++;
+  }
+  size_t q = 0;
+  while (q < n - p && q < m - p && before[n - 1 - q] == after[m - 1 - q]) {
+    keptOld[n - 1 - q] = keptNew[m - 1 - q] = true;
+    q++;
+  }
+
+  // LCS of the middle. PATH edits touch few entries, so the middle is
+  // small; past a few million cells everything in it is replaced instead.
+  size_t a = n - p - q, b = m - p - q;
+  if (a > 0 && b > 0 && a * b <= 4u << 20) {
+    std::vector<uint32_t> len((a + 1) * (b + 1), 0);
+    auto at = [&](size_t i, size_t j) -> uint32_t & {
+      return len[i * (b + 1) + j];
+    };
+    for (size_t i = a; i-- > 0;)
+      for (size_t j = b; j-- > 0;)
+        at(i, j) = before[p + i] == after[p + j]
+                       ? at(i + 1, j + 1) + 1
+                       : std::max(at(i + 1, j), at(i, j + 1));
+    size_t i = 0, j = 0;
+    while (i < a && j < b) {
+      if (before[p + i] == after[p + j]) {
+        keptOld[p + i] = keptNew[p + j] = true;
+        i++, j++;
+      } else if (at(i + 1, j) >= at(i, j + 1)) {
+        i++;
+      } else {
+        j++;
+      }
+    }
+  }
+
+  // An entry removed in one place and inserted in another is a move.
+  Delta d;
+  std::unordered_map<std::string, std::vector<uint32_t>> removed;
+  for (size_t i = 0; i < n; ++i)
+    if (!keptOld[i])
+      removed[before[i]].push_back(static_cast<uint32_t>(i));
+  for (size_t j = 0; j < m; ++j) {
+    if (keptNew[j])
+      continue;
+    auto it = removed.find(after[j]);
+    if (it != removed.end() && !it->second.empty()) {
+      d.ops.push_back({'>', it->second.front(), static_cast<uint32_t>(j),
+                       after[j]});
+      it->second.erase(it->second.begin());
+    } else {
+      d.ops.push_back({'+', 0, static_cast<uint32_t>(j), after[j]});
+    }
+  }
+  for (auto &[text, indexes] : removed)
+    for (uint32_t i : indexes)
+      d.ops.push_back({'-', i, 0, text});
+  return d;
+}
+
+namespace {
+
+// Deletes `drop` indexes, then inserts `add` at their final positions.
+bool patch(std::vector<std::string> &entries, std::vector<uint32_t> drop,
+           std::vector<std::pair<uint32_t, std::string>> add) {
+  std::sort(drop.rbegin(), drop.rend());
+  for (uint32_t i : drop) {
+    if (i >= entries.size())
+      return false;
+    entries.erase(entries.begin() + i);
+  }
+  std::sort(add.begin(), add.end(),
+            [](const auto &x, const auto &y) { return x.first < y.first; });
+  for (auto &[i, text] : add) {
+    if (i > entries.size())
+      return false;
+    entries.insert(entries.begin() + i, std::move(text));
+  }
+  return true;
+}
+
+} // namespace
+
+void Delta::apply(std::vector<std::string> &entries) const {
+  std::vector<uint32_t> drop;
+  std::vector<std::pair<uint32_t, std::string>> add;
+  for (const auto &op : ops) {
+    if (op.kind != '+')
+      drop.push_back(op.from);
+    if (op.kind != '-')
+      add.emplace_back(op.to, op.text);
+  }
+  patch(entries, std::move(drop), std::move(add));
+}
+
+void Delta::revert(std::vector<std::string> &entries) const {
+  std::vector<uint32_t> drop;
+  std::vector<std::pair<uint32_t, std::string>> add;
+  for (const auto &op : ops) {
+    if (op.kind != '-')
+      drop.push_back(op.to);
+    if (op.kind != '+')
+      add.emplace_back(op.from, op.text);
+  }
+  patch(entries, std::move(drop), std::move(add));
+}
+
+size_t Delta::count(char kind) const {
+  return static_cast<size_t>(std::count_if(
+      ops.begin(), ops.end(), [&](const Op &op) { return op.kind == kind; }));
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Journal
+// ─────────────────────────────────────────────────────────────────────────────
+//  @<gen> <D|C|X> <USER|SYSTEM> <unix-ms> <base-hash> <hash> <ops> <name>
+//  - <from>\t<entry>
+//  + <to>\t<entry>
+//  > <from> <to>\t<entry>
+//  < <offset>                           ('C' and 'X': the variable's
+//                                        previous checkpoint record)
+//  = <full value>                       ('C' and 'X' only)
+//  ^ <gen>                              (an undo back to <gen>)
+//
+// journal.log.tail:
+//  <journal bytes>
+//  <USER|SYSTEM> <gen> <hash> <offset> <name>
+//                    (last generation of each variable, and the offset of
+//                     its latest checkpoint record)
+namespace {
+
+// Hash of the value as the journal sees it: empty items do not count.
+uint64_t valueHash(const std::string &value) {
+  return contentHash(joinPath(splitPath(value)));
+}
+
+std::string hex(uint64_t v) {
+  char buf[17];
+  std::snprintf(buf, sizeof(buf), "%016" PRIx64, v);
+  return buf;
+}
+
+struct Tail {
+  uint64_t number = 0, hash = 0;
+  uint64_t checkpoint = 0; // offset of the latest 'C' or 'X' record
+};
+using Tails = std::map<std::pair<std::string, std::string>, Tail>;
+
+std::pair<std::string, std::string> tailKey(Scope scope,
+                                            const std::string &name) {
+  return {scopeName(scope), toLower(name)};
+}
+
+// Last generation of every variable, from the headers of the whole
+// journal. Only needed when the .tail file is missing or stale.
+Tails scanTails(const std::string &file) {
+  Tails tails;
+  std::ifstream in(file, std::ios::binary);
+  std::string line;
+  uint64_t next = 0;
+  while (std::getline(in, line)) {
+    uint64_t at = next;
+    next += line.size() + 1;
+    if (line.empty() || line[0] != '@')
+      continue;
+    char kind = 0, scopeBuf[8] = {}, nameBuf[256] = {};
+    unsigned long long number = 0, base = 0, hash = 0;
+    long long time = 0;
+    size_t ops = 0;
+    if (std::sscanf(line.c_str(), "@%llu %c %7s %lld %llx %llx %zu %255[^\r\n]",
+                    &number, &kind, scopeBuf, &time, &base, &hash, &ops,
+                    nameBuf) == 8) {
+      Tail &tail = tails[{scopeBuf, toLower(nameBuf)}];
+      tail.number = number;
+      tail.hash = hash;
+      if (kind != 'D')
+        tail.checkpoint = at;
+    }
+  }
+  return tails;
+}
+
+// The .tail file, if it was written for a journal of `size` bytes.
+bool readTails(const std::string &file, uint64_t size, Tails &tails) {
+  std::ifstream in(file, std::ios::binary);
+  std::string line;
+  if (!std::getline(in, line) || std::strtoull(line.c_str(), nullptr, 10) != size)
+    return false;
+  while (std::getline(in, line)) {
+    char scopeBuf[8] = {}, nameBuf[256] = {};
+    unsigned long long number = 0, hash = 0, checkpoint = 0;
+    if (std::sscanf(line.c_str(), "%7s %llu %llx %llu %255[^\r\n]", scopeBuf,
+                    &number, &hash, &checkpoint, nameBuf) != 5)
+      return false;
+    tails[{scopeBuf, nameBuf}] = {number, hash, checkpoint};
+  }
+  return true;
+}
+
+void writeTails(const std::string &file, uint64_t size, const Tails &tails) {
+  std::string tmp = file + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out << size << "\n";
+    for (const auto &[key, tail] : tails)
+      out << key.first << " " << tail.number << " " << hex(tail.hash) << " "
+          << tail.checkpoint << " " << key.second << "\n";
+    if (!out.flush())
+      return; // a missing or stale tail only costs the next append a scan
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, file, ec);
+}
+
+uint64_t fileSize(const std::string &file) {
+  std::error_code ec;
+  auto size = std::filesystem::file_size(file, ec);
+  return ec ? 0 : static_cast<uint64_t>(size);
+}
+
+// Appends the generations of one variable recorded in bytes [from, until)
+// of the journal to `chain`, oldest first. Returns the `<` link of the
+// first of them: where the checkpoint before it starts, 0 if unknown.
+uint64_t readSegment(const std::string &file, Scope scope,
+                     const std::string &name, uint64_t from, uint64_t until,
+                     std::vector<Generation> &chain) {
+  std::ifstream in(file, std::ios::binary);
+  in.seekg(static_cast<std::streamoff>(from));
+  std::string line;
+  uint64_t next = from, previous = 0;
+  size_t first = chain.size();
+  bool mine = false;
+  while (next < until && std::getline(in, line)) {
+    next += line.size() + 1;
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (line.empty())
+      continue;
+    if (line[0] == '@') {
+      Generation g;
+      char kind = 0, scopeBuf[8] = {}, nameBuf[256] = {};
+      unsigned long long number = 0, base = 0, hash = 0;
+      long long time = 0;
+      size_t ops = 0;
+      mine = std::sscanf(line.c_str(), "@%llu %c %7s %lld %llx %llx %zu %255[^\n]",
+                         &number, &kind, scopeBuf, &time, &base, &hash, &ops,
+                         nameBuf) == 8 &&
+             std::string(scopeBuf) == scopeName(scope) &&
+             iequals(nameBuf, name);
+      if (mine) {
+        g.number = number;
+        g.kind = kind;
+        g.timeMs = time;
+        g.baseHash = base;
+        g.hash = hash;
+        g.delta.ops.reserve(ops);
+        chain.push_back(std::move(g));
+      }
+      continue;
+    }
+    if (!mine)
+      continue;
+
+    Generation &g = chain.back();
+    if (line[0] == '=') {
+      g.value = line.size() > 2 ? line.substr(2) : "";
+      continue;
+    }
+    if (line[0] == '^') {
+      g.restores = std::strtoull(line.c_str() + 1, nullptr, 10);
+      continue;
+    }
+    if (line[0] == '<') {
+      if (chain.size() == first + 1)
+        previous = std::strtoull(line.c_str() + 1, nullptr, 10);
+      continue;
+    }
+    size_t tab = line.find('\t');
+    if (tab == std::string::npos)
+      continue;
+    Delta::Op op{line[0], 0, 0, line.substr(tab + 1)};
+    unsigned a = 0, b = 0;
+    int fields = std::sscanf(line.c_str() + 1, "%u %u", &a, &b);
+    if (op.kind == '-')
+      op.from = a;
+    else if (op.kind == '+')
+      op.to = a;
+    else if (op.kind == '>' && fields == 2)
+      op.from = a, op.to = b;
+    else
+      continue;
+    g.delta.ops.push_back(std::move(op));
+  }
+  return previous;
+}
+
+} // namespace
+
+Journal::Journal(std::string file, uint32_t checkpointEvery)
+    : file(std::move(file)), checkpointEvery(checkpointEvery) {}
+
+bool Journal::append(Scope scope, const std::string &name,
+                     const std::string &before, const std::string &after,
+                     uint64_t restores) {
+  std::error_code ec;
+  std::filesystem::create_directories(
+      std::filesystem::path(file).parent_path(), ec);
+  FileLock lock(file + ".lock");
+
+  std::string tailFile = file + ".tail";
+  uint64_t size = fileSize(file);
+  Tails tails;
+  if (!readTails(tailFile, size, tails))
+    tails = scanTails(file);
+  auto found = tails.find(tailKey(scope, name));
+  bool empty = found == tails.end();
+  Tail last = empty ? Tail{} : found->second;
+  uint64_t next = last.number + 1;
+  int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now().time_since_epoch())
+                    .count();
+  std::vector<std::string> oldEntries = splitPath(before);
+  std::vector<std::string> newEntries = splitPath(after);
+  uint64_t baseHash = contentHash(joinPath(oldEntries));
+  uint64_t hash = contentHash(joinPath(newEntries));
+
+  std::string record;
+  auto header = [&](uint64_t gen, char kind, uint64_t from, uint64_t to,
+                    size_t ops) {
+    record += "@" + std::to_string(gen) + " " + kind + " " + scopeName(scope) +
+              " " + std::to_string(now) + " " + hex(from) + " " + hex(to) +
+              " " + std::to_string(ops) + " " + name + "\n";
+  };
+
+  // Checkpoints link back, so history() can start at the latest one.
+  uint64_t checkpointAt = last.checkpoint;
+
+  if (empty || last.hash != baseHash) {
+    size_t at = record.size();
+    header(next, 'X', last.hash, baseHash, 0);
+    if (!empty)
+      record += "< " + std::to_string(checkpointAt) + "\n";
+    checkpointAt = size + at;
+    empty = false;
+    record += "= " + joinPath(oldEntries) + "\n";
+    next++;
+  }
+
+  Delta delta = Delta::between(oldEntries, newEntries);
+  bool checkpoint = next % checkpointEvery == 0;
+  size_t at = record.size();
+  header(next, checkpoint ? 'C' : 'D', baseHash, hash, delta.ops.size());
+  if (checkpoint) {
+    record += "< " + std::to_string(checkpointAt) + "\n";
+    checkpointAt = size + at;
+  }
+  for (const auto &op : delta.ops) {
+    record += op.kind;
+    if (op.kind == '-')
+      record += " " + std::to_string(op.from);
+    else if (op.kind == '+')
+      record += " " + std::to_string(op.to);
+    else
+      record += " " + std::to_string(op.from) + " " + std::to_string(op.to);
+    record += "\t" + op.text + "\n";
+  }
+  if (restores)
+    record += "^ " + std::to_string(restores) + "\n";
+  if (checkpoint)
+    record += "= " + joinPath(newEntries) + "\n";
+
+  std::ofstream out(file, std::ios::binary | std::ios::app);
+  out.write(record.data(), static_cast<std::streamsize>(record.size()));
+  if (!out.flush())
+    return false;
+  out.close();
+  tails[tailKey(scope, name)] = {next, hash, checkpointAt};
+  writeTails(tailFile, size + record.size(), tails);
+  return true;
+}
+
+std::vector<Generation> Journal::history(Scope scope, const std::string &name,
+                                         size_t newest) const {
+  uint64_t size = fileSize(file);
+  Tails tails;
+  if (!readTails(file + ".tail", size, tails))
+    tails = scanTails(file);
+  auto found = tails.find(tailKey(scope, name));
+  if (found == tails.end())
+    return {};
+
+  // From the latest checkpoint to the end, then one checkpoint further
+  // back at a time until enough generations are in. A checkpoint without
+  // a link (older journals) is read from the start.
+  std::vector<Generation> chain;
+  uint64_t from = found->second.checkpoint, until = size;
+  for (;;) {
+    std::vector<Generation> older;
+    uint64_t previous = readSegment(file, scope, name, from, until, older);
+    older.insert(older.end(), std::make_move_iterator(chain.begin()),
+                 std::make_move_iterator(chain.end()));
+    chain = std::move(older);
+    if (from == 0 || chain.size() >= newest ||
+        (!chain.empty() && chain.front().number <= 1))
+      return chain;
+    until = from;
+    from = previous;
+  }
+}
+
+bool Journal::reconstruct(const std::vector<Generation> &chain,
+                          uint64_t generation, const std::string &current,
+                          std::string &out) {
+  auto target = std::find_if(chain.begin(), chain.end(), [&](const auto &g) {
+    return g.number == generation;
+  });
+  if (target == chain.end())
+    return false;
+  size_t idx = static_cast<size_t>(target - chain.begin());
+
+  // Forward: nearest checkpoint at or before the target, then its deltas.
+  size_t cp = idx;
+  while (cp > 0 && chain[cp].kind == 'D')
+    cp--;
+  size_t forwardCost = chain[cp].kind == 'D' ? SIZE_MAX : idx - cp;
+
+  // Backward: from the current value, revert the newer deltas. Only if the
+  // store still holds the last generation and no external change is in the
+  // way.
+  size_t backwardCost = SIZE_MAX;
+  if (valueHash(current) == chain.back().hash) {
+    bool clean = true;
+    for (size_t k = idx + 1; k < chain.size() && clean; ++k)
+      clean = chain[k].kind != 'X';
+    if (clean)
+      backwardCost = chain.size() - 1 - idx;
+  }
+
+  if (forwardCost == SIZE_MAX && backwardCost == SIZE_MAX)
+    return false;
+
+  std::vector<std::string> entries;
+  if (backwardCost <= forwardCost) {
+    entries = splitPath(current);
+    for (size_t k = chain.size() - 1; k > idx; --k)
+      chain[k].delta.revert(entries);
+  } else {
+    entries = splitPath(chain[cp].value);
+    for (size_t k = cp + 1; k <= idx; ++k)
+      chain[k].delta.apply(entries);
+  }
+  out = joinPath(entries);
+  return contentHash(out) == chain[idx].hash;
+}
+
+uint64_t Journal::stepBack(const std::vector<Generation> &chain,
+                           unsigned steps) {
+  auto indexOf = [&](uint64_t number) -> size_t {
+    auto it = std::lower_bound(
+        chain.begin(), chain.end(), number,
+        [](const Generation &g, uint64_t n) { return g.number < n; });
+    return it != chain.end() && it->number == number
+               ? static_cast<size_t>(it - chain.begin())
+               : SIZE_MAX;
+  };
+  // An undo leaves the variable at the generation it restored; follow
+  // those back to the change that actually produced the value.
+  auto settle = [&](size_t k) {
+    while (k != SIZE_MAX && chain[k].restores &&
+           chain[k].restores < chain[k].number)
+      k = indexOf(chain[k].restores);
+    return k;
+  };
+
+  if (chain.empty())
+    return 0;
+  size_t at = settle(chain.size() - 1);
+  for (unsigned s = 0; s < steps && at != SIZE_MAX; ++s)
+    at = at == 0 ? SIZE_MAX : settle(at - 1);
+  return at == SIZE_MAX ? 0 : chain[at].number;
+}
+
+uint64_t Journal::stepBack(Scope scope, const std::string &name,
+                           unsigned steps,
+                           std::vector<Generation> &chain) const {
+  // Undos and the changes they took back do not count as steps, so the
+  // chain may have to reach further back than `steps` generations.
+  for (size_t newest = size_t{steps} + 1;; newest *= 2) {
+    chain = history(scope, name, newest);
+    uint64_t target = stepBack(chain, steps);
+    if (target || chain.size() < newest)
+      return target;
+  }
+}
+
+} // namespace pathcore
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "store.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pathcore {
+
+// Edit script between two entry lists. Entries kept in order are implied;
+// only removed, inserted and moved entries are stored.
+struct Delta {
+  struct Op {
+    char kind;     // '-' removed, '+' inserted, '>' moved
+    uint32_t from; // index in the old list ('-' and '>')
+    uint32_t to;   // index in the new list ('+' and '>')
+    std::string text;
+  };
+  std::vector<Op> ops;
+
+  static Delta between(const std::vector<std::string> &before,
+                       const std::vector<std::string> &after);
+  // before -> after, and back.
+  void apply(std::vector<std::string> &entries) const;
+  void revert(std::vector<std::string> &entries) const;
+
+  size_t count(char kind) const;
+};
+
+// One committed write of a list variable.
+struct Generation {
+  uint64_t number = 0;
+  int64_t timeMs = 0;
+  uint64_t baseHash = 0; // content hash of the value it was applied to
+  uint64_t hash = 0;     // content hash of the value it produced
+  // 'D' delta only, 'C' delta plus a checkpoint of the result, 'X' a value
+  // that changed outside the journal (checkpoint only, cannot be reverted).
+  char kind = 'D';
+  uint64_t restores = 0; // for an undo, the generation it brought back
+  Delta delta;
+  std::string value; // full value for 'C' and 'X'
+};
+
+// Append-only history of list-variable writes. Each record holds only the
+// delta against the previous generation; every `checkpointEvery`
+// generations the full value is stored too, so any generation is rebuilt
+// from the nearest checkpoint or from the current value by replaying
+// deltas, never by scanning whole copies. The last generation and latest
+// checkpoint of each variable are kept in a small `.tail` file beside the
+// journal, and each checkpoint links to the one before it, so appending
+// costs the size of the delta and reading recent history the records since
+// a checkpoint, not the whole journal.
+class Journal {
+public:
+  explicit Journal(std::string file, uint32_t checkpointEvery = 32);
+
+  // Records the write `before` -> `after`; `restores` marks it as an undo
+  // back to that generation. If `before` does not match the last recorded
+  // generation (someone wrote outside the tool), an 'X' checkpoint of it is
+  // recorded first. Call with the store's scope still locked.
+  bool append(Scope scope, const std::string &name, const std::string &before,
+              const std::string &after, uint64_t restores = 0);
+
+  // Generations of one variable, oldest first: at least the newest
+  // `newest` of them, or all, starting at a checkpoint.
+  std::vector<Generation> history(Scope scope, const std::string &name,
+                                  size_t newest = SIZE_MAX) const;
+
+  // Value of `generation`, given the chain from history() and the current
+  // store value.
+  static bool reconstruct(const std::vector<Generation> &chain,
+                          uint64_t generation, const std::string &current,
+                          std::string &out);
+
+  // Generation `steps` changes before the one the variable is at, counting
+  // neither undos nor the changes they took back; 0 if there is none.
+  static uint64_t stepBack(const std::vector<Generation> &chain,
+                           unsigned steps);
+  // The same, reading only as much history as it takes; `chain` is left
+  // holding it, for reconstruct().
+  uint64_t stepBack(Scope scope, const std::string &name, unsigned steps,
+                    std::vector<Generation> &chain) const;
+
+  const std::string &path() const { return file; }
+
+private:
+  std::string file;
+  uint32_t checkpointEvery;
+};
+
+} // namespace pathcore
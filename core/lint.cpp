@@ -0,0 +1,365 @@
+#include "lint.h"
+#include "cost.h"
+#include "regfile.h"
+#include "text.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace pathcore {
+
+std::string Violation::toJson() const {
+  std::string out = "{\"source\":" + jsonQuote(source) +
+                    ",\"rule\":" + jsonQuote(rule) +
+                    ",\"line\":" + std::to_string(ruleLine) +
+                    ",\"severity\":" +
+                    (severity == Severity::Error ? "\"error\"" : "\"warning\"");
+  if (entry >= 0)
+    out += ",\"scope\":" + jsonQuote(toLower(scopeName(scope))) +
+           ",\"index\":" + std::to_string(entry + 1) +
+           ",\"path\":" + jsonQuote(path);
+  out += ",\"message\":" + jsonQuote(message) + "}";
+  return out;
+}
+
+namespace {
+
+bool under(std::string_view key, std::string_view dir) {
+  return key.size() >= dir.size() && key.compare(0, dir.size(), dir) == 0 &&
+         (key.size() == dir.size() || key[dir.size()] == '\\' ||
+          (!dir.empty() && dir.back() == '\\'));
+}
+
+enum class Kind : uint8_t {
+  MaxEntries,
+  MaxLength,
+  NoDuplicates,
+  NoMissing,
+  Deny,
+  DenyUnder,
+  Require,
+  NoWritableBefore,
+};
+
+struct Rule {
+  Kind kind = Kind::Deny;
+  std::string keyword;
+  uint32_t line = 0;
+  Severity severity = Severity::Error;
+  int scope = -1; // -1 all, else Scope
+  size_t limit = 0;
+  std::string arg; // as written
+  std::string key; // canonical, expanded
+};
+
+} // namespace
+
+struct RuleSet::Compiled {
+  std::vector<Rule> rules;
+  // Matcher set: per-entry rules grouped by how they match, so one pass
+  // over the entries tests each group once.
+  std::vector<uint32_t> globs, prefixes, needed, anchors, totals;
+  int32_t duplicates = -1, missing = -1;
+  std::vector<std::string> writable;
+};
+
+RuleSet::RuleSet() : compiled(std::make_unique<Compiled>()) {
+  for (const char *p : {"c:\\users\\*", "*\\appdata\\*", "*\\temp\\*",
+                        "*\\tmp\\*", "\\home\\*", "\\tmp", "\\var\\tmp"})
+    compiled->writable.emplace_back(p);
+}
+RuleSet::~RuleSet() = default;
+RuleSet::RuleSet(RuleSet &&) noexcept = default;
+RuleSet &RuleSet::operator=(RuleSet &&) noexcept = default;
+
+size_t RuleSet::size() const { return compiled->rules.size(); }
+
+bool RuleSet::load(const std::string &file, std::string &error) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in) {
+    error = "Cannot open rules file: " + file;
+    return false;
+  }
+  std::stringstream buf;
+  buf << in.rdbuf();
+  return parse(buf.str(), error);
+}
+
+bool RuleSet::parse(std::string_view text, std::string &error) {
+  static const std::pair<const char *, Kind> keywords[] = {
+      {"max-entries", Kind::MaxEntries},
+      {"max-length", Kind::MaxLength},
+      {"no-duplicates", Kind::NoDuplicates},
+      {"no-missing", Kind::NoMissing},
+      {"deny", Kind::Deny},
+      {"deny-under", Kind::DenyUnder},
+      {"require", Kind::Require},
+      {"no-writable-before", Kind::NoWritableBefore},
+  };
+
+  Expander expander;
+  Compiled &c = *compiled;
+  std::istringstream in{std::string(text)};
+  std::string line;
+  for (uint32_t number = 1; std::getline(in, line); ++number) {
+    size_t hash = line.find('#');
+    if (hash != std::string::npos)
+      line.erase(hash);
+    std::istringstream fields(line);
+    std::string word;
+    if (!(fields >> word))
+      continue;
+
+    auto fail = [&](const std::string &why) {
+      error = "Rules line " + std::to_string(number) + ": " + why;
+      return false;
+    };
+    auto rest = [&] {
+      std::string arg;
+      std::getline(fields >> std::ws, arg);
+      while (!arg.empty() && isspace(static_cast<unsigned char>(arg.back())))
+        arg.pop_back();
+      return arg;
+    };
+
+    if (word == "writable") {
+      std::string arg = rest();
+      if (arg.empty())
+        return fail("writable needs a pattern");
+      c.writable.push_back(canonicalKey(expander.expand(arg)));
+      continue;
+    }
+
+    Rule rule;
+    rule.line = number;
+    if (word == "warn" || word == "error") {
+      rule.severity = word == "warn" ? Severity::Warning : Severity::Error;
+      if (!(fields >> word))
+        return fail("missing rule after severity");
+    }
+    auto known = std::find_if(std::begin(keywords), std::end(keywords),
+                              [&](const auto &k) { return word == k.first; });
+    if (known == std::end(keywords))
+      return fail("unknown rule '" + word + "'");
+    rule.kind = known->second;
+    rule.keyword = word;
+
+    auto index = static_cast<uint32_t>(c.rules.size());
+    switch (rule.kind) {
+    case Kind::MaxEntries:
+    case Kind::MaxLength: {
+      std::string scope;
+      if (!(fields >> rule.limit))
+        return fail(word + " needs a number");
+      fields >> scope;
+      if (scope == "user")
+        rule.scope = static_cast<int>(Scope::User);
+      else if (scope == "system")
+        rule.scope = static_cast<int>(Scope::System);
+      else if (!scope.empty() && scope != "all")
+        return fail("scope must be user, system or all");
+      c.totals.push_back(index);
+      break;
+    }
+    case Kind::NoDuplicates:
+      c.duplicates = static_cast<int32_t>(index);
+      break;
+    case Kind::NoMissing:
+      c.missing = static_cast<int32_t>(index);
+      break;
+    default:
+      rule.arg = rest();
+      if (rule.arg.empty())
+        return fail(word + " needs a path");
+      rule.key = canonicalKey(expander.expand(rule.arg));
+      auto &group = rule.kind == Kind::Deny        ? c.globs
+                    : rule.kind == Kind::DenyUnder ? c.prefixes
+                    : rule.kind == Kind::Require   ? c.needed
+                                                   : c.anchors;
+      group.push_back(index);
+      break;
+    }
+    c.rules.push_back(std::move(rule));
+  }
+  return true;
+}
+
+std::vector<Violation>
+RuleSet::check(const PathTable &table, const std::string &source,
+               const std::function<bool(uint32_t)> &exists) const {
+  const Compiled &c = *compiled;
+  std::vector<Violation> out;
+  auto report = [&](const Rule &rule, int64_t entry, std::string message) {
+    Violation v;
+    v.source = source;
+    v.ruleLine = rule.line;
+    v.rule = rule.keyword;
+    v.severity = rule.severity;
+    v.entry = entry;
+    if (entry >= 0) {
+      v.scope = table.scope(static_cast<uint32_t>(entry));
+      v.path = std::string(table.expanded(static_cast<uint32_t>(entry)));
+    }
+    v.message = std::move(message);
+    out.push_back(std::move(v));
+  };
+
+  // Whole-list sizes are already known to the table.
+  for (uint32_t r : c.totals) {
+    const Rule &rule = c.rules[r];
+    size_t value = 0;
+    for (Scope s : {Scope::User, Scope::System}) {
+      if (rule.scope >= 0 && rule.scope != static_cast<int>(s))
+        continue;
+      value += rule.kind == Kind::MaxEntries ? table.count(s)
+                                             : table.valueLength(s);
+    }
+    if (rule.kind == Kind::MaxLength && rule.scope < 0 &&
+        table.count(Scope::User) && table.count(Scope::System))
+      value++; // the ';' joining system and user in the process PATH
+    if (value > rule.limit)
+      report(rule, -1,
+             std::string(rule.kind == Kind::MaxEntries ? "entries" : "length") +
+                 " " + std::to_string(value) + " exceeds " +
+                 std::to_string(rule.limit));
+  }
+
+  // Entries seen ahead of each anchor that are user-writable; they only
+  // count once the anchor turns up.
+  std::vector<std::vector<uint32_t>> pending(c.anchors.size());
+  std::vector<bool> anchorSeen(c.anchors.size(), false);
+  std::vector<bool> required(c.needed.size(), false);
+
+  std::string key;
+  for (uint32_t i : searchOrder(table)) {
+    key = canonicalKey(table.expanded(i));
+
+    for (uint32_t r : c.globs)
+      if (globMatch(c.rules[r].key, key))
+        report(c.rules[r], i, "matches denied pattern " + c.rules[r].arg);
+    for (uint32_t r : c.prefixes)
+      if (under(key, c.rules[r].key))
+        report(c.rules[r], i, "is under denied directory " + c.rules[r].arg);
+    for (size_t k = 0; k < c.needed.size(); ++k)
+      if (key == c.rules[c.needed[k]].key)
+        required[k] = true;
+
+    if (c.duplicates >= 0 && (table.flags(i) & Duplicate))
+      report(c.rules[c.duplicates], i, "duplicates an earlier entry");
+    if (c.missing >= 0 && exists && !exists(i))
+      report(c.rules[c.missing], i, "directory does not exist");
+
+    if (c.anchors.empty())
+      continue;
+    bool writable = table.scope(i) == Scope::User ||
+                    std::any_of(c.writable.begin(), c.writable.end(),
+                                [&](const std::string &p) {
+                                  return globMatch(p, key);
+                                });
+    for (size_t k = 0; k < c.anchors.size(); ++k) {
+      if (anchorSeen[k])
+        continue;
+      const Rule &rule = c.rules[c.anchors[k]];
+      if (key == rule.key) {
+        anchorSeen[k] = true;
+        for (uint32_t w : pending[k])
+          report(rule, w, "user-writable directory searched before " + rule.arg);
+      } else if (writable) {
+        pending[k].push_back(i);
+      }
+    }
+  }
+
+  for (size_t k = 0; k < c.needed.size(); ++k)
+    if (!required[k])
+      report(c.rules[c.needed[k]], -1,
+             "required entry " + c.rules[c.needed[k]].arg + " is missing");
+  return out;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Snapshot files
+// ─────────────────────────────────────────────────────────────────────────────
+bool loadSnapshot(const std::string &file, PathTable &out, std::string &error) {
+  if (file.size() > 4 && iequals(std::string_view(file).substr(file.size() - 4), ".reg")) {
+    RegEnvironment env;
+    if (!importEnvironment(file, "", env, error))
+      return false;
+    out.clear();
+    for (Scope s : {Scope::User, Scope::System})
+      for (const auto &v : env.values[static_cast<int>(s)])
+        if (iequals(v.name, "PATH"))
+          for (const auto &entry : splitPath(v.value.data))
+            out.append(s, entry, entry);
+    out.markDuplicates();
+    return true;
+  }
+
+  std::ifstream in(file, std::ios::binary);
+  if (!in) {
+    error = "Cannot open snapshot: " + file;
+    return false;
+  }
+
+  std::vector<std::string> lists[2];
+  Scope scope = Scope::User;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (line.empty())
+      continue;
+    if (line[0] == '#') {
+      if (line.compare(0, 7, "# User ") == 0)
+        scope = Scope::User;
+      else if (line.compare(0, 9, "# System ") == 0)
+        scope = Scope::System;
+      continue;
+    }
+    lists[static_cast<int>(scope)].push_back(std::move(line));
+  }
+
+  out.clear();
+  for (Scope s : {Scope::User, Scope::System})
+    for (const auto &entry : lists[static_cast<int>(s)])
+      out.append(s, entry, entry);
+  out.markDuplicates();
+  return true;
+}
+
+std::vector<std::vector<Violation>>
+lintFiles(const RuleSet &rules, const std::vector<std::string> &files,
+          unsigned threads) {
+  std::vector<std::vector<Violation>> results(files.size());
+  std::atomic<size_t> next{0};
+  auto work = [&] {
+    PathTable table;
+    for (size_t k; (k = next.fetch_add(1)) < files.size();) {
+      std::string error;
+      if (loadSnapshot(files[k], table, error)) {
+        results[k] = rules.check(table, files[k]);
+        continue;
+      }
+      Violation v;
+      v.source = files[k];
+      v.rule = "unreadable";
+      v.message = error;
+      results[k].push_back(std::move(v));
+    }
+  };
+
+  unsigned n = std::max(1u, std::min<unsigned>(
+                                threads, static_cast<unsigned>(files.size())));
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < n; ++t)
+    pool.emplace_back(work);
+  work();
+  for (auto &t : pool)
+    t.join();
+  return results;
+}
+
+} // namespace pathcore
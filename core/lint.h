@@ -0,0 +1,83 @@
+#pragma once
+
+#include "table.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pathcore {
+
+enum class Severity : uint8_t { Warning, Error };
+
+struct Violation {
+  std::string source;    // snapshot file, or "live"
+  uint32_t ruleLine = 0; // line of the rule in the rules file
+  std::string rule;      // rule keyword
+  Severity severity = Severity::Error;
+  int64_t entry = -1;    // table index, -1 for rules about the whole list
+  Scope scope = Scope::User;
+  std::string path;
+  std::string message;
+
+  // One JSON object on one line; "index" is 1-based, as `show` numbers
+  // entries.
+  std::string toJson() const;
+};
+
+// Policy rules compiled from a rules file, one per line:
+//
+//   [warn|error] max-entries <n> [user|system|all]
+//   [warn|error] max-length <n> [user|system|all]
+//   [warn|error] no-duplicates
+//   [warn|error] no-missing
+//   [warn|error] deny <glob>               (* and ? over the whole path)
+//   [warn|error] deny-under <dir>
+//   [warn|error] require <dir>
+//   [warn|error] no-writable-before <dir>
+//   writable <glob>                        (extra user-writable locations)
+//
+// Arguments have %VAR% expanded when the rules are compiled; paths and
+// patterns compare like canonicalKey(). An entry counts as user-writable
+// if it is in the user scope or matches a writable pattern (user profile,
+// AppData and Temp locations by default).
+class RuleSet {
+public:
+  RuleSet();
+  ~RuleSet();
+  RuleSet(RuleSet &&) noexcept;
+  RuleSet &operator=(RuleSet &&) noexcept;
+
+  bool load(const std::string &file, std::string &error);
+  bool parse(std::string_view text, std::string &error);
+  size_t size() const;
+
+  // Evaluates every rule in one pass over `table`, in search order.
+  // `exists` answers no-missing; without it that rule is skipped, as it
+  // must be for snapshots taken on other machines. Safe to call from
+  // several threads at once.
+  std::vector<Violation>
+  check(const PathTable &table, const std::string &source,
+        const std::function<bool(uint32_t)> &exists = {}) const;
+
+private:
+  struct Compiled;
+  std::unique_ptr<Compiled> compiled;
+};
+
+// Reads a file written by `export`: expanded entries under "# User <VAR>
+// entries:" and "# System <VAR> entries:" headers. Lines before any header
+// count as user entries. A `.reg` file, such as a hive export, supplies
+// the Path values of its Environment keys as written.
+bool loadSnapshot(const std::string &file, PathTable &out, std::string &error);
+
+// Lints each snapshot file on up to `threads` workers. Results come back
+// in file order; an unreadable file yields a single "unreadable" violation.
+std::vector<std::vector<Violation>>
+lintFiles(const RuleSet &rules, const std::vector<std::string> &files,
+          unsigned threads);
+
+} // namespace pathcore
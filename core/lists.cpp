@@ -0,0 +1,141 @@
+#include "lists.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+namespace pathcore {
+
+namespace {
+
+const char *const knownLists[] = {"PATH",    "PSModulePath", "PATHEXT", "LIB",
+                                  "LIBPATH", "INCLUDE",      "CLASSPATH"};
+
+bool looksAbsolute(std::string_view item) {
+  return (item.size() >= 3 && item[1] == ':' &&
+          (item[2] == '\\' || item[2] == '/')) ||
+         (!item.empty() && (item[0] == '\\' || item[0] == '/' || item[0] == '%'));
+}
+
+} // namespace
+
+ListKind listKind(std::string_view name) {
+  if (iequals(name, "PATHEXT"))
+    return ListKind::Extensions;
+  if (iequals(name, "CLASSPATH"))
+    return ListKind::Files;
+  return ListKind::Directories;
+}
+
+bool isListVariable(std::string_view name, std::string_view value) {
+  for (const char *known : knownLists)
+    if (iequals(name, known))
+      return true;
+  auto items = splitPath(value);
+  return items.size() >= 2 &&
+         std::any_of(items.begin(), items.end(),
+                     [](const std::string &i) { return looksAbsolute(i); });
+}
+
+bool validEntry(ListKind kind, std::string_view expanded, uint64_t keyHash,
+                ProbeCache &probes) {
+  switch (kind) {
+  case ListKind::Extensions:
+    return expanded.size() > 1 && expanded[0] == '.' &&
+           expanded.find_first_of("\\/:*? ", 1) == std::string_view::npos;
+  case ListKind::Files: {
+    // `lib\*` puts every archive in lib on the class path
+    std::string_view path = expanded;
+    if (path.size() >= 2 && path.back() == '*' &&
+        (path[path.size() - 2] == '\\' || path[path.size() - 2] == '/')) {
+      path.remove_suffix(1);
+      return probes.kind(std::string(path), canonicalHash(path)) ==
+             PathKind::Directory;
+    }
+    return probes.kind(std::string(path), keyHash) != PathKind::Missing;
+  }
+  default:
+    return probes.directoryExists(std::string(expanded), keyHash);
+  }
+}
+
+std::vector<ListAudit> auditLists(EnvStore &store, Expander &expander,
+                                  ProbeCache &probes, unsigned threads) {
+  // One pass per scope; user values first, as the table keeps them.
+  std::vector<NamedValue> values[2];
+  store.readAll(Scope::User, values[0]);
+  store.readAll(Scope::System, values[1]);
+
+  // A name is a list if its value in either scope looks like one, so a
+  // single-item user value still joins a system list, and the other way
+  // round; decided for every name before any table is built.
+  std::vector<ListAudit> audits;
+  std::unordered_map<std::string, size_t> byName; // lowercased
+  for (const auto &scopeValues : values) {
+    for (const auto &nv : scopeValues) {
+      if (!isListVariable(nv.name, nv.value.data) ||
+          !byName.emplace(toLower(nv.name), audits.size()).second)
+        continue;
+      audits.emplace_back();
+      audits.back().name = nv.name;
+      audits.back().kind = listKind(nv.name);
+    }
+  }
+  for (Scope scope : {Scope::User, Scope::System}) {
+    for (const auto &nv : values[static_cast<int>(scope)]) {
+      auto it = byName.find(toLower(nv.name));
+      if (it == byName.end())
+        continue;
+      ListAudit &a = audits[it->second];
+      for (const auto &item : splitPath(nv.value.data))
+        a.table.append(scope, item, expander.expand(item));
+    }
+  }
+
+  std::sort(audits.begin(), audits.end(), [](const auto &x, const auto &y) {
+    bool xp = iequals(x.name, "PATH"), yp = iequals(y.name, "PATH");
+    return xp != yp ? xp : toLower(x.name) < toLower(y.name);
+  });
+
+  // Every entry of every variable is one task, so a long PATH does not
+  // leave the other workers idle.
+  std::vector<std::pair<uint32_t, uint32_t>> tasks;
+  std::vector<std::vector<uint8_t>> ok(audits.size());
+  for (uint32_t v = 0; v < audits.size(); ++v) {
+    audits[v].table.markDuplicates();
+    ok[v].assign(audits[v].table.size(), 1);
+    for (uint32_t i = 0; i < audits[v].table.size(); ++i)
+      tasks.emplace_back(v, i);
+  }
+
+  std::atomic<size_t> next{0};
+  auto work = [&] {
+    for (size_t k; (k = next.fetch_add(1)) < tasks.size();) {
+      auto [v, i] = tasks[k];
+      const PathTable &t = audits[v].table;
+      ok[v][i] = validEntry(audits[v].kind, t.expanded(i), t.keyHash(i), probes);
+    }
+  };
+  unsigned n = std::max(1u, std::min<unsigned>(
+                                threads, static_cast<unsigned>(tasks.size())));
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < n; ++t)
+    pool.emplace_back(work);
+  work();
+  for (auto &t : pool)
+    t.join();
+
+  for (uint32_t v = 0; v < audits.size(); ++v) {
+    const PathTable &t = audits[v].table;
+    for (uint32_t i = 0; i < t.size(); ++i) {
+      if (!ok[v][i])
+        audits[v].invalid.push_back(i);
+      if (t.flags(i) & Duplicate)
+        audits[v].duplicates++;
+    }
+  }
+  return audits;
+}
+
+} // namespace pathcore
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "probe.h"
+#include "store.h"
+#include "table.h"
+#include "text.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pathcore {
+
+// What the items of a list variable name, which decides what "valid" means.
+enum class ListKind : uint8_t {
+  Directories, // PATH, PSModulePath, LIB, INCLUDE, ...
+  Files,       // CLASSPATH: directories, archives, or `dir\*`
+  Extensions,  // PATHEXT: `.EXE`
+};
+
+ListKind listKind(std::string_view name);
+// Well-known list variables, then anything whose value splits into
+// several items with at least one absolute path.
+bool isListVariable(std::string_view name, std::string_view value);
+
+// Whether an expanded item is valid for its kind: it exists on disk, or
+// for extensions is well-formed.
+bool validEntry(ListKind kind, std::string_view expanded, uint64_t keyHash,
+                ProbeCache &probes);
+
+struct ListAudit {
+  std::string name;
+  ListKind kind = ListKind::Directories;
+  PathTable table;              // both scopes, as Session::load builds it
+  std::vector<uint32_t> invalid;
+  size_t duplicates = 0;
+};
+
+// Reads every value of both scopes (one readAll each), keeps the list
+// variables, and validates all their entries on up to `threads` workers
+// sharing `probes`.
+std::vector<ListAudit> auditLists(EnvStore &store, Expander &expander,
+                                  ProbeCache &probes, unsigned threads);
+
+} // namespace pathcore
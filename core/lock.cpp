@@ -0,0 +1,53 @@
+#include "lock.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace pathcore {
+
+FileLock::FileLock(const std::string &path) {
+#ifdef _WIN32
+  HANDLE h = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                         FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                         OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (h != INVALID_HANDLE_VALUE) {
+    handle = h;
+    OVERLAPPED ov{};
+    held = LockFileEx(h, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &ov);
+  }
+#else
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd >= 0) {
+    int rc;
+    while ((rc = ::flock(fd, LOCK_EX)) != 0 && errno == EINTR) {
+    }
+    held = rc == 0;
+  }
+#endif
+}
+
+FileLock::~FileLock() {
+#ifdef _WIN32
+  if (handle) {
+    if (held) {
+      OVERLAPPED ov{};
+      UnlockFileEx(static_cast<HANDLE>(handle), 0, 1, 0, &ov);
+    }
+    CloseHandle(static_cast<HANDLE>(handle));
+  }
+#else
+  if (fd >= 0)
+    ::close(fd); // releases the flock
+#endif
+}
+
+} // namespace pathcore
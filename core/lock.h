@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+namespace pathcore {
+
+// Exclusive advisory lock on a file, held for the object's lifetime. Used to
+// serialize writers across processes.
+class FileLock {
+public:
+  explicit FileLock(const std::string &path);
+  ~FileLock();
+  FileLock(const FileLock &) = delete;
+  FileLock &operator=(const FileLock &) = delete;
+
+  bool locked() const { return held; }
+
+private:
+#ifdef _WIN32
+  void *handle = nullptr; // HANDLE
+#else
+  int fd = -1;
+#endif
+  bool held = false;
+};
+
+} // namespace pathcore
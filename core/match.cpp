@@ -0,0 +1,36 @@
+#include "match.h"
+#include "text.h"
+
+namespace pathcore {
+
+void EntryMatcher::addGlob(const std::string &pattern) {
+  globs.push_back(canonicalKey(pattern));
+}
+
+bool EntryMatcher::addRegex(const std::string &pattern, std::string &error) {
+  try {
+    regexes.emplace_back(pattern, std::regex::ECMAScript | std::regex::icase |
+                                      std::regex::optimize);
+  } catch (const std::regex_error &e) {
+    error = "Invalid regular expression \"" + pattern + "\": " + e.what();
+    return false;
+  }
+  return true;
+}
+
+bool EntryMatcher::matches(std::string_view raw,
+                           std::string_view expanded) const {
+  if (!globs.empty()) {
+    std::string rawKey = canonicalKey(raw), expandedKey = canonicalKey(expanded);
+    for (const auto &glob : globs)
+      if (globMatch(glob, expandedKey) || globMatch(glob, rawKey))
+        return true;
+  }
+  for (const auto &re : regexes)
+    if (std::regex_search(expanded.begin(), expanded.end(), re) ||
+        std::regex_search(raw.begin(), raw.end(), re))
+      return true;
+  return false;
+}
+
+} // namespace pathcore
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pathcore {
+
+// Selects list entries by glob or regular expression. Patterns are
+// compiled once when added; matching touches no disk.
+class EntryMatcher {
+public:
+  // Glob compared like canonicalKey(), as lint's deny rules: `*` spans any
+  // run of characters, separators included, and `?` is one character.
+  void addGlob(const std::string &pattern);
+  // ECMAScript regular expression, case-insensitive, found anywhere in the
+  // entry. False with `error` set if it does not compile.
+  bool addRegex(const std::string &pattern, std::string &error);
+
+  bool empty() const { return globs.empty() && regexes.empty(); }
+  // True if any pattern matches the entry as written or as expanded, so
+  // `%SDK%\*` and `C:\OldSDK\*` both select `%SDK%\bin`.
+  bool matches(std::string_view raw, std::string_view expanded) const;
+
+private:
+  std::vector<std::string> globs; // canonical keys
+  std::vector<std::regex> regexes;
+};
+
+} // namespace pathcore
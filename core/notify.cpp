@@ -0,0 +1,149 @@
+#include "notify.h"
+#include "trace.h"
+
+#include <condition_variable>
+#include <fstream>
+#include <set>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace pathcore {
+
+using Clock = std::chrono::steady_clock;
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Notifiers
+// ─────────────────────────────────────────────────────────────────────────────
+#ifdef _WIN32
+bool BroadcastNotifier::notify(const std::string &area,
+                               std::chrono::milliseconds timeout) {
+  DWORD_PTR result = 0;
+  return SendMessageTimeoutA(HWND_BROADCAST, WM_SETTINGCHANGE, 0,
+                             reinterpret_cast<LPARAM>(area.c_str()),
+                             SMTO_ABORTIFHUNG,
+                             static_cast<UINT>(timeout.count()),
+                             &result) != 0;
+}
+#endif
+
+RecordingNotifier::RecordingNotifier(std::string logFile)
+    : logFile(std::move(logFile)) {}
+
+bool RecordingNotifier::notify(const std::string &area,
+                               std::chrono::milliseconds) {
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch())
+                .count();
+  std::string line =
+      std::to_string(ms) + "\tWM_SETTINGCHANGE\t" + area;
+  std::lock_guard<std::mutex> lock(mu);
+  recorded.push_back(line);
+  if (!logFile.empty()) {
+    std::ofstream out(logFile, std::ios::app);
+    out << line << "\n";
+    return static_cast<bool>(out);
+  }
+  return true;
+}
+
+std::vector<std::string> RecordingNotifier::events() const {
+  std::lock_guard<std::mutex> lock(mu);
+  return recorded;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  NotifyDispatcher
+// ─────────────────────────────────────────────────────────────────────────────
+// Shared with the worker so it can outlive an abandoned dispatcher.
+struct NotifyDispatcher::State {
+  std::unique_ptr<Notifier> target;
+  std::chrono::milliseconds coalesce;
+  std::chrono::milliseconds perMessage;
+
+  std::mutex mu;
+  std::condition_variable wake, done;
+  std::set<std::string> pending;
+  Clock::time_point lastPost;
+  uint64_t posted = 0, delivered = 0, batches = 0;
+  bool stopping = false;
+};
+
+NotifyDispatcher::NotifyDispatcher(std::unique_ptr<Notifier> target,
+                                   std::chrono::milliseconds coalesce,
+                                   std::chrono::milliseconds budget)
+    : state(std::make_shared<State>()), budget(budget) {
+  state->target = std::move(target);
+  state->coalesce = coalesce;
+  state->perMessage = budget / 2;
+  worker = std::thread(run, state);
+}
+
+NotifyDispatcher::~NotifyDispatcher() {
+  bool drained = waitDelivered(budget);
+  {
+    std::lock_guard<std::mutex> lock(state->mu);
+    state->stopping = true;
+  }
+  state->wake.notify_all();
+  if (drained)
+    worker.join();
+  else
+    worker.detach(); // still inside the notifier; it owns its state
+}
+
+void NotifyDispatcher::post(const std::string &area) {
+  {
+    std::lock_guard<std::mutex> lock(state->mu);
+    state->pending.insert(area);
+    state->lastPost = Clock::now();
+    state->posted++;
+  }
+  state->wake.notify_all();
+}
+
+bool NotifyDispatcher::waitDelivered(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(state->mu);
+  uint64_t target = state->posted;
+  return state->done.wait_for(lock, timeout, [&] {
+    return state->delivered >= target;
+  });
+}
+
+uint64_t NotifyDispatcher::deliveredBatches() const {
+  std::lock_guard<std::mutex> lock(state->mu);
+  return state->batches;
+}
+
+void NotifyDispatcher::run(std::shared_ptr<State> s) {
+  std::unique_lock<std::mutex> lock(s->mu);
+  for (;;) {
+    s->wake.wait(lock, [&] { return s->stopping || !s->pending.empty(); });
+    if (s->pending.empty())
+      return;
+
+    // Let a burst of writes settle so it goes out as one notification.
+    while (!s->stopping && Clock::now() < s->lastPost + s->coalesce)
+      s->wake.wait_until(lock, s->lastPost + s->coalesce);
+
+    std::set<std::string> areas;
+    areas.swap(s->pending);
+    uint64_t upTo = s->posted;
+    lock.unlock();
+    for (const auto &area : areas)
+      if (s->target) {
+        TraceSpan span(Phase::Broadcast);
+        s->target->notify(area, s->perMessage);
+      }
+    lock.lock();
+    s->delivered = upTo;
+    s->batches++;
+    s->done.notify_all();
+  }
+}
+
+} // namespace pathcore
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pathcore {
+
+// Tells running programs that a settings area (normally "Environment")
+// changed. Implementations may block; the dispatcher keeps them off the
+// caller's thread.
+class Notifier {
+public:
+  virtual ~Notifier() = default;
+  virtual bool notify(const std::string &area,
+                      std::chrono::milliseconds timeout) = 0;
+};
+
+#ifdef _WIN32
+// WM_SETTINGCHANGE broadcast to every top-level window. `timeout` bounds
+// the wait on each window, not the whole broadcast.
+class BroadcastNotifier : public Notifier {
+public:
+  bool notify(const std::string &area,
+              std::chrono::milliseconds timeout) override;
+};
+#endif
+
+// Stand-in that records each notification, in memory and, if a log file
+// is given, as a `<unix-ms><TAB>WM_SETTINGCHANGE<TAB><area>` line.
+class RecordingNotifier : public Notifier {
+public:
+  explicit RecordingNotifier(std::string logFile = "");
+
+  bool notify(const std::string &area,
+              std::chrono::milliseconds timeout) override;
+  std::vector<std::string> events() const;
+
+private:
+  std::string logFile;
+  mutable std::mutex mu;
+  std::vector<std::string> recorded;
+};
+
+// Delivers notifications on a background thread. Posts that arrive within
+// `coalesce` of each other become one notification per area, and the
+// destructor waits at most `budget` for delivery before abandoning it, so
+// a hung window can never hold the caller.
+class NotifyDispatcher {
+public:
+  explicit NotifyDispatcher(
+      std::unique_ptr<Notifier> target,
+      std::chrono::milliseconds coalesce = std::chrono::milliseconds(50),
+      std::chrono::milliseconds budget = std::chrono::milliseconds(2000));
+  ~NotifyDispatcher();
+
+  NotifyDispatcher(const NotifyDispatcher &) = delete;
+  NotifyDispatcher &operator=(const NotifyDispatcher &) = delete;
+
+  // Queues a notification and returns immediately.
+  void post(const std::string &area = "Environment");
+  // Blocks until everything posted so far was delivered, or `timeout`.
+  bool waitDelivered(std::chrono::milliseconds timeout);
+
+  uint64_t deliveredBatches() const;
+
+private:
+  struct State;
+  static void run(std::shared_ptr<State> state);
+
+  std::shared_ptr<State> state;
+  std::thread worker;
+  std::chrono::milliseconds budget;
+};
+
+} // namespace pathcore
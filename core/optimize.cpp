@@ -0,0 +1,122 @@
+#include "optimize.h"
+
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace pathcore {
+
+bool ReorderPlan::unchanged(const PathTable &table) const {
+  if (!dropped.empty() || order.size() != table.count(Scope::User))
+    return false;
+  for (size_t k = 0; k < order.size(); ++k)
+    if (order[k] != table.begin(Scope::User) + k)
+      return false;
+  return true;
+}
+
+ReorderPlan planReorder(const PathTable &table, const LookupProfiler &profiler,
+                        const Workload &workload, bool allowChanges) {
+  ReorderPlan plan;
+  std::vector<uint32_t> current = searchOrder(table);
+  std::vector<uint32_t> system(current.begin(),
+                               current.begin() + table.count(Scope::System));
+
+  // Names a system directory provides resolve there whatever the user
+  // order, so they never constrain it.
+  std::unordered_set<std::string> shadowed;
+  std::unordered_set<uint32_t> seen; // directories, as the profiler groups them
+  for (uint32_t i : system) {
+    seen.insert(profiler.directory(i));
+    for (const auto &file : profiler.files(i))
+      shadowed.insert(profiler.launchName(file));
+  }
+
+  std::vector<uint32_t> kept;
+  for (uint32_t i = table.begin(Scope::User); i < table.end(Scope::User); ++i) {
+    if (!seen.insert(profiler.directory(i)).second)
+      plan.dropped.emplace_back(i, ReorderPlan::Drop::Duplicate);
+    else if (profiler.files(i).empty())
+      plan.dropped.emplace_back(i, ReorderPlan::Drop::Empty);
+    else
+      kept.push_back(i);
+  }
+
+  // Launches each kept directory would serve. With the resolution fixed
+  // that is what it resolves today; otherwise whatever it could provide.
+  plan.before = profiler.profile(workload, current);
+  std::unordered_map<uint32_t, uint32_t> slot;
+  for (uint32_t k = 0; k < kept.size(); ++k)
+    slot.emplace(kept[k], k);
+  std::vector<double> weight(kept.size(), 0);
+  for (size_t w = 0; w < workload.names.size(); ++w) {
+    int64_t at = plan.before.lookups[w].resolvedAt;
+    if (at >= 0 && table.scope(static_cast<uint32_t>(at)) == Scope::System)
+      continue;
+    if (!allowChanges) {
+      auto it = slot.find(static_cast<uint32_t>(at));
+      if (it != slot.end())
+        weight[it->second] += workload.counts[w];
+      continue;
+    }
+    for (uint32_t k = 0; k < kept.size(); ++k)
+      if (profiler.resolve(workload.names[w], {kept[k]}).resolvedAt >= 0)
+        weight[k] += workload.counts[w];
+  }
+
+  // Precedence: the directory that provides a name first keeps providing it.
+  std::vector<std::vector<uint32_t>> after(kept.size());
+  std::vector<uint32_t> blockers(kept.size(), 0);
+  if (!allowChanges) {
+    std::unordered_map<std::string, uint32_t> provider;
+    std::unordered_set<uint64_t> edges;
+    for (uint32_t k = 0; k < kept.size(); ++k) {
+      for (const auto &file : profiler.files(kept[k])) {
+        std::string name = profiler.launchName(file);
+        if (shadowed.count(name))
+          continue;
+        auto [it, fresh] = provider.emplace(std::move(name), k);
+        if (fresh || !edges.insert(uint64_t(it->second) << 32 | k).second)
+          continue;
+        after[it->second].push_back(k);
+        blockers[k]++;
+      }
+    }
+  }
+
+  // Heaviest available directory first; ties keep the current order.
+  auto lighter = [&](uint32_t a, uint32_t b) {
+    return weight[a] != weight[b] ? weight[a] < weight[b] : a > b;
+  };
+  std::priority_queue<uint32_t, std::vector<uint32_t>, decltype(lighter)>
+      ready(lighter);
+  for (uint32_t k = 0; k < kept.size(); ++k)
+    if (blockers[k] == 0)
+      ready.push(k);
+  while (!ready.empty()) {
+    uint32_t k = ready.top();
+    ready.pop();
+    plan.order.push_back(kept[k]);
+    for (uint32_t next : after[k])
+      if (--blockers[next] == 0)
+        ready.push(next);
+  }
+
+  std::vector<uint32_t> proposed = system;
+  proposed.insert(proposed.end(), plan.order.begin(), plan.order.end());
+  plan.after = profiler.profile(workload, proposed);
+
+  for (size_t w = 0; w < workload.names.size(); ++w) {
+    const LookupCost &a = plan.before.lookups[w], &b = plan.after.lookups[w];
+    bool same = a.resolvedAt < 0
+                    ? b.resolvedAt < 0
+                    : b.resolvedAt >= 0 && a.file == b.file &&
+                          profiler.directory(static_cast<uint32_t>(a.resolvedAt)) ==
+                              profiler.directory(static_cast<uint32_t>(b.resolvedAt));
+    if (!same)
+      plan.changed.push_back(w);
+  }
+  return plan;
+}
+
+} // namespace pathcore
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "cost.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pathcore {
+
+// A proposed user PATH: which entries stay, in what order, and what that
+// is expected to save on the given workload.
+struct ReorderPlan {
+  enum class Drop : uint8_t { Empty, Duplicate };
+
+  std::vector<uint32_t> order; // table indexes of the kept user entries
+  std::vector<std::pair<uint32_t, Drop>> dropped;
+  CostReport before, after;
+  // Workload names that would resolve to a different file (only possible
+  // with allowChanges).
+  std::vector<size_t> changed;
+
+  // True if the plan would write back the same list.
+  bool unchanged(const PathTable &table) const;
+};
+
+// Reorders the user entries so the directories the workload resolves in
+// are searched first, and drops entries with no files or whose directory
+// is already searched earlier. Unless `allowChanges`, any two directories
+// that both provide a launch name keep their relative order, so every
+// name, in the workload or not, still resolves to the same file. System
+// entries are searched first and are left alone.
+ReorderPlan planReorder(const PathTable &table, const LookupProfiler &profiler,
+                        const Workload &workload, bool allowChanges = false);
+
+} // namespace pathcore
@@ -0,0 +1,107 @@
+#include "probe.h"
+#include "text.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <filesystem>
+
+namespace pathcore {
+
+bool ProbeCache::directoryExists(const std::string &path) {
+  return directoryExists(path, canonicalHash(path));
+}
+
+bool ProbeCache::directoryExists(const std::string &path, uint64_t keyHash) {
+  return kind(path, keyHash) == PathKind::Directory;
+}
+
+PathKind ProbeCache::kind(const std::string &path, uint64_t keyHash) {
+  {
+    std::shared_lock<std::shared_mutex> lock(mu);
+    auto it = known.find(keyHash);
+    if (it != known.end()) {
+      countEvent(Counter::ProbeHits);
+      return it->second;
+    }
+  }
+
+  PathKind found;
+  {
+    TraceSpan span(Phase::Probe);
+    countEvent(Counter::FileStats);
+    std::error_code ec;
+    auto st = std::filesystem::status(path, ec);
+    found = ec || !std::filesystem::exists(st) ? PathKind::Missing
+            : std::filesystem::is_directory(st) ? PathKind::Directory
+                                                : PathKind::File;
+  }
+  std::unique_lock<std::shared_mutex> lock(mu);
+  known.emplace(keyHash, found);
+  return found;
+}
+
+void ProbeCache::clear() {
+  std::unique_lock<std::shared_mutex> lock(mu);
+  known.clear();
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  OrderedProbes
+// ─────────────────────────────────────────────────────────────────────────────
+OrderedProbes::OrderedProbes(size_t count, std::function<bool(size_t)> probe,
+                             unsigned threads, size_t window)
+    : probe(std::move(probe)), count(count), window(std::max<size_t>(window, 1)),
+      state(count, 0) {
+  unsigned n = static_cast<unsigned>(
+      std::min<size_t>(std::max(threads, 1u), std::max<size_t>(count, 1)));
+  for (unsigned t = 0; t < n; ++t)
+    pool.emplace_back([this] { work(); });
+}
+
+OrderedProbes::~OrderedProbes() {
+  {
+    std::lock_guard<std::mutex> lock(mu);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto &t : pool)
+    t.join();
+}
+
+void OrderedProbes::work() {
+  for (;;) {
+    size_t k;
+    {
+      std::unique_lock<std::mutex> lock(mu);
+      wake.wait(lock, [&] {
+        return stopping || next >= count || next < consumed + window;
+      });
+      if (stopping || next >= count)
+        return;
+      k = next++;
+    }
+    bool result = probe(k);
+    {
+      std::lock_guard<std::mutex> lock(mu);
+      state[k] = result ? 2 : 1;
+    }
+    done.notify_all();
+  }
+}
+
+bool OrderedProbes::get(size_t k) {
+  std::unique_lock<std::mutex> lock(mu);
+  if (k + 1 > consumed) {
+    consumed = k + 1;
+    wake.notify_all(); // the window moved
+  }
+  done.wait(lock, [&] { return state[k] != 0; });
+  return state[k] == 2;
+}
+
+bool OrderedProbes::ready(size_t k) {
+  std::lock_guard<std::mutex> lock(mu);
+  return k < count && state[k] != 0;
+}
+
+} // namespace pathcore
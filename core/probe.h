@@ -0,0 +1,64 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace pathcore {
+
+enum class PathKind : uint8_t { Missing, File, Directory };
+
+// Remembers what each path names so each distinct entry is stat'ed once
+// per session, however many commands, scopes or variables reference it.
+// Safe to share between threads; the stat itself runs outside the lock.
+class ProbeCache {
+public:
+  bool directoryExists(const std::string &path);
+  // Same, for callers that already hold the entry's canonicalHash().
+  bool directoryExists(const std::string &path, uint64_t keyHash);
+  PathKind kind(const std::string &path, uint64_t keyHash);
+  void clear();
+
+private:
+  std::shared_mutex mu;
+  std::unordered_map<uint64_t, PathKind> known;
+};
+
+// Runs `probe(0..count-1)` on a worker pool while a consumer takes the
+// results in order, so output can start with the first result instead of
+// waiting for the slowest. Workers stay at most `window` items ahead of the
+// consumer; items never reached are never probed.
+class OrderedProbes {
+public:
+  OrderedProbes(size_t count, std::function<bool(size_t)> probe,
+                unsigned threads, size_t window = 64);
+  ~OrderedProbes();
+  OrderedProbes(const OrderedProbes &) = delete;
+  OrderedProbes &operator=(const OrderedProbes &) = delete;
+
+  // Blocks until item `k` is probed and returns its result; consumes every
+  // item before it.
+  bool get(size_t k);
+  // Whether get(k) would return without waiting.
+  bool ready(size_t k);
+
+private:
+  void work();
+
+  std::function<bool(size_t)> probe;
+  size_t count, window;
+  std::vector<uint8_t> state; // 0 pending, 1 false, 2 true
+  size_t next = 0, consumed = 0;
+  bool stopping = false;
+  std::mutex mu;
+  std::condition_variable wake, done;
+  std::vector<std::thread> pool;
+};
+
+} // namespace pathcore
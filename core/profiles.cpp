@@ -0,0 +1,259 @@
+#include "profiles.h"
+#include "lists.h"
+#include "text.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace pathcore {
+
+namespace {
+
+// Replaces %NAME% references found in `vars` (keys lowercased); anything
+// else is left for the machine expander.
+std::string substitute(const std::string &s,
+                       const std::unordered_map<std::string, std::string> &vars) {
+  std::string out;
+  size_t pos = 0;
+  for (;;) {
+    size_t open = s.find('%', pos);
+    size_t close = open == std::string::npos ? open : s.find('%', open + 1);
+    if (close == std::string::npos)
+      break;
+    auto it = vars.find(
+        toLower(std::string_view(s).substr(open + 1, close - open - 1)));
+    if (it == vars.end()) {
+      out.append(s, pos, close + 1 - pos);
+    } else {
+      out.append(s, pos, open - pos);
+      out += it->second;
+    }
+    pos = close + 1;
+  }
+  out.append(s, pos, std::string::npos);
+  return out;
+}
+
+#ifdef _WIN32
+const char *const profileListKey =
+    "SOFTWARE\\Microsoft\\Windows NT\\CurrentVersion\\ProfileList";
+
+// Local and domain accounts; service accounts have no interactive PATH.
+bool isUserSid(const std::string &sid) {
+  return sid.rfind("S-1-5-21-", 0) == 0;
+}
+#endif
+
+} // namespace
+
+std::string defaultProfileDir() {
+  if (const char *dir = std::getenv("PATHMGR_STORE"); dir && *dir)
+    return (fs::path(dir) / "users").string();
+#ifdef _WIN32
+  return "";
+#else
+  const char *home = std::getenv("HOME");
+  return (fs::path(home ? home : ".") / ".pathmgr" / "users").string();
+#endif
+}
+
+bool listProfiles(const std::string &dir, std::vector<UserProfile> &out,
+                  std::string &error) {
+  out.clear();
+  if (!dir.empty()) {
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end;
+         it.increment(ec)) {
+      std::error_code fileEc;
+      if (fs::is_regular_file(it->path() / "user.env", fileEc))
+        out.push_back({it->path().filename().string(), ""});
+    }
+    if (ec) {
+      error = "Cannot list profiles in " + dir + ": " + ec.message();
+      return false;
+    }
+  } else {
+#ifdef _WIN32
+    HKEY list;
+    LONG res =
+        RegOpenKeyExA(HKEY_LOCAL_MACHINE, profileListKey, 0, KEY_READ, &list);
+    if (res != ERROR_SUCCESS) {
+      error = "Failed to open ProfileList (code " + std::to_string(res) + ")";
+      return false;
+    }
+    char sid[256];
+    char home[MAX_PATH * 2];
+    for (DWORD i = 0;; ++i) {
+      DWORD sidLen = sizeof(sid);
+      if (RegEnumKeyExA(list, i, sid, &sidLen, nullptr, nullptr, nullptr,
+                        nullptr) != ERROR_SUCCESS)
+        break;
+      std::string id(sid, sidLen);
+      if (!isUserSid(id))
+        continue;
+      // RRF_RT_REG_SZ without RRF_NOEXPAND also accepts REG_EXPAND_SZ,
+      // expanded.
+      DWORD size = sizeof(home);
+      if (RegGetValueA(list, sid, "ProfileImagePath", RRF_RT_REG_SZ, nullptr,
+                       home, &size) != ERROR_SUCCESS)
+        home[0] = '\0';
+      out.push_back({std::move(id), home});
+    }
+    RegCloseKey(list);
+#else
+    error = "No profile directory to read; set PATHMGR_STORE or pass one.";
+    return false;
+#endif
+  }
+  std::sort(out.begin(), out.end(),
+            [](const auto &a, const auto &b) { return a.id < b.id; });
+  return true;
+}
+
+std::unique_ptr<EnvStore> openProfile(const std::string &dir,
+                                      const UserProfile &profile,
+                                      std::string &error) {
+  if (!dir.empty())
+    return std::make_unique<FileStore>((fs::path(dir) / profile.id).string(),
+                                       false);
+#ifdef _WIN32
+  HKEY root;
+  if (RegOpenKeyExA(HKEY_USERS, profile.id.c_str(), 0, KEY_READ, &root) ==
+      ERROR_SUCCESS)
+    return std::make_unique<RegistryStore>(root);
+
+  // Not logged on: load the hive for this process only; it unloads when
+  // the key is closed.
+  if (profile.home.empty()) {
+    error = "No profile directory recorded";
+    return nullptr;
+  }
+  std::string hive = (fs::path(profile.home) / "NTUSER.DAT").string();
+  LONG res =
+      RegLoadAppKeyA(hive.c_str(), &root, KEY_READ, REG_PROCESS_APPKEY, 0);
+  if (res != ERROR_SUCCESS) {
+    error = "Cannot load " + hive + " (code " + std::to_string(res) + ")";
+    return nullptr;
+  }
+  return std::make_unique<RegistryStore>(root);
+#else
+  (void)profile;
+  error = "No profile directory to read";
+  return nullptr;
+#endif
+}
+
+ProfilesReport auditProfiles(const std::string &dir,
+                             const std::vector<UserProfile> &profiles,
+                             const std::string &name, const PathTable &system,
+                             ProbeCache &probes, unsigned threads) {
+  ProfilesReport report;
+  report.profiles.resize(profiles.size());
+  std::unordered_set<uint64_t> systemKeys;
+  for (uint32_t i = system.begin(Scope::System); i < system.end(Scope::System);
+       ++i)
+    systemKeys.insert(system.keyHash(i));
+  ListKind kind = listKind(name);
+
+  // Distinct entries of each profile, for the cross-user pass below.
+  std::vector<std::vector<std::pair<uint64_t, std::string>>> distinct(
+      profiles.size());
+
+  std::atomic<size_t> next{0};
+  auto work = [&] {
+    Expander machine; // memoizes, so one per worker
+    for (size_t k; (k = next.fetch_add(1)) < profiles.size();) {
+      const UserProfile &profile = profiles[k];
+      ProfileAudit &audit = report.profiles[k];
+      audit.id = profile.id;
+
+      std::string error;
+      auto store = openProfile(dir, profile, error);
+      std::vector<NamedValue> values;
+      if (!store) {
+        audit.error = error;
+        continue;
+      }
+      if (!store->readAll(Scope::User, values)) {
+        audit.error = store->lastError();
+        continue;
+      }
+
+      std::unordered_map<std::string, std::string> vars;
+      if (!profile.home.empty())
+        vars["userprofile"] = profile.home;
+      std::string raw;
+      for (const auto &nv : values) {
+        if (iequals(nv.name, name))
+          raw = nv.value.data;
+        else
+          vars[toLower(nv.name)] = nv.value.data;
+      }
+
+      auto items = splitPath(raw);
+      audit.entries = static_cast<uint32_t>(items.size());
+      audit.length = raw.size();
+      std::unordered_set<uint64_t> seen;
+      for (const auto &item : items) {
+        std::string expanded = machine.expand(substitute(item, vars));
+        uint64_t key = canonicalHash(expanded);
+        if (!validEntry(kind, expanded, key, probes))
+          audit.invalid++;
+        if (!seen.insert(key).second) {
+          audit.duplicates++;
+          continue;
+        }
+        if (systemKeys.count(key))
+          audit.inSystem++;
+        else
+          distinct[k].emplace_back(key, std::move(expanded));
+      }
+    }
+  };
+  unsigned n = std::max(1u, std::min<unsigned>(
+                                threads, static_cast<unsigned>(profiles.size())));
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < n; ++t)
+    pool.emplace_back(work);
+  work();
+  for (auto &t : pool)
+    t.join();
+
+  // An entry is common if every readable profile has it; listed in the
+  // order the first such profile has them.
+  std::unordered_map<uint64_t, size_t> users;
+  for (size_t k = 0; k < profiles.size(); ++k) {
+    if (!report.profiles[k].error.empty())
+      continue;
+    report.readable++;
+    for (const auto &entry : distinct[k])
+      users[entry.first]++;
+  }
+  if (report.readable >= 2) {
+    for (size_t k = 0; k < profiles.size(); ++k) {
+      if (!report.profiles[k].error.empty())
+        continue;
+      for (const auto &[key, expanded] : distinct[k])
+        if (users[key] == report.readable)
+          report.common.push_back(expanded);
+      break;
+    }
+  }
+  return report;
+}
+
+} // namespace pathcore
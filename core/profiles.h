@@ -0,0 +1,65 @@
+#pragma once
+
+#include "probe.h"
+#include "store.h"
+#include "table.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pathcore {
+
+struct UserProfile {
+  std::string id;   // SID, or the stand-in directory name
+  std::string home; // profile directory, empty if unknown
+};
+
+// Where other users' Environment keys live. An empty `dir` means the
+// registry (Windows only): every user in ProfileList. Otherwise `dir` holds
+// one stand-in store per profile, `<dir>/<id>/user.env`.
+//
+// $PATHMGR_STORE/users when PATHMGR_STORE is set; the registry on Windows;
+// else ~/.pathmgr/users.
+std::string defaultProfileDir();
+
+// Lists profiles sorted by id.
+bool listProfiles(const std::string &dir, std::vector<UserProfile> &out,
+                  std::string &error);
+
+// Opens one profile's store; only its user scope is that profile's. A user
+// who is not logged on has their NTUSER.DAT loaded privately, which needs
+// read access to the file.
+std::unique_ptr<EnvStore> openProfile(const std::string &dir,
+                                      const UserProfile &profile,
+                                      std::string &error);
+
+struct ProfileAudit {
+  std::string id;
+  std::string error; // set if the profile could not be read
+  uint32_t entries = 0;
+  uint32_t invalid = 0;
+  uint32_t duplicates = 0; // repeats within the user's own value
+  uint32_t inSystem = 0;   // entries the system scope already provides
+  size_t length = 0;       // of the raw value
+};
+
+struct ProfilesReport {
+  std::vector<ProfileAudit> profiles; // in listing order
+  size_t readable = 0;
+  // Expanded entries every readable profile has (two or more profiles) and
+  // the system scope lacks: candidates to move there.
+  std::vector<std::string> common;
+};
+
+// Reads `name` from each profile on up to `threads` workers and audits its
+// user value. Entries expand against the profile's own variables and home
+// first, then this machine's environment. `system` supplies the system
+// scope entries; `probes` is shared by all workers.
+ProfilesReport auditProfiles(const std::string &dir,
+                             const std::vector<UserProfile> &profiles,
+                             const std::string &name, const PathTable &system,
+                             ProbeCache &probes, unsigned threads);
+
+} // namespace pathcore
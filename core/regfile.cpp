@@ -0,0 +1,573 @@
+#include "regfile.h"
+#include "text.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace pathcore {
+
+namespace {
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  UTF-16LE <-> UTF-8
+// ─────────────────────────────────────────────────────────────────────────────
+void appendUtf8(uint32_t cp, std::string &out) {
+  if (cp < 0x80) {
+    out += static_cast<char>(cp);
+  } else if (cp < 0x800) {
+    out += static_cast<char>(0xC0 | cp >> 6);
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    out += static_cast<char>(0xE0 | cp >> 12);
+    out += static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  } else {
+    out += static_cast<char>(0xF0 | cp >> 18);
+    out += static_cast<char>(0x80 | (cp >> 12 & 0x3F));
+    out += static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+    out += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+}
+
+// Appends `n` bytes of UTF-16LE as UTF-8; unpaired surrogates become
+// U+FFFD and a trailing odd byte is dropped.
+void utf16ToUtf8(const char *bytes, size_t n, std::string &out) {
+  const auto *p = reinterpret_cast<const unsigned char *>(bytes);
+  size_t units = n / 2;
+  for (size_t k = 0; k < units; ++k) {
+    uint32_t u = p[2 * k] | p[2 * k + 1] << 8;
+    if (u >= 0xD800 && u < 0xDC00 && k + 1 < units) {
+      uint32_t low = p[2 * k + 2] | p[2 * k + 3] << 8;
+      if (low >= 0xDC00 && low < 0xE000) {
+        appendUtf8(0x10000 + ((u - 0xD800) << 10) + (low - 0xDC00), out);
+        k++;
+        continue;
+      }
+    }
+    appendUtf8(u >= 0xD800 && u < 0xE000 ? 0xFFFD : u, out);
+  }
+}
+
+// Appends `s` as UTF-16LE bytes; malformed sequences become U+FFFD.
+void utf8ToUtf16(std::string_view s, std::string &out) {
+  auto unit = [&](uint32_t u) {
+    out += static_cast<char>(u & 0xFF);
+    out += static_cast<char>(u >> 8);
+  };
+  for (size_t k = 0; k < s.size();) {
+    auto c = static_cast<unsigned char>(s[k]);
+    uint32_t cp = 0xFFFD;
+    size_t len = c < 0x80 ? 1 : c >> 5 == 6 ? 2 : c >> 4 == 14 ? 3 : c >> 3 == 30 ? 4 : 0;
+    if (len == 1) {
+      cp = c;
+    } else if (len && k + len <= s.size()) {
+      cp = c & (0x7F >> len);
+      for (size_t j = 1; j < len; ++j) {
+        auto b = static_cast<unsigned char>(s[k + j]);
+        if ((b & 0xC0) != 0x80) {
+          cp = 0xFFFD;
+          len = j;
+          break;
+        }
+        cp = cp << 6 | (b & 0x3F);
+      }
+    } else {
+      len = 1;
+    }
+    k += len;
+    if (cp >= 0x10000) {
+      cp -= 0x10000;
+      unit(0xD800 + (cp >> 10));
+      unit(0xDC00 + (cp & 0x3FF));
+    } else {
+      unit(cp);
+    }
+  }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Physical lines
+// ─────────────────────────────────────────────────────────────────────────────
+// Hands out the raw bytes of one line at a time, still in the file's
+// encoding, without its line break. Lines lie in the block buffer when
+// they can; only a line that spans two blocks is copied.
+class LineReader {
+public:
+  explicit LineReader(std::istream &in) : in(in), block(size_t(1) << 20) {}
+
+  bool utf16() const { return wide; }
+
+  // The view stays valid until the next call.
+  bool next(std::string_view &line) {
+    if (!started) {
+      started = true;
+      if (!fill())
+        return false;
+      if (len >= 2 && block[0] == '\xFF' && block[1] == '\xFE') {
+        wide = true;
+        pos = 2;
+      } else if (len >= 3 && std::memcmp(block.data(), "\xEF\xBB\xBF", 3) == 0) {
+        pos = 3;
+      }
+    }
+    carry.clear();
+    for (;;) {
+      if (pos >= len && !fill()) {
+        if (carry.empty())
+          return false;
+        line = trim(carry);
+        return true;
+      }
+      size_t end = findBreak();
+      if (end == std::string::npos) {
+        carry.append(block.data() + pos, len - pos);
+        pos = len;
+        continue;
+      }
+      std::string_view here(block.data() + pos, end - pos);
+      pos = end + (wide ? 2 : 1);
+      if (carry.empty()) {
+        line = trim(here);
+      } else {
+        carry.append(here);
+        line = trim(carry);
+      }
+      return true;
+    }
+  }
+
+private:
+  bool fill() {
+    if (!in)
+      return false;
+    in.read(block.data(), static_cast<std::streamsize>(block.size()));
+    len = static_cast<size_t>(in.gcount());
+    pos = 0;
+    return len > 0;
+  }
+
+  // Offset of the next '\n' code unit in the block, or npos. Blocks are an
+  // even number of bytes, so UTF-16 units start at even offsets.
+  size_t findBreak() const {
+    const char *base = block.data();
+    for (size_t from = pos; from < len;) {
+      const void *hit = std::memchr(base + from, '\n', len - from);
+      if (!hit)
+        return std::string::npos;
+      size_t at = static_cast<const char *>(hit) - base;
+      if (!wide || (at % 2 == 0 && at + 1 < len && base[at + 1] == '\0'))
+        return at;
+      from = at + 1;
+    }
+    return std::string::npos;
+  }
+
+  std::string_view trim(std::string_view line) const {
+    if (wide && line.size() >= 2 && line[line.size() - 2] == '\r' &&
+        line.back() == '\0')
+      line.remove_suffix(2);
+    else if (!wide && !line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    return line;
+  }
+
+  std::istream &in;
+  std::vector<char> block;
+  size_t pos = 0, len = 0;
+  std::string carry;
+  bool started = false, wide = false;
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Value lines
+// ─────────────────────────────────────────────────────────────────────────────
+// Reads a "quoted" string at `i`, undoing regedit's \\ and \" escapes.
+bool unquote(std::string_view s, size_t &i, std::string &out) {
+  if (i >= s.size() || s[i] != '"')
+    return false;
+  for (++i; i < s.size(); ++i) {
+    if (s[i] == '"') {
+      ++i;
+      return true;
+    }
+    if (s[i] == '\\' && i + 1 < s.size() && (s[i + 1] == '\\' || s[i + 1] == '"'))
+      ++i;
+    out += s[i];
+  }
+  return false;
+}
+
+int hexDigit(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+// Comma-separated hex bytes; spaces are ignored.
+bool hexBytes(std::string_view s, std::string &out) {
+  for (size_t i = 0; i < s.size();) {
+    if (s[i] == ',' || s[i] == ' ' || s[i] == '\t') {
+      ++i;
+      continue;
+    }
+    if (i + 1 >= s.size())
+      return false;
+    int hi = hexDigit(s[i]), lo = hexDigit(s[i + 1]);
+    if (hi < 0 || lo < 0)
+      return false;
+    out += static_cast<char>(hi << 4 | lo);
+    i += 2;
+  }
+  return true;
+}
+
+// UTF-16LE string data as UTF-8, without its terminating NULs.
+std::string wideText(const std::string &bytes) {
+  std::string text;
+  utf16ToUtf8(bytes.data(), bytes.size(), text);
+  while (!text.empty() && text.back() == '\0')
+    text.pop_back();
+  return text;
+}
+
+bool parseValue(std::string_view line, RegValue &v) {
+  size_t i = 0;
+  if (line.empty())
+    return false;
+  if (line[0] == '@')
+    i = 1;
+  else if (!unquote(line, i, v.name))
+    return false;
+  while (i < line.size() && line[i] == ' ')
+    ++i;
+  if (i >= line.size() || line[i] != '=')
+    return false;
+  std::string_view data = line.substr(i + 1);
+  while (!data.empty() && data.front() == ' ')
+    data.remove_prefix(1);
+
+  if (data == "-") {
+    v.deleted = true;
+    return true;
+  }
+  if (!data.empty() && data[0] == '"') {
+    size_t k = 0;
+    v.type = RegType::String;
+    return unquote(data, k, v.data);
+  }
+  if (data.compare(0, 6, "dword:") == 0) {
+    uint32_t n = static_cast<uint32_t>(
+        std::strtoul(std::string(data.substr(6)).c_str(), nullptr, 16));
+    v.type = RegType::Dword;
+    v.data.assign(reinterpret_cast<const char *>(&n), 4);
+    return true;
+  }
+  if (data.compare(0, 3, "hex") != 0)
+    return false;
+
+  int kind = 3; // hex: is REG_BINARY
+  size_t colon = data.find(':');
+  if (colon == std::string_view::npos)
+    return false;
+  if (data[3] == '(')
+    kind = static_cast<int>(
+        std::strtol(std::string(data.substr(4, colon - 4)).c_str(), nullptr, 16));
+  std::string bytes;
+  if (!hexBytes(data.substr(colon + 1), bytes))
+    return false;
+  switch (kind) {
+  case 1:
+  case 2:
+    v.type = kind == 1 ? RegType::String : RegType::ExpandString;
+    v.data = wideText(bytes);
+    break;
+  case 7:
+    v.type = RegType::MultiString;
+    v.data = wideText(bytes);
+    std::replace(v.data.begin(), v.data.end(), '\0', '\n');
+    break;
+  case 0xb:
+    v.type = RegType::Qword;
+    v.data = std::move(bytes);
+    break;
+  default:
+    v.type = RegType::Binary;
+    v.data = std::move(bytes);
+    break;
+  }
+  return true;
+}
+
+// First character of a raw line, or 0x80 for anything outside ASCII.
+char firstChar(std::string_view raw, bool wide) {
+  if (raw.empty())
+    return '\0';
+  if (wide && (raw.size() < 2 || raw[1] != '\0'))
+    return '\x80';
+  return raw[0];
+}
+
+bool endsWithBackslash(std::string_view raw, bool wide) {
+  if (wide)
+    return raw.size() >= 2 && raw[raw.size() - 2] == '\\' && raw.back() == '\0';
+  return !raw.empty() && raw.back() == '\\';
+}
+
+} // namespace
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Reading
+// ─────────────────────────────────────────────────────────────────────────────
+bool readRegFile(const std::string &file,
+                 const std::function<bool(const std::string &key)> &wantKey,
+                 const std::function<void(const std::string &key,
+                                          RegValue &&value)> &onValue,
+                 std::string &error) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in) {
+    error = "Cannot open " + file;
+    return false;
+  }
+  LineReader reader(in);
+  std::string_view raw;
+  std::string line;
+  auto decode = [&](std::string_view r, std::string &out) {
+    if (reader.utf16())
+      utf16ToUtf8(r.data(), r.size(), out);
+    else
+      out.append(r);
+  };
+
+  if (!reader.next(raw)) {
+    error = file + " is empty";
+    return false;
+  }
+  decode(raw, line);
+  if (line != "Windows Registry Editor Version 5.00" && line != "REGEDIT4") {
+    error = file + " is not a .reg file (no version header)";
+    return false;
+  }
+
+  std::string key;
+  bool want = false, continuing = false;
+  line.clear();
+  while (reader.next(raw)) {
+    bool wide = reader.utf16();
+    if (continuing) {
+      continuing = endsWithBackslash(raw, wide);
+      if (!want)
+        continue;
+      std::string part;
+      decode(raw, part);
+      size_t start = part.find_first_not_of(" \t");
+      line.append(part, start == std::string::npos ? part.size() : start);
+      if (continuing) {
+        line.pop_back();
+        continue;
+      }
+    } else {
+      char c = firstChar(raw, wide);
+      if (c == '[') {
+        key.clear();
+        decode(raw, key);
+        size_t close = key.rfind(']');
+        bool removed = key.size() > 1 && key[1] == '-';
+        key = key.substr(removed ? 2 : 1,
+                         close == std::string::npos ? std::string::npos
+                                                    : close - (removed ? 2 : 1));
+        want = !removed && wantKey(key);
+        continue;
+      }
+      continuing = endsWithBackslash(raw, wide);
+      if (!want || c == ';' || raw.empty())
+        continue;
+      line.clear();
+      decode(raw, line);
+      if (continuing) {
+        line.pop_back();
+        continue;
+      }
+    }
+
+    RegValue v;
+    if (parseValue(line, v))
+      onValue(key, std::move(v));
+  }
+  return true;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Environment keys
+// ─────────────────────────────────────────────────────────────────────────────
+const char *environmentKey(Scope scope) {
+  return scope == Scope::System
+             ? "HKEY_LOCAL_MACHINE\\SYSTEM\\CurrentControlSet\\Control\\"
+               "Session Manager\\Environment"
+             : "HKEY_CURRENT_USER\\Environment";
+}
+
+bool environmentScope(std::string_view key, Scope &scope, std::string &sid) {
+  auto startsWith = [&](std::string_view p) {
+    return key.size() >= p.size() && iequals(key.substr(0, p.size()), p);
+  };
+  auto endsWith = [&](std::string_view s) {
+    return key.size() >= s.size() &&
+           iequals(key.substr(key.size() - s.size()), s);
+  };
+
+  sid.clear();
+  if (iequals(key, "HKEY_CURRENT_USER\\Environment")) {
+    scope = Scope::User;
+    return true;
+  }
+  if (startsWith("HKEY_USERS\\") && endsWith("\\Environment")) {
+    std::string_view middle = key.substr(11, key.size() - 11 - 12);
+    if (middle.empty() || middle.find('\\') != std::string_view::npos)
+      return false;
+    scope = Scope::User;
+    sid = std::string(middle);
+    return true;
+  }
+  if (startsWith("HKEY_LOCAL_MACHINE\\") &&
+      endsWith("\\Control\\Session Manager\\Environment")) {
+    scope = Scope::System;
+    return true;
+  }
+  return false;
+}
+
+bool importEnvironment(const std::string &file, const std::string &sid,
+                       RegEnvironment &out, std::string &error) {
+  out = RegEnvironment{};
+  std::string systemKey;
+  Scope current = Scope::User;
+
+  // The live control set wins over numbered copies of it
+  auto wantKey = [&](const std::string &key) {
+    Scope scope;
+    std::string keySid;
+    if (!environmentScope(key, scope, keySid))
+      return false;
+    if (scope == Scope::System) {
+      bool live = key.find("\\CurrentControlSet\\") != std::string::npos;
+      if (!systemKey.empty() && !iequals(key, systemKey)) {
+        if (!live || systemKey.find("\\CurrentControlSet\\") != std::string::npos)
+          return false;
+        out.values[static_cast<int>(Scope::System)].clear();
+      }
+      systemKey = key;
+      current = Scope::System;
+      return true;
+    }
+
+    bool chosen = !sid.empty() ? iequals(keySid, sid)
+                               : out.userKey.empty()
+                                     ? !iequals(keySid, ".DEFAULT")
+                                     : iequals(key, out.userKey);
+    if (!chosen) {
+      if (!keySid.empty() &&
+          std::find(out.otherUsers.begin(), out.otherUsers.end(), keySid) ==
+              out.otherUsers.end())
+        out.otherUsers.push_back(keySid);
+      return false;
+    }
+    out.userKey = key;
+    current = Scope::User;
+    return true;
+  };
+
+  auto onValue = [&](const std::string &, RegValue &&v) {
+    if (v.deleted ||
+        (v.type != RegType::String && v.type != RegType::ExpandString)) {
+      out.skipped++;
+      return;
+    }
+    auto &values = out.values[static_cast<int>(current)];
+    StoreValue sv{std::move(v.data),
+                  v.type == RegType::String ? ValueKind::String
+                                            : ValueKind::ExpandString,
+                  true, 0};
+    auto it = std::find_if(values.begin(), values.end(), [&](const NamedValue &n) {
+      return iequals(n.name, v.name);
+    });
+    if (it != values.end())
+      it->value = std::move(sv);
+    else
+      values.push_back(NamedValue{std::move(v.name), std::move(sv)});
+  };
+
+  return readRegFile(file, wantKey, onValue, error);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Writing
+// ─────────────────────────────────────────────────────────────────────────────
+namespace {
+
+std::string quote(const std::string &s) {
+  std::string out = "\"";
+  for (char c : s) {
+    if (c == '\\' || c == '"')
+      out += '\\';
+    out += c;
+  }
+  return out + "\"";
+}
+
+} // namespace
+
+RegWriter::RegWriter(std::ostream &out, RegEncoding encoding)
+    : out(out), encoding(encoding) {
+  if (encoding == RegEncoding::Utf16)
+    out.write("\xFF\xFE", 2);
+  put("Windows Registry Editor Version 5.00\r\n");
+}
+
+void RegWriter::put(std::string_view text) {
+  if (encoding == RegEncoding::Utf8) {
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    return;
+  }
+  buffer.clear();
+  utf8ToUtf16(text, buffer);
+  out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+void RegWriter::key(const std::string &path) { put("\r\n[" + path + "]\r\n"); }
+
+void RegWriter::value(const std::string &name, const std::string &data,
+                      ValueKind kind) {
+  std::string line = (name.empty() ? "@" : quote(name)) + "=";
+  if (kind == ValueKind::String) {
+    put(line + quote(data) + "\r\n");
+    return;
+  }
+
+  // REG_EXPAND_SZ: the UTF-16LE bytes with their NUL, as regedit wraps them
+  static const char digits[] = "0123456789abcdef";
+  std::string bytes;
+  utf8ToUtf16(data, bytes);
+  bytes.append(2, '\0');
+  line += "hex(2):";
+  for (size_t k = 0; k < bytes.size(); ++k) {
+    auto b = static_cast<unsigned char>(bytes[k]);
+    line += digits[b >> 4];
+    line += digits[b & 15];
+    if (k + 1 == bytes.size())
+      break;
+    line += ',';
+    if (line.size() >= 77) {
+      put(line + "\\\r\n");
+      line = "  ";
+    }
+  }
+  put(line + "\r\n");
+}
+
+} // namespace pathcore
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "store.h"
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pathcore {
+
+// Registry value types a .reg file spells out.
+enum class RegType : uint8_t {
+  String,       // "text" or hex(1):
+  ExpandString, // hex(2):
+  MultiString,  // hex(7):
+  Dword,        // dword:
+  Qword,        // hex(b):
+  Binary,       // hex: and every other hex(n):
+};
+
+// One value line of a .reg file, decoded.
+struct RegValue {
+  std::string name; // empty for the default value (@)
+  RegType type = RegType::String;
+  // UTF-8 text for the string types, without the terminating NUL; items
+  // of a multi-string are separated by '\n'. Raw bytes otherwise.
+  std::string data;
+  bool deleted = false; // "Name"=-
+};
+
+// Streams a .reg file (regedit's UTF-16LE, or UTF-8 with or without a
+// BOM) in fixed-size blocks, joining `\` continuation lines. `wantKey` is
+// asked once per [key] section; values of sections it declines are
+// skipped without being decoded, so whole-hive exports are read at about
+// the speed of the disk, in constant memory.
+bool readRegFile(const std::string &file,
+                 const std::function<bool(const std::string &key)> &wantKey,
+                 const std::function<void(const std::string &key,
+                                          RegValue &&value)> &onValue,
+                 std::string &error);
+
+// Key the Environment values of `scope` live under when exported.
+const char *environmentKey(Scope scope);
+
+// Whether `key` is an Environment key, and whose: HKEY_CURRENT_USER or
+// HKEY_USERS\<sid> for a user (`sid` set for the latter), any control set
+// of a live or offline SYSTEM hive for the machine.
+bool environmentScope(std::string_view key, Scope &scope, std::string &sid);
+
+struct RegEnvironment {
+  std::vector<NamedValue> values[2]; // by Scope; REG_SZ and REG_EXPAND_SZ
+  std::string userKey;               // the user key the values came from
+  std::vector<std::string> otherUsers; // HKEY_USERS SIDs not imported
+  size_t skipped = 0; // deletions and values of other types
+};
+
+// Pulls the Environment values out of a .reg file in one pass. User values
+// come from the HKEY_USERS\`sid` key if given, else from the first user
+// key in the file (HKEY_CURRENT_USER or a SID other than .DEFAULT).
+bool importEnvironment(const std::string &file, const std::string &sid,
+                       RegEnvironment &out, std::string &error);
+
+enum class RegEncoding : uint8_t { Utf16, Utf8 };
+
+// Writes a .reg file as regedit does: a version header, then [key]
+// sections of values, REG_EXPAND_SZ as hex(2): wrapped at 80 columns.
+// Everything goes straight to `out`, encoded as it is written.
+class RegWriter {
+public:
+  RegWriter(std::ostream &out, RegEncoding encoding);
+
+  void key(const std::string &path);
+  void value(const std::string &name, const std::string &data, ValueKind kind);
+  bool ok() const { return static_cast<bool>(out); }
+
+private:
+  void put(std::string_view text);
+
+  std::ostream &out;
+  RegEncoding encoding;
+  std::string buffer; // reused for transcoding
+};
+
+} // namespace pathcore
@@ -0,0 +1,68 @@
+#include "render.h"
+#include "text.h"
+
+namespace pathcore {
+
+namespace {
+
+// Left-aligned in `width` bytes, cut if longer.
+void appendPadded(std::string &out, std::string_view s, size_t width) {
+  if (s.size() >= width) {
+    out.append(s.substr(0, width));
+    return;
+  }
+  out.append(s);
+  out.append(width - s.size(), ' ');
+}
+
+void appendStyled(std::string &out, const std::string &style,
+                  std::string_view s, const std::string &reset) {
+  out += style;
+  out.append(s);
+  out += reset;
+}
+
+} // namespace
+
+std::vector<uint32_t> searchEntries(const PathTable &table,
+                                    std::string_view term) {
+  std::vector<uint32_t> hits;
+  for (uint32_t i = 0; i < table.size(); ++i)
+    if (icontains(table.expanded(i), term))
+      hits.push_back(i);
+  return hits;
+}
+
+std::string shortenPath(std::string_view path, size_t maxLength) {
+  if (path.size() <= maxLength)
+    return std::string(path);
+  return "..." + std::string(path.substr(path.size() - maxLength + 3));
+}
+
+void appendListRow(std::string &out, const ListStyle &style,
+                   const PathTable &table, uint32_t i, bool exists,
+                   bool last) {
+  bool user = table.scope(i) == Scope::User;
+  appendStyled(out, style.frame, "│", style.reset);
+  out += style.index;
+  appendPadded(out, std::to_string(i + 1), 3);
+  out += style.reset;
+  appendStyled(out, style.frame, " │ ", style.reset);
+  appendStyled(out, exists ? style.good : style.bad, exists ? "✅" : "❌",
+               style.reset);
+  appendStyled(out, style.frame, " │ ", style.reset);
+  appendStyled(out, user ? style.user : style.system,
+               user ? "USER " : "SYS  ", style.reset);
+  appendStyled(out, style.frame, " │ ", style.reset);
+  out += style.text;
+  appendPadded(out, shortenPath(table.expanded(i), 60), 60);
+  out += style.reset;
+  appendStyled(out, style.frame, " │\n", style.reset);
+  if (!last)
+    appendStyled(out, style.frame,
+                 "├────┼─────┼──────┼──────────────────────────────────────────"
+                 "────────────────────┤\n",
+                 style.reset);
+}
+
+} // namespace pathcore
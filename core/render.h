@@ -0,0 +1,32 @@
+#pragma once
+
+#include "table.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pathcore {
+
+// Indexes of the entries whose expanded form contains `term`, ignoring
+// case, in table order. What `search` lists.
+std::vector<uint32_t> searchEntries(const PathTable &table,
+                                    std::string_view term);
+
+// `path` cut to its last `maxLength` bytes, led by "...", if longer.
+std::string shortenPath(std::string_view path, size_t maxLength);
+
+// Escape sequences the `show` table wraps its columns in; all empty for
+// plain text.
+struct ListStyle {
+  std::string frame, index, good, bad, user, system, text, reset;
+};
+
+// Appends the `show` table row for entry `i`, followed by the separator
+// to the next row unless `last`.
+void appendListRow(std::string &out, const ListStyle &style,
+                   const PathTable &table, uint32_t i, bool exists,
+                   bool last);
+
+} // namespace pathcore
@@ -0,0 +1,321 @@
+#include "screen.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+#else
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace pathcore {
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Terminal
+// ─────────────────────────────────────────────────────────────────────────────
+namespace {
+
+const char enterScreen[] = "\033[?1049h\033[?25l";
+const char leaveScreen[] = "\033[0m\033[?25h\033[?1049l";
+
+#ifndef _WIN32
+termios savedMode;
+
+// Installed without SA_RESTART so a resize interrupts a blocking read().
+void onResize(int) {}
+
+// Next input byte if one arrives within `ms`, else -1.
+int nextByte(int ms) {
+  pollfd pfd{STDIN_FILENO, POLLIN, 0};
+  unsigned char c;
+  if (::poll(&pfd, 1, ms) <= 0 || ::read(STDIN_FILENO, &c, 1) != 1)
+    return -1;
+  return c;
+}
+
+// Decodes the rest of an escape sequence: CSI or SS3, numeric parameter,
+// final byte. A lone ESC is the Escape key.
+Key decodeEscape() {
+  int intro = nextByte(30);
+  if (intro != '[' && intro != 'O')
+    return {KeyCode::Escape};
+  int param = 0, c;
+  while ((c = nextByte(30)) >= '0' && c <= ';')
+    if (c >= '0' && c <= '9')
+      param = param * 10 + (c - '0');
+  switch (c) {
+  case 'A': return {KeyCode::Up};
+  case 'B': return {KeyCode::Down};
+  case 'C': return {KeyCode::Right};
+  case 'D': return {KeyCode::Left};
+  case 'H': return {KeyCode::Home};
+  case 'F': return {KeyCode::End};
+  case '~':
+    switch (param) {
+    case 1: case 7: return {KeyCode::Home};
+    case 4: case 8: return {KeyCode::End};
+    case 3: return {KeyCode::Delete};
+    case 5: return {KeyCode::PageUp};
+    case 6: return {KeyCode::PageDown};
+    }
+  }
+  return {KeyCode::None};
+}
+#endif
+
+} // namespace
+
+#ifdef _WIN32
+Terminal::Terminal() {
+  HANDLE in = GetStdHandle(STD_INPUT_HANDLE);
+  HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+  DWORD inM, outM;
+  if (!GetConsoleMode(in, &inM) || !GetConsoleMode(out, &outM))
+    return;
+  inMode = inM;
+  outMode = outM;
+  SetConsoleMode(in, ENABLE_EXTENDED_FLAGS | ENABLE_WINDOW_INPUT);
+  SetConsoleMode(out, outM | ENABLE_PROCESSED_OUTPUT |
+                          ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+  active = true;
+  write(enterScreen);
+}
+
+Terminal::~Terminal() {
+  if (!active)
+    return;
+  write(leaveScreen);
+  SetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), inMode);
+  SetConsoleMode(GetStdHandle(STD_OUTPUT_HANDLE), outMode);
+}
+
+void Terminal::size(int &rows, int &cols) const {
+  CONSOLE_SCREEN_BUFFER_INFO info;
+  if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info)) {
+    rows = info.srWindow.Bottom - info.srWindow.Top + 1;
+    cols = info.srWindow.Right - info.srWindow.Left + 1;
+  } else {
+    rows = 24;
+    cols = 80;
+  }
+}
+
+Key Terminal::read() {
+  HANDLE in = GetStdHandle(STD_INPUT_HANDLE);
+  char32_t high = 0; // pending UTF-16 high surrogate
+  for (;;) {
+    INPUT_RECORD rec;
+    DWORD n = 0;
+    if (!ReadConsoleInputW(in, &rec, 1, &n) || n == 0)
+      return {};
+    if (rec.EventType == WINDOW_BUFFER_SIZE_EVENT)
+      return {};
+    if (rec.EventType != KEY_EVENT || !rec.Event.KeyEvent.bKeyDown)
+      continue;
+    switch (rec.Event.KeyEvent.wVirtualKeyCode) {
+    case VK_UP: return {KeyCode::Up};
+    case VK_DOWN: return {KeyCode::Down};
+    case VK_LEFT: return {KeyCode::Left};
+    case VK_RIGHT: return {KeyCode::Right};
+    case VK_PRIOR: return {KeyCode::PageUp};
+    case VK_NEXT: return {KeyCode::PageDown};
+    case VK_HOME: return {KeyCode::Home};
+    case VK_END: return {KeyCode::End};
+    case VK_DELETE: return {KeyCode::Delete};
+    case VK_RETURN: return {KeyCode::Enter};
+    case VK_ESCAPE: return {KeyCode::Escape};
+    case VK_BACK: return {KeyCode::Backspace};
+    case VK_TAB: return {KeyCode::Tab};
+    }
+    char32_t u = rec.Event.KeyEvent.uChar.UnicodeChar;
+    if (u >= 0xD800 && u < 0xDC00) {
+      high = u;
+      continue;
+    }
+    if (u >= 0xDC00 && u < 0xE000 && high)
+      u = 0x10000 + ((high - 0xD800) << 10) + (u - 0xDC00);
+    if (u)
+      return {KeyCode::Char, u};
+  }
+}
+
+void Terminal::write(std::string_view bytes) {
+  DWORD written;
+  WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), bytes.data(),
+            static_cast<DWORD>(bytes.size()), &written, nullptr);
+}
+#else
+Terminal::Terminal() {
+  if (!::isatty(STDIN_FILENO) || !::isatty(STDOUT_FILENO) ||
+      ::tcgetattr(STDIN_FILENO, &savedMode) != 0)
+    return;
+  termios raw = savedMode;
+  raw.c_lflag &= ~(ICANON | ECHO | ISIG | IEXTEN);
+  raw.c_iflag &= ~(IXON | ICRNL);
+  raw.c_cc[VMIN] = 1;
+  raw.c_cc[VTIME] = 0;
+  ::tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+
+  struct sigaction sa {};
+  sa.sa_handler = onResize;
+  ::sigaction(SIGWINCH, &sa, nullptr);
+  active = true;
+  write(enterScreen);
+}
+
+Terminal::~Terminal() {
+  if (!active)
+    return;
+  write(leaveScreen);
+  ::signal(SIGWINCH, SIG_DFL);
+  ::tcsetattr(STDIN_FILENO, TCSAFLUSH, &savedMode);
+}
+
+void Terminal::size(int &rows, int &cols) const {
+  winsize ws{};
+  if (::ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row && ws.ws_col) {
+    rows = ws.ws_row;
+    cols = ws.ws_col;
+  } else {
+    rows = 24;
+    cols = 80;
+  }
+}
+
+Key Terminal::read() {
+  unsigned char c;
+  if (::read(STDIN_FILENO, &c, 1) != 1)
+    return {}; // EINTR from a resize, or end of input
+  switch (c) {
+  case 27: return decodeEscape();
+  case '\r': case '\n': return {KeyCode::Enter};
+  case 127: case 8: return {KeyCode::Backspace};
+  case '\t': return {KeyCode::Tab};
+  }
+  if (c < 0x80)
+    return {KeyCode::Char, c};
+
+  // UTF-8 lead byte and its continuation bytes
+  int more = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : 1;
+  char32_t u = c & (0x3F >> more);
+  while (more--) {
+    int b = nextByte(30);
+    if (b < 0)
+      return {};
+    u = (u << 6) | (b & 0x3F);
+  }
+  return {KeyCode::Char, u};
+}
+
+void Terminal::write(std::string_view bytes) {
+  while (!bytes.empty()) {
+    ssize_t n = ::write(STDOUT_FILENO, bytes.data(), bytes.size());
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return;
+    bytes.remove_prefix(static_cast<size_t>(n));
+  }
+}
+#endif
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Screen
+// ─────────────────────────────────────────────────────────────────────────────
+uint16_t Screen::style(const std::string &sgr) {
+  auto it = std::find(styles.begin(), styles.end(), sgr);
+  if (it != styles.end())
+    return static_cast<uint16_t>(it - styles.begin());
+  styles.push_back(sgr);
+  return static_cast<uint16_t>(styles.size() - 1);
+}
+
+void Screen::resize(int rows, int cols) {
+  height = std::max(rows, 0);
+  width = std::max(cols, 0);
+  front.assign(static_cast<size_t>(height) * width, Cell{});
+  back.assign(front.size(), Cell{});
+  repaint = true;
+}
+
+void Screen::clear() { std::fill(back.begin(), back.end(), Cell{}); }
+
+int Screen::put(int row, int col, std::string_view text, uint16_t style) {
+  if (row < 0 || row >= height)
+    return col;
+  size_t i = 0;
+  while (i < text.size() && col < width) {
+    unsigned char lead = static_cast<unsigned char>(text[i]);
+    size_t len = lead < 0x80 ? 1 : lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : 2;
+    len = std::min(len, text.size() - i);
+    uint32_t glyph = 0;
+    for (size_t k = 0; k < len; ++k)
+      glyph |= static_cast<uint32_t>(static_cast<unsigned char>(text[i + k]))
+               << (8 * k);
+    i += len;
+    if (col >= 0)
+      back[static_cast<size_t>(row) * width + col] = Cell{glyph, style};
+    ++col;
+  }
+  return col;
+}
+
+void Screen::fill(int row, int col, uint16_t style) {
+  if (row < 0 || row >= height)
+    return;
+  for (int c = std::max(col, 0); c < width; ++c)
+    back[static_cast<size_t>(row) * width + c] = Cell{' ', style};
+}
+
+void Screen::invalidate() { repaint = true; }
+
+std::string Screen::flush() {
+  std::string out;
+  if (repaint)
+    out += "\033[0m\033[2J";
+  int atRow = -1, atCol = -1, atStyle = -1;
+  for (int r = 0; r < height; ++r) {
+    for (int c = 0; c < width; ++c) {
+      size_t i = static_cast<size_t>(r) * width + c;
+      const Cell &cell = back[i];
+      if (!repaint && !(cell != front[i]))
+        continue;
+      // A blank on a freshly cleared screen is already there
+      if (repaint && cell.glyph == ' ' && cell.style == 0) {
+        front[i] = cell;
+        continue;
+      }
+      if (r != atRow || c != atCol) {
+        out += "\033[" + std::to_string(r + 1) + ";" + std::to_string(c + 1) +
+               "H";
+        atRow = r;
+      }
+      if (cell.style != atStyle) {
+        out += "\033[0m";
+        out += styles[cell.style];
+        atStyle = cell.style;
+      }
+      for (uint32_t g = cell.glyph; g; g >>= 8)
+        out += static_cast<char>(g & 0xFF);
+      atCol = c + 1;
+      front[i] = cell;
+    }
+  }
+  if (!out.empty())
+    out += "\033[0m";
+  repaint = false;
+  return out;
+}
+
+} // namespace pathcore
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pathcore {
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Terminal: raw keyboard input and the alternate screen
+// ─────────────────────────────────────────────────────────────────────────────
+enum class KeyCode : uint8_t {
+  None, // nothing read (interrupted, e.g. by a resize)
+  Char,
+  Enter,
+  Escape,
+  Backspace,
+  Delete,
+  Tab,
+  Up,
+  Down,
+  Left,
+  Right,
+  PageUp,
+  PageDown,
+  Home,
+  End,
+};
+
+struct Key {
+  KeyCode code = KeyCode::None;
+  char32_t ch = 0; // for Char
+};
+
+// Puts the console in raw mode on the alternate screen for its lifetime,
+// and restores it on destruction.
+class Terminal {
+public:
+  Terminal();
+  ~Terminal();
+  Terminal(const Terminal &) = delete;
+  Terminal &operator=(const Terminal &) = delete;
+
+  // False if stdin or stdout is not an interactive console.
+  bool ok() const { return active; }
+  void size(int &rows, int &cols) const;
+  // Blocks for one key press.
+  Key read();
+  void write(std::string_view bytes);
+
+private:
+  bool active = false;
+#ifdef _WIN32
+  unsigned long inMode = 0, outMode = 0;
+#endif
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Screen: a cell buffer redrawn by diffing against what is displayed
+// ─────────────────────────────────────────────────────────────────────────────
+// Frames are drawn into a back buffer with put(); flush() then emits only
+// the cells that differ from the previous frame, with cursor moves between
+// runs and a style change only where the style does. Each code point takes
+// one column.
+class Screen {
+public:
+  // Styles are escape sequences applied after a reset; 0 is the plain style.
+  uint16_t style(const std::string &sgr);
+
+  // Resizes both buffers; the next flush repaints everything.
+  void resize(int rows, int cols);
+  int rows() const { return height; }
+  int cols() const { return width; }
+
+  // Blanks the back buffer.
+  void clear();
+  // Draws UTF-8 `text` from (row, col), clipped to the row; returns the
+  // column after the last cell written.
+  int put(int row, int col, std::string_view text, uint16_t style = 0);
+  // Pads the rest of `row` from `col` with blanks in `style`.
+  void fill(int row, int col, uint16_t style = 0);
+
+  // Escape sequences that turn the displayed frame into the back buffer,
+  // which becomes the displayed one.
+  std::string flush();
+  // Forgets what is displayed, so the next flush repaints everything.
+  void invalidate();
+
+private:
+  struct Cell {
+    uint32_t glyph = ' '; // UTF-8 bytes of one code point, packed
+    uint16_t style = 0;
+    bool operator!=(const Cell &o) const {
+      return glyph != o.glyph || style != o.style;
+    }
+  };
+
+  std::vector<std::string> styles{""};
+  std::vector<Cell> front, back;
+  int height = 0, width = 0;
+  bool repaint = true;
+};
+
+} // namespace pathcore
@@ -0,0 +1,677 @@
+#include "server.h"
+#include "cost.h"
+#include "lists.h"
+#include "text.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <unordered_set>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace pathcore {
+
+namespace {
+
+// Whether `v` is a JSON number, true, false or null.
+bool jsonLiteral(const std::string &v) {
+  if (v == "true" || v == "false" || v == "null")
+    return true;
+  size_t i = v[0] == '-' ? 1 : 0;
+  auto digits = [&] {
+    size_t from = i;
+    while (i < v.size() && v[i] >= '0' && v[i] <= '9')
+      ++i;
+    return i > from;
+  };
+  if (i < v.size() && v[i] == '0')
+    ++i;
+  else if (!digits())
+    return false;
+  if (i < v.size() && v[i] == '.' && (++i, !digits()))
+    return false;
+  if (i < v.size() && (v[i] == 'e' || v[i] == 'E')) {
+    ++i;
+    if (i < v.size() && (v[i] == '+' || v[i] == '-'))
+      ++i;
+    if (!digits())
+      return false;
+  }
+  return i == v.size();
+}
+
+bool jsonNumber(const std::string &v) {
+  return jsonLiteral(v) && v != "true" && v != "false" && v != "null";
+}
+
+// Parses a flat JSON object into raw values: strings are unescaped (and
+// their keys added to `quoted`), numbers and literals kept as written.
+// Nested values, anything that is not a JSON literal and text after the
+// object are rejected.
+bool parseObject(std::string_view s,
+                 std::unordered_map<std::string, std::string> &out,
+                 std::unordered_set<std::string> &quoted, std::string &error) {
+  size_t i = 0;
+  auto skip = [&] {
+    while (i < s.size() && (s[i] == ' ' || s[i] == '\t' || s[i] == '\r'))
+      ++i;
+  };
+  auto string = [&](std::string &v) {
+    if (i >= s.size() || s[i] != '"')
+      return false;
+    for (++i; i < s.size() && s[i] != '"'; ++i) {
+      if (s[i] != '\\') {
+        v += s[i];
+        continue;
+      }
+      if (++i >= s.size())
+        return false;
+      switch (s[i]) {
+      case 'n': v += '\n'; break;
+      case 't': v += '\t'; break;
+      case 'r': v += '\r'; break;
+      case 'b': v += '\b'; break;
+      case 'f': v += '\f'; break;
+      case 'u': {
+        if (i + 4 >= s.size())
+          return false;
+        for (size_t k = 1; k <= 4; ++k)
+          if (!std::isxdigit(static_cast<unsigned char>(s[i + k])))
+            return false;
+        unsigned cp = static_cast<unsigned>(
+            std::strtoul(std::string(s.substr(i + 1, 4)).c_str(), nullptr, 16));
+        i += 4;
+        if (cp < 0x80) {
+          v += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+          v += static_cast<char>(0xC0 | (cp >> 6));
+          v += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+          v += static_cast<char>(0xE0 | (cp >> 12));
+          v += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+          v += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        break;
+      }
+      default: v += s[i];
+      }
+    }
+    if (i >= s.size())
+      return false;
+    ++i;
+    return true;
+  };
+
+  auto end = [&] {
+    ++i;
+    skip();
+    if (i == s.size())
+      return true;
+    error = "unexpected text after the object";
+    return false;
+  };
+
+  skip();
+  if (i >= s.size() || s[i++] != '{') {
+    error = "request is not a JSON object";
+    return false;
+  }
+  skip();
+  if (i < s.size() && s[i] == '}')
+    return end();
+  for (;;) {
+    std::string key, value;
+    skip();
+    if (!string(key)) {
+      error = "expected a string key";
+      return false;
+    }
+    skip();
+    if (i >= s.size() || s[i++] != ':') {
+      error = "expected ':'";
+      return false;
+    }
+    skip();
+    if (i < s.size() && s[i] == '"') {
+      if (!string(value)) {
+        error = "unterminated string";
+        return false;
+      }
+      quoted.insert(key);
+    } else {
+      size_t start = i;
+      while (i < s.size() && s[i] != ',' && s[i] != '}')
+        ++i;
+      value.assign(s.substr(start, i - start));
+      while (!value.empty() && (value.back() == ' ' || value.back() == '\t' ||
+                                value.back() == '\r'))
+        value.pop_back();
+      if (value.empty() || !jsonLiteral(value)) {
+        error = "unsupported value for \"" + key + "\"";
+        return false;
+      }
+    }
+    out[key] = std::move(value);
+    skip();
+    if (i < s.size() && s[i] == ',') {
+      ++i;
+      continue;
+    }
+    if (i < s.size() && s[i] == '}')
+      return end();
+    error = "expected ',' or '}'";
+    return false;
+  }
+}
+
+const char *boolText(bool b) { return b ? "true" : "false"; }
+
+} // namespace
+
+QueryServer::QueryServer(std::unique_ptr<EnvStore> store, std::string name)
+    : name(std::move(name)), session(std::move(store)),
+      exts(lookupExtensions()) {
+  session.setJournaling(false); // read-only
+  std::unique_lock<std::shared_mutex> lock(mu);
+  refresh(false);
+}
+
+QueryServer::~QueryServer() {
+  stopping = true;
+  if (watcher.joinable())
+    watcher.join();
+}
+
+QueryServer::ListingPtr QueryServer::makeListing(std::string dir) {
+  auto listing = std::make_shared<Listing>();
+  std::error_code ec;
+  listing->mtime = fs::last_write_time(dir, ec);
+  listing->files =
+      std::make_shared<const std::vector<std::string>>(listFiles(dir));
+  listing->dir = std::move(dir);
+  listed++;
+  return listing;
+}
+
+QueryServer::Files QueryServer::currentFiles(Listing &listing) {
+  std::lock_guard<std::mutex> lock(listing.mu);
+  return listing.files;
+}
+
+void QueryServer::relistChanged() {
+  std::vector<ListingPtr> all;
+  {
+    std::shared_lock<std::shared_mutex> lock(mu);
+    all.reserve(listings.size());
+    for (const auto &entry : listings)
+      all.push_back(entry.second);
+  }
+  // Listed outside the locks, so queries keep reading the old files
+  for (const ListingPtr &listing : all) {
+    std::error_code ec;
+    auto mtime = fs::last_write_time(listing->dir, ec);
+    {
+      std::lock_guard<std::mutex> lock(listing->mu);
+      if (mtime == listing->mtime)
+        continue;
+    }
+    auto files =
+        std::make_shared<const std::vector<std::string>>(listFiles(listing->dir));
+    std::lock_guard<std::mutex> lock(listing->mu);
+    listing->files = std::move(files);
+    listing->mtime = mtime;
+    listed++;
+  }
+}
+
+// Caller holds `mu` exclusively.
+void QueryServer::refresh(bool relist) {
+  if (relist) {
+    listings.clear();
+    session.probeCache().clear();
+  }
+  session.load(name);
+  const PathTable &t = session.table();
+  order = searchOrder(t);
+  byKey.clear();
+
+  // Listings of directories still on PATH carry over
+  std::unordered_map<uint64_t, ListingPtr> kept;
+  for (uint32_t i = 0; i < t.size(); ++i) {
+    uint64_t key = t.keyHash(i);
+    byKey.emplace(key, i);
+    if (kept.count(key))
+      continue;
+    auto it = listings.find(key);
+    if (it != listings.end()) {
+      kept.emplace(key, it->second);
+    } else {
+      kept.emplace(key, makeListing(std::string(t.expanded(i))));
+    }
+  }
+  listings.swap(kept);
+  reloads++;
+}
+
+bool QueryServer::refreshIfChanged() {
+  StoreValue now[2];
+  for (Scope scope : {Scope::User, Scope::System})
+    if (!session.store().read(scope, name, now[static_cast<int>(scope)]))
+      return false;
+  {
+    std::shared_lock<std::shared_mutex> lock(mu);
+    const Snapshot &seen = session.snapshot();
+    bool same = true;
+    for (Scope scope : {Scope::User, Scope::System}) {
+      const StoreValue &a = now[static_cast<int>(scope)], &b = seen[scope];
+      same &= a.version == b.version && a.data == b.data;
+    }
+    if (same)
+      return false;
+  }
+  std::unique_lock<std::shared_mutex> lock(mu);
+  refresh(false);
+  return true;
+}
+
+std::string QueryServer::handle(std::string_view request) {
+  queries++;
+  std::unordered_map<std::string, std::string> req;
+  std::unordered_set<std::string> quoted;
+  std::string error;
+  if (!parseObject(request, req, quoted, error))
+    return "{\"ok\":false,\"error\":" + jsonQuote(error) + "}";
+
+  // The id comes back as it was sent, string or number
+  std::string out = "{";
+  if (auto id = req.find("id"); id != req.end()) {
+    bool isString = quoted.count("id") > 0;
+    if (!isString && !jsonNumber(id->second))
+      return "{\"ok\":false,\"error\":" +
+             jsonQuote("\"id\" must be a string or a number") + "}";
+    out += "\"id\":" + (isString ? jsonQuote(id->second) : id->second) + ",";
+  }
+  const std::string &op = req["op"];
+
+  // Query paths are expanded with this thread's own memo
+  thread_local Expander expander;
+  auto arg = [&](const char *key, std::string &value) {
+    auto it = req.find(key);
+    if (it == req.end() || it->second.empty()) {
+      error = std::string("missing \"") + key + "\"";
+      return false;
+    }
+    value = it->second;
+    return true;
+  };
+
+  if (op == "reload") {
+    std::unique_lock<std::shared_mutex> lock(mu);
+    refresh(true);
+    return out + "\"ok\":true,\"entries\":" +
+           std::to_string(session.table().size()) + "}";
+  }
+
+  std::shared_lock<std::shared_mutex> lock(mu);
+  const PathTable &t = session.table();
+  std::string value;
+  if (op == "contains") {
+    if (!arg("path", value))
+      return out + "\"ok\":false,\"error\":" + jsonQuote(error) + "}";
+    auto it = byKey.find(canonicalHash(expander.expand(value)));
+    out += "\"ok\":true,\"found\":";
+    if (it == byKey.end())
+      return out + "false}";
+    return out + "true,\"index\":" + std::to_string(it->second + 1) +
+           ",\"scope\":\"" + scopeName(t.scope(it->second)) + "\"}";
+  }
+  if (op == "exists") {
+    if (!arg("path", value))
+      return out + "\"ok\":false,\"error\":" + jsonQuote(error) + "}";
+    std::string expanded = expander.expand(value);
+    bool found = validEntry(listKind(name), expanded, canonicalHash(expanded),
+                            session.probeCache());
+    return out + "\"ok\":true,\"exists\":" + boolText(found) + "}";
+  }
+  if (op == "which") {
+    if (!arg("name", value))
+      return out + "\"ok\":false,\"error\":" + jsonQuote(error) + "}";
+    auto names = lookupNames(value, exts);
+    for (uint32_t i : order) {
+      Files files = currentFiles(*listings.at(t.keyHash(i)));
+      for (const auto &file : names) {
+        if (!std::binary_search(files->begin(), files->end(), file))
+          continue;
+        std::string path = (fs::path(std::string(t.expanded(i))) / file).string();
+        return out + "\"ok\":true,\"found\":true,\"file\":" + jsonQuote(path) +
+               ",\"index\":" + std::to_string(i + 1) + "}";
+      }
+    }
+    return out + "\"ok\":true,\"found\":false}";
+  }
+  if (op == "list") {
+    out += "\"ok\":true,\"entries\":[";
+    for (uint32_t i = 0; i < t.size(); ++i) {
+      bool found = validEntry(listKind(name), t.expanded(i), t.keyHash(i),
+                              session.probeCache());
+      out += i ? ",{" : "{";
+      out += "\"index\":" + std::to_string(i + 1) + ",\"scope\":\"" +
+             scopeName(t.scope(i)) + "\",\"raw\":" + jsonQuote(t.raw(i)) +
+             ",\"expanded\":" + jsonQuote(t.expanded(i)) +
+             ",\"exists\":" + boolText(found) + "}";
+    }
+    return out + "]}";
+  }
+  if (op == "stats") {
+    return out + "\"ok\":true,\"variable\":" + jsonQuote(name) +
+           ",\"entries\":" + std::to_string(t.size()) +
+           ",\"user\":" + std::to_string(t.count(Scope::User)) +
+           ",\"system\":" + std::to_string(t.count(Scope::System)) +
+           ",\"directories\":" + std::to_string(listings.size()) +
+           ",\"queries\":" + std::to_string(queries.load()) +
+           ",\"reloads\":" + std::to_string(reloads.load()) +
+           ",\"listed\":" + std::to_string(listed.load()) + "}";
+  }
+  return out + "\"ok\":false,\"error\":" +
+         jsonQuote(op.empty() ? "missing \"op\"" : "unknown op: " + op) + "}";
+}
+
+template <typename Read, typename Write>
+void QueryServer::converse(Read &&readSome, Write &&writeAll) {
+  std::string buf, out;
+  char chunk[4096];
+  for (;;) {
+    long n = readSome(chunk, sizeof(chunk));
+    if (n <= 0)
+      return;
+    buf.append(chunk, static_cast<size_t>(n));
+
+    // Answer every complete line of this read in one write
+    size_t start = 0, nl;
+    out.clear();
+    while ((nl = buf.find('\n', start)) != std::string::npos) {
+      std::string_view line(buf.data() + start, nl - start);
+      if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+      if (!line.empty()) {
+        out += handle(line);
+        out += '\n';
+      }
+      start = nl + 1;
+    }
+    buf.erase(0, start);
+    if (!out.empty() && !writeAll(out))
+      return;
+    if (buf.size() > (1u << 20))
+      return; // a runaway line
+  }
+}
+
+void QueryServer::finished(Connection &conn) {
+  std::lock_guard<std::mutex> lock(connMu);
+  conn.done = true;
+  connDone.notify_all();
+}
+
+bool QueryServer::reapConnections() {
+  std::unique_lock<std::mutex> lock(connMu);
+  for (;;) {
+    for (auto it = connections.begin(); it != connections.end();) {
+      if (!it->done) {
+        ++it;
+        continue;
+      }
+      it->thread.join();
+      release(*it);
+      it = connections.erase(it);
+    }
+    if (stopping)
+      return false;
+    if (connections.size() < MaxConnections)
+      return true;
+    // stop() may run in a signal handler and cannot notify, so look again
+    connDone.wait_for(lock, std::chrono::milliseconds(100));
+  }
+}
+
+void QueryServer::closeConnections() {
+  std::unique_lock<std::mutex> lock(connMu);
+  for (;;) {
+    bool open = false;
+    for (Connection &conn : connections) {
+      if (!conn.done) {
+        hangUp(conn);
+        open = true;
+      }
+    }
+    if (!open)
+      break;
+    // A thread between two reads misses the first hang-up; repeat it
+    connDone.wait_for(lock, std::chrono::milliseconds(100));
+  }
+  for (Connection &conn : connections) {
+    conn.thread.join();
+    release(conn);
+  }
+  connections.clear();
+}
+
+#ifdef _WIN32
+std::string QueryServer::defaultEndpoint() {
+  const char *user = std::getenv("USERNAME");
+  return std::string("\\\\.\\pipe\\pathmgr-") + (user ? user : "default");
+}
+
+bool QueryServer::serve(const std::string &endpoint, std::string &error,
+                        std::chrono::milliseconds poll) {
+  watcher = std::thread([this, poll] {
+    while (!stopping) {
+      std::this_thread::sleep_for(poll);
+      refreshIfChanged();
+      relistChanged();
+    }
+  });
+
+  servedAt = endpoint;
+  while (reapConnections()) {
+    HANDLE pipe = CreateNamedPipeA(
+        endpoint.c_str(), PIPE_ACCESS_DUPLEX,
+        PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT |
+            PIPE_REJECT_REMOTE_CLIENTS,
+        PIPE_UNLIMITED_INSTANCES, 64 * 1024, 4096, 0, nullptr);
+    if (pipe == INVALID_HANDLE_VALUE) {
+      error = "Cannot create pipe " + endpoint + " (code " +
+              std::to_string(GetLastError()) + ")";
+      closeConnections();
+      return false;
+    }
+    if ((!ConnectNamedPipe(pipe, nullptr) &&
+         GetLastError() != ERROR_PIPE_CONNECTED) ||
+        stopping) {
+      CloseHandle(pipe);
+      continue;
+    }
+    std::lock_guard<std::mutex> lock(connMu);
+    Connection &conn = connections.emplace_back();
+    conn.pipe = pipe;
+    conn.thread = std::thread([this, &conn, pipe] {
+      converse(
+          [&](char *buf, size_t size) -> long {
+            DWORD n = 0;
+            if (!ReadFile(pipe, buf, static_cast<DWORD>(size), &n, nullptr))
+              return -1;
+            return static_cast<long>(n);
+          },
+          [&](const std::string &data) {
+            DWORD n = 0;
+            return WriteFile(pipe, data.data(), static_cast<DWORD>(data.size()),
+                             &n, nullptr) &&
+                   n == data.size();
+          });
+      FlushFileBuffers(pipe);
+      DisconnectNamedPipe(pipe);
+      finished(conn);
+    });
+  }
+  closeConnections();
+  return true;
+}
+
+void QueryServer::hangUp(Connection &conn) {
+  // Fails the read the thread is blocked in, and every later one
+  CancelIoEx(conn.pipe, nullptr);
+  DisconnectNamedPipe(conn.pipe);
+}
+
+void QueryServer::release(Connection &conn) { CloseHandle(conn.pipe); }
+
+void QueryServer::stop() {
+  stopping = true;
+  // Wakes the ConnectNamedPipe the serve loop is blocked in
+  HANDLE wake = CreateFileA(servedAt.c_str(), GENERIC_READ, 0, nullptr,
+                            OPEN_EXISTING, 0, nullptr);
+  if (wake != INVALID_HANDLE_VALUE)
+    CloseHandle(wake);
+}
+#else
+std::string QueryServer::defaultEndpoint() {
+  if (const char *dir = std::getenv("PATHMGR_STORE"); dir && *dir)
+    return (fs::path(dir) / "pathmgr.sock").string();
+  if (const char *run = std::getenv("XDG_RUNTIME_DIR"); run && *run)
+    return (fs::path(run) / "pathmgr.sock").string();
+  const char *home = std::getenv("HOME");
+  return (fs::path(home ? home : ".") / ".pathmgr" / "pathmgr.sock").string();
+}
+
+bool QueryServer::serve(const std::string &endpoint, std::string &error,
+                        std::chrono::milliseconds poll) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (endpoint.size() >= sizeof(addr.sun_path)) {
+    error = "Socket path too long: " + endpoint;
+    return false;
+  }
+  std::memcpy(addr.sun_path, endpoint.c_str(), endpoint.size() + 1);
+
+  // Only a socket nobody answers on, left by an earlier run, is replaced
+  struct stat st {};
+  if (::lstat(endpoint.c_str(), &st) == 0) {
+    if (!S_ISSOCK(st.st_mode)) {
+      error = endpoint + " exists and is not a socket";
+      return false;
+    }
+    int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    bool live = probe >= 0 &&
+                ::connect(probe, reinterpret_cast<sockaddr *>(&addr),
+                          sizeof(addr)) == 0;
+    if (probe >= 0)
+      ::close(probe);
+    if (live) {
+      error = "Another server is already listening on " + endpoint;
+      return false;
+    }
+    ::unlink(endpoint.c_str());
+  }
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    error = std::string("Cannot create socket: ") + std::strerror(errno);
+    return false;
+  }
+  mode_t mask = ::umask(0077); // owner only
+  int bound = ::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+  ::umask(mask);
+  if (bound != 0 || ::listen(fd, 64) != 0) {
+    error = "Cannot listen on " + endpoint + ": " + std::strerror(errno);
+    ::close(fd);
+    if (bound == 0)
+      ::unlink(endpoint.c_str());
+    return false;
+  }
+  servedAt = endpoint;
+  listener = fd;
+
+  watcher = std::thread([this, poll] {
+    while (!stopping) {
+      std::this_thread::sleep_for(poll);
+      refreshIfChanged();
+      relistChanged();
+    }
+  });
+
+  bool ok = true;
+  while (reapConnections()) {
+    int client = ::accept(fd, nullptr, nullptr);
+    if (client < 0) {
+      if (stopping)
+        break;
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      error = std::string("accept failed: ") + std::strerror(errno);
+      ok = false;
+      break;
+    }
+    std::lock_guard<std::mutex> lock(connMu);
+    Connection &conn = connections.emplace_back();
+    conn.fd = client;
+    conn.thread = std::thread([this, &conn, client] {
+      converse(
+          [&](char *buf, size_t size) -> long {
+            ssize_t n;
+            while ((n = ::recv(client, buf, size, 0)) < 0 && errno == EINTR)
+              ;
+            return static_cast<long>(n);
+          },
+          [&](const std::string &data) {
+            size_t done = 0;
+            while (done < data.size()) {
+              ssize_t n = ::send(client, data.data() + done, data.size() - done,
+                                 MSG_NOSIGNAL);
+              if (n < 0 && errno == EINTR)
+                continue;
+              if (n <= 0)
+                return false;
+              done += static_cast<size_t>(n);
+            }
+            return true;
+          });
+      finished(conn);
+    });
+  }
+  closeConnections();
+  listener = -1;
+  ::close(fd);
+  ::unlink(endpoint.c_str());
+  return ok;
+}
+
+void QueryServer::hangUp(Connection &conn) { ::shutdown(conn.fd, SHUT_RDWR); }
+
+void QueryServer::release(Connection &conn) { ::close(conn.fd); }
+
+void QueryServer::stop() {
+  stopping = true;
+  // Wakes the accept the serve loop is blocked in
+  if (listener >= 0)
+    ::shutdown(listener, SHUT_RDWR);
+}
+#endif
+
+} // namespace pathcore
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "session.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace pathcore {
+
+// Answers PATH queries from memory for other processes: the loaded
+// snapshot, the probe cache and a listing of every PATH directory stay
+// resident between requests.
+//
+// Requests and responses are single-line JSON objects (NDJSON). Each
+// request has an "op" and may carry an "id" (a string or a number), which
+// is echoed back:
+//
+//   {"op":"contains","path":"C:\\Tools"}  -> "found", "index", "scope"
+//   {"op":"which","name":"git"}           -> "found", "file", "index"
+//   {"op":"exists","path":"C:\\Tools"}    -> "exists"
+//   {"op":"list"}                         -> "entries": [...]
+//   {"op":"stats"}                        -> counters
+//   {"op":"reload"}                       -> re-reads and relists everything
+//
+// Failures answer {"ok":false,"error":"..."}.
+class QueryServer {
+public:
+  explicit QueryServer(std::unique_ptr<EnvStore> store,
+                       std::string name = "PATH");
+  ~QueryServer();
+
+  // Answers one request line. Safe to call from many threads.
+  std::string handle(std::string_view request);
+
+  // Re-reads the store if either scope moved since the last read. Entries
+  // that were already known keep their probe results and listings, so
+  // only new directories are touched. Returns true if anything changed.
+  bool refreshIfChanged();
+
+  // Accepts connections on `endpoint` (a Unix-domain socket path, or a
+  // named pipe name on Windows) and serves each on its own thread, up to
+  // MaxConnections at once, while a watcher refreshes every `poll`. An
+  // existing socket is taken over only if no server answers on it, and
+  // nothing else at the path is touched; the socket is removed again on
+  // the way out. Open connections are hung up and their threads joined
+  // before returning. Returns false on a setup error, true once stop()
+  // was called.
+  bool serve(const std::string &endpoint, std::string &error,
+             std::chrono::milliseconds poll = std::chrono::milliseconds(500));
+  // Makes serve() return. Safe to call from a signal handler.
+  void stop();
+
+  // <store>/pathmgr.sock, or \\.\pipe\pathmgr-<user> on Windows.
+  static std::string defaultEndpoint();
+
+  // Clients served at once; further ones wait in the accept backlog.
+  static constexpr size_t MaxConnections = 64;
+
+private:
+  using Files = std::shared_ptr<const std::vector<std::string>>;
+  // Files of one PATH directory. The watcher relists it when the
+  // directory's mtime moves, so installs and uninstalls show up within a
+  // poll without a reload, and queries never touch the disk.
+  struct Listing {
+    std::string dir;
+    std::mutex mu;
+    std::filesystem::file_time_type mtime;
+    Files files;
+  };
+  using ListingPtr = std::shared_ptr<Listing>;
+
+  ListingPtr makeListing(std::string dir);
+  Files currentFiles(Listing &listing);
+  // Relists every directory whose mtime moved. Run by the watcher.
+  void relistChanged();
+
+  // One client being served. Its thread only sets `done`; the serve loop
+  // joins it and closes the handle, so a handle is never hung up after
+  // it was closed and reused.
+  struct Connection {
+    std::thread thread;
+#ifdef _WIN32
+    void *pipe = nullptr;
+#else
+    int fd = -1;
+#endif
+    bool done = false;
+  };
+
+  // Joins finished connections, then waits until fewer than
+  // MaxConnections are open. Returns false if stopping meanwhile.
+  bool reapConnections();
+  // Hangs up every open connection and joins its thread.
+  void closeConnections();
+  // Marks `conn` finished. Called by its own thread.
+  void finished(Connection &conn);
+  static void hangUp(Connection &conn);
+  static void release(Connection &conn);
+
+  void refresh(bool relist);
+  // Reads requests from a connection until it closes.
+  template <typename Read, typename Write>
+  void converse(Read &&readSome, Write &&writeAll);
+
+  std::string name;
+  Session session;
+  std::vector<std::string> exts;
+
+  // Guards the session's table and everything below; queries share it,
+  // refreshes own it.
+  std::shared_mutex mu;
+  std::vector<uint32_t> order;                    // search order
+  std::unordered_map<uint64_t, uint32_t> byKey;   // first entry per keyHash
+  std::unordered_map<uint64_t, ListingPtr> listings; // by entry keyHash
+
+  std::atomic<uint64_t> queries{0}, reloads{0}, listed{0};
+  std::atomic<bool> stopping{false};
+  std::string servedAt; // endpoint, while serving
+  std::mutex connMu;
+  std::condition_variable connDone;
+  std::list<Connection> connections; // guarded by connMu
+#ifndef _WIN32
+  std::atomic<int> listener{-1};
+#endif
+  std::thread watcher;
+};
+
+} // namespace pathcore
@@ -0,0 +1,290 @@
+#include "session.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+namespace pathcore {
+
+Session::Session() : Session(openDefaultStore()) {}
+
+Session::Session(std::unique_ptr<EnvStore> store) : backing(std::move(store)) {}
+
+void Session::appendScope(Scope scope, const std::string &raw) {
+  // Expansion misses are their own spans, inside this one.
+  TraceSpan span(Phase::Split);
+  size_t start = 0;
+  while (start <= raw.size()) {
+    size_t end = raw.find(';', start);
+    if (end == std::string::npos)
+      end = raw.size();
+    if (end > start) {
+      std::string token = raw.substr(start, end - start);
+      entries.append(scope, token, expander.expand(token));
+    }
+    start = end + 1;
+  }
+}
+
+bool Session::load(const std::string &name) {
+  loaded.name = name;
+  {
+    TraceSpan span(Phase::Load);
+    read[0] = backing->read(Scope::User, name, loaded.values[0]);
+    read[1] = backing->read(Scope::System, name, loaded.values[1]);
+  }
+  // A scope that failed stays unread, so an edit reads it again rather
+  // than building on an empty value.
+  rebuildTable();
+  return read[0] && read[1];
+}
+
+void Session::select(const std::string &name) {
+  loaded = Snapshot{name, {}};
+  read[0] = read[1] = false;
+  entries.clear();
+  tabled = false;
+}
+
+const StoreValue *Session::value(Scope scope) {
+  int s = static_cast<int>(scope);
+  if (!read[s]) {
+    TraceSpan span(Phase::Load);
+    if (!backing->read(scope, loaded.name, loaded.values[s]))
+      return nullptr;
+    read[s] = true;
+  }
+  return &loaded.values[s];
+}
+
+void Session::rebuildTable() {
+  const std::string &userPath = loaded[Scope::User].data;
+  const std::string &systemPath = loaded[Scope::System].data;
+  entries.clear();
+  // Expansion rarely more than doubles an entry.
+  entries.reserve((userPath.size() + systemPath.size()) / 16 + 1,
+                  2 * (userPath.size() + systemPath.size()));
+  appendScope(Scope::User, userPath);
+  appendScope(Scope::System, systemPath);
+  TraceSpan span(Phase::Canonicalize);
+  entries.markDuplicates();
+  identities.clear();
+  tabled = true;
+}
+
+bool Session::exists(uint32_t i) {
+  if (!(entries.flags(i) & Probed)) {
+    bool found =
+        validEntry(kind(), entries.expanded(i), entries.keyHash(i), probes);
+    entries.setFlags(i, found ? Probed | Exists : Probed);
+  }
+  return entries.flags(i) & Exists;
+}
+
+const std::vector<uint64_t> &Session::identityKeys(unsigned threads) {
+  if (identities.size() != entries.size()) {
+    std::vector<std::string> paths;
+    paths.reserve(entries.size());
+    for (uint32_t i = 0; i < entries.size(); ++i)
+      paths.emplace_back(entries.expanded(i));
+    if (threads == 0)
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    identities = resolver.keys(paths, threads);
+  }
+  return identities;
+}
+
+bool Session::valid(const std::string &expanded) {
+  return validEntry(kind(), expanded, canonicalHash(expanded), probes);
+}
+
+bool Session::readRaw(Scope scope, const std::string &name,
+                      std::string &out) {
+  StoreValue v;
+  if (!backing->read(scope, name, v))
+    return false;
+  out = std::move(v.data);
+  return true;
+}
+
+CommitResult Session::update(Scope scope, const Edit &edit, int maxAttempts) {
+  return commit(scope, edit, maxAttempts, 0);
+}
+
+CommitResult Session::commit(Scope scope, const Edit &edit, int maxAttempts,
+                             uint64_t restores) {
+  const StoreValue *current = value(scope);
+  if (!current)
+    return {CommitStatus::Failed, 0};
+  StoreValue base = *current;
+  Journal *log = journalEnabled ? journal() : nullptr;
+  std::minstd_rand jitter(std::random_device{}());
+  CommitResult result{CommitStatus::Conflict, 0};
+
+  while (result.attempts < maxAttempts) {
+    result.attempts++;
+    std::vector<std::string> items = splitPath(base.data);
+    std::string before = base.data;
+    EditResult er = edit(items);
+    if (er != EditResult::Changed) {
+      result.status = er == EditResult::Abort ? CommitStatus::Aborted
+                                              : CommitStatus::Unchanged;
+      break;
+    }
+
+    std::string value = joinPath(items);
+    ValueKind kind = value.find('%') != std::string::npos || !base.present
+                         ? ValueKind::ExpandString
+                         : base.kind;
+    uint64_t version = 0;
+    WriteStatus ws;
+    {
+      TraceSpan span(Phase::Write);
+      // Journaled before the store unlocks, so records follow commit order.
+      ws = backing->write(scope, loaded.name, value, kind, base.version,
+                          &version, [&] {
+                            if (log)
+                              log->append(scope, loaded.name, before, value,
+                                          restores);
+                          });
+    }
+    if (ws == WriteStatus::Ok) {
+      base = StoreValue{std::move(value), kind, true, version};
+      result.status = CommitStatus::Committed;
+      break;
+    }
+    if (ws == WriteStatus::Failed) {
+      result.status = CommitStatus::Failed;
+      break;
+    }
+
+    // Someone else wrote first: rebase onto their value and try again,
+    // backing off a little more each time.
+    std::this_thread::sleep_for(std::chrono::microseconds(
+        jitter() % (200u << std::min(result.attempts, 6))));
+    StoreValue fresh;
+    if (!backing->read(scope, loaded.name, fresh)) {
+      result.status = CommitStatus::Failed;
+      break;
+    }
+    base = std::move(fresh);
+  }
+
+  if (base.version != loaded[scope].version) {
+    loaded.values[static_cast<int>(scope)] = std::move(base);
+    if (tabled)
+      rebuildTable();
+  }
+  if (result.status == CommitStatus::Committed)
+    notifyChange();
+  return result;
+}
+
+CommitResult Session::updateValues(Scope scope,
+                                   const std::vector<NamedValue> &values,
+                                   int maxAttempts) {
+  int s = static_cast<int>(scope);
+  Journal *log = journalEnabled ? journal() : nullptr;
+  std::minstd_rand jitter(std::random_device{}());
+  CommitResult result{CommitStatus::Conflict, 0};
+  std::vector<NamedValue> current, changed;
+  std::vector<std::string> before;
+  uint64_t base = 0, version = 0;
+
+  while (result.attempts < maxAttempts) {
+    result.attempts++;
+    // The stamp is read first: if the scope moves before readAll, the
+    // write below conflicts instead of landing on a stale comparison.
+    StoreValue stamp;
+    if (values.empty() || !backing->read(scope, values[0].name, stamp) ||
+        !backing->readAll(scope, current)) {
+      result.status =
+          values.empty() ? CommitStatus::Unchanged : CommitStatus::Failed;
+      break;
+    }
+    base = stamp.version;
+    std::unordered_map<std::string, const StoreValue *> stored;
+    for (const auto &nv : current)
+      stored.emplace(toLower(nv.name), &nv.value);
+
+    changed.clear();
+    before.clear();
+    for (const auto &nv : values) {
+      auto it = stored.find(toLower(nv.name));
+      const StoreValue *old = it == stored.end() ? nullptr : it->second;
+      if (old && old->data == nv.value.data && old->kind == nv.value.kind)
+        continue;
+      changed.push_back(nv);
+      before.push_back(old ? old->data : "");
+    }
+    if (changed.empty()) {
+      result.status = CommitStatus::Unchanged;
+      break;
+    }
+
+    WriteStatus ws;
+    {
+      TraceSpan span(Phase::Write);
+      ws = backing->writeAll(scope, changed, base, &version, [&] {
+        if (log)
+          for (size_t k = 0; k < changed.size(); ++k)
+            log->append(scope, changed[k].name, before[k],
+                        changed[k].value.data);
+      });
+    }
+    if (ws == WriteStatus::Ok) {
+      result.status = CommitStatus::Committed;
+      break;
+    }
+    if (ws == WriteStatus::Failed) {
+      result.status = CommitStatus::Failed;
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(
+        jitter() % (200u << std::min(result.attempts, 6))));
+  }
+
+  if (result.status != CommitStatus::Committed)
+    return result;
+  // The loaded value moves with the batch if it was current when written.
+  if (read[s] && loaded.values[s].version == base) {
+    loaded.values[s].version = version;
+    for (const auto &nv : changed)
+      if (iequals(nv.name, loaded.name)) {
+        loaded.values[s] = StoreValue{nv.value.data, nv.value.kind, true,
+                                      version};
+        if (tabled)
+          rebuildTable();
+      }
+  } else {
+    read[s] = false;
+  }
+  notifyChange();
+  return result;
+}
+
+Journal *Session::journal() {
+  if (!history) {
+    std::string file = backing->journalPath();
+    if (file.empty())
+      return nullptr;
+    history = std::make_unique<Journal>(file);
+  }
+  return history.get();
+}
+
+void Session::notifyChange() {
+  if (!notifyEnabled)
+    return;
+  if (!dispatcher)
+    dispatcher = std::make_unique<NotifyDispatcher>(backing->makeNotifier());
+  dispatcher->post("Environment");
+}
+
+bool Session::waitForNotifications(std::chrono::milliseconds timeout) {
+  return !dispatcher || dispatcher->waitDelivered(timeout);
+}
+
+} // namespace pathcore
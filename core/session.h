@@ -0,0 +1,157 @@
+#pragma once
+
+#include "identity.h"
+#include "journal.h"
+#include "lists.h"
+#include "notify.h"
+#include "probe.h"
+#include "store.h"
+#include "table.h"
+#include "text.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace pathcore {
+
+// The store values a table was loaded from. Each carries its scope's version
+// stamp, so later writes can tell whether the store moved underneath.
+struct Snapshot {
+  std::string name;
+  StoreValue values[2];
+
+  const StoreValue &operator[](Scope scope) const {
+    return values[static_cast<int>(scope)];
+  }
+  // Changes whenever either scope is written.
+  uint64_t stamp() const {
+    return values[0].version * 1099511628211ull ^ values[1].version;
+  }
+};
+
+// What an Edit did to the entries it was given.
+enum class EditResult : uint8_t { Changed, Unchanged, Abort };
+
+// A logical change to one scope's raw entries. It may run more than once:
+// after a conflicting write it is re-applied to the fresh value.
+using Edit = std::function<EditResult(std::vector<std::string> &entries)>;
+
+enum class CommitStatus : uint8_t {
+  Committed,
+  Unchanged, // the edit found nothing to do
+  Aborted,   // the edit declined
+  Conflict,  // still racing other writers after every attempt
+  Failed,    // store error, see lastError()
+};
+
+struct CommitResult {
+  CommitStatus status;
+  int attempts = 0;
+};
+
+// Everything a front end needs to inspect and edit PATH: the store, the
+// loaded entry table, and the expansion and probe caches shared by all
+// commands run against it.
+class Session {
+public:
+  Session();
+  explicit Session(std::unique_ptr<EnvStore> store);
+
+  // Reads both scopes of `name` from the store, one read each, and builds
+  // the entry table from them. False if either read failed; see lastError().
+  bool load(const std::string &name = "PATH");
+  // Names the variable to work on without reading anything: value() and
+  // update() read a scope on first use, and the table stays empty until
+  // load(). For commands that never look at the other scope.
+  void select(const std::string &name);
+  // The value of `scope` as loaded, read from the store on first use. Null
+  // if that read failed (see lastError()); the next call reads again.
+  const StoreValue *value(Scope scope);
+  const PathTable &table() const { return entries; }
+  const Snapshot &snapshot() const { return loaded; }
+
+  // Probes entry `i` once and caches the result in its flags. What counts
+  // as existing depends on the variable's ListKind.
+  bool exists(uint32_t i);
+  // Same test for an expanded item that is not in the table.
+  bool valid(const std::string &expanded);
+  ListKind kind() const { return listKind(loaded.name); }
+  const std::string &variable() const { return loaded.name; }
+
+  // Audits every list variable of both scopes, sharing this session's
+  // expansion and probe caches.
+  std::vector<ListAudit> auditLists(unsigned threads) {
+    return pathcore::auditLists(*backing, expander, probes, threads);
+  }
+
+  // The current stored value of `name`, bypassing the loaded snapshot.
+  // False if the read failed; see lastError().
+  bool readRaw(Scope scope, const std::string &name, std::string &out);
+
+  // Applies `edit` to the loaded value of `scope` and writes it back only if
+  // the store is still at the loaded version. On a conflict the scope is
+  // re-read and the edit re-applied, so concurrent writers never lose each
+  // other's changes. Returns once the value is durable; the change
+  // notification is queued on a background dispatcher.
+  CommitResult update(Scope scope, const Edit &edit, int maxAttempts = 32);
+  // update() for an undo whose edit brings back `generation`; the journal
+  // records that, so the next undo steps back from there.
+  CommitResult restore(Scope scope, uint64_t generation, const Edit &edit) {
+    return commit(scope, edit, 32, generation);
+  }
+
+  // Sets every value in `values` of `scope`, as one compare-and-swap write
+  // of the values that differ, each journaled. On a conflict the scope is
+  // re-read and the batch recomputed. Unchanged if all already match.
+  CommitResult updateValues(Scope scope, const std::vector<NamedValue> &values,
+                            int maxAttempts = 32);
+
+  void setNotify(bool enabled) { notifyEnabled = enabled; }
+  void setJournaling(bool enabled) { journalEnabled = enabled; }
+  // Null when the store has no journal location.
+  Journal *journal();
+  // Waits for queued notifications to be delivered, up to `timeout`.
+  bool waitForNotifications(std::chrono::milliseconds timeout);
+
+  std::string expand(const std::string &s) { return expander.expand(s); }
+  bool directoryExists(const std::string &path) {
+    return probes.directoryExists(path);
+  }
+  ProbeCache &probeCache() { return probes; }
+
+  // Per table entry, a key equal for entries that reach the same directory,
+  // through symlinks and junctions too (IdentityCache::key). Resolved on
+  // `threads` workers, one per hardware thread if 0, on first use after
+  // each load.
+  const std::vector<uint64_t> &identityKeys(unsigned threads = 0);
+  IdentityCache &identityCache() { return resolver; }
+
+  EnvStore &store() { return *backing; }
+  const std::string &lastError() const { return backing->lastError(); }
+
+private:
+  CommitResult commit(Scope scope, const Edit &edit, int maxAttempts,
+                      uint64_t restores);
+  void appendScope(Scope scope, const std::string &raw);
+  void rebuildTable();
+  void notifyChange();
+
+  std::unique_ptr<EnvStore> backing;
+  Expander expander;
+  ProbeCache probes;
+  IdentityCache resolver;
+  PathTable entries;
+  std::vector<uint64_t> identities; // empty until identityKeys()
+  Snapshot loaded;
+  bool read[2] = {false, false}; // scopes of `loaded` read so far
+  bool tabled = false;           // `entries` reflects `loaded`
+  bool notifyEnabled = true;
+  bool journalEnabled = true;
+  std::unique_ptr<Journal> history;
+  // Started on the first write, so read-only commands never spawn it.
+  std::unique_ptr<NotifyDispatcher> dispatcher;
+};
+
+} // namespace pathcore
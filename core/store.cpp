@@ -0,0 +1,527 @@
+#include "store.h"
+#include "lock.h"
+#include "text.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace pathcore {
+
+namespace fs = std::filesystem;
+
+const char *scopeName(Scope scope) {
+  return scope == Scope::User ? "USER" : "SYSTEM";
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  FileStore
+// ─────────────────────────────────────────────────────────────────────────────
+namespace {
+
+unsigned long processId() {
+#ifdef _WIN32
+  return GetCurrentProcessId();
+#else
+  return static_cast<unsigned long>(::getpid());
+#endif
+}
+
+const char *kindName(ValueKind kind) {
+  return kind == ValueKind::String ? "REG_SZ" : "REG_EXPAND_SZ";
+}
+
+// Reads a whole hive file with one allocation sized from the file length.
+// An absent file reads as empty; one that exists but cannot be read is
+// an error, never an empty hive.
+bool slurp(const std::string &file, std::string &buf, std::string &error) {
+  buf.clear();
+  std::error_code ec;
+  fs::file_status status = fs::status(file, ec);
+  if (status.type() == fs::file_type::not_found)
+    return true;
+  if (ec || !fs::is_regular_file(status)) {
+    error = "cannot read " + file + (ec ? ": " + ec.message() : "");
+    return false;
+  }
+  std::ifstream in(file, std::ios::binary | std::ios::ate);
+  std::streamoff size = in ? static_cast<std::streamoff>(in.tellg()) : -1;
+  if (size < 0) {
+    error = "cannot read " + file;
+    return false;
+  }
+  buf.resize(static_cast<size_t>(size));
+  in.seekg(0);
+  in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+  if (!in) {
+    error = "cannot read " + file;
+    return false;
+  }
+  return true;
+}
+
+// One `Name<TAB>Type<TAB>value` line, viewed in place.
+struct HiveLine {
+  std::string_view name;
+  ValueKind kind;
+  std::string_view data;
+};
+
+// Calls `fn(line)` for each value line and returns the `# version N`
+// stamp found in the header (0 if none).
+template <typename F> uint64_t scanHive(std::string_view buf, F &&fn) {
+  uint64_t version = 0;
+  size_t pos = 0;
+  while (pos < buf.size()) {
+    size_t nl = buf.find('\n', pos);
+    if (nl == std::string_view::npos)
+      nl = buf.size();
+    std::string_view line = buf.substr(pos, nl - pos);
+    pos = nl + 1;
+    if (!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    if (line.empty())
+      continue;
+    if (line[0] == '#') {
+      if (line.rfind("# version ", 0) == 0)
+        version = std::strtoull(std::string(line.substr(10)).c_str(),
+                                nullptr, 10);
+      continue;
+    }
+    size_t t1 = line.find('\t');
+    size_t t2 = t1 == std::string_view::npos ? t1 : line.find('\t', t1 + 1);
+    if (t2 == std::string_view::npos)
+      continue;
+    HiveLine hl{line.substr(0, t1),
+                line.substr(t1 + 1, t2 - t1 - 1) == "REG_SZ"
+                    ? ValueKind::String
+                    : ValueKind::ExpandString,
+                line.substr(t2 + 1)};
+    fn(hl);
+  }
+  return version;
+}
+
+} // namespace
+
+FileStore::FileStore(std::string root, bool crossProcessLock)
+    : rootDir(std::move(root)), locking(crossProcessLock) {}
+
+std::string FileStore::scopeFile(Scope scope) const {
+  return (fs::path(rootDir) /
+          (scope == Scope::User ? "user.env" : "system.env"))
+      .string();
+}
+
+bool FileStore::read(Scope scope, const std::string &name, StoreValue &out) {
+  countEvent(Counter::StoreReads);
+  out = StoreValue{};
+  std::string buf;
+  if (!slurp(scopeFile(scope), buf, errorMessage))
+    return false;
+
+  // Files are replaced by rename, so one read sees one version.
+  out.version = scanHive(buf, [&](const HiveLine &hl) {
+    if (!out.present && iequals(hl.name, name)) {
+      out.data.assign(hl.data);
+      out.kind = hl.kind;
+      out.present = true;
+    }
+  });
+  return true;
+}
+
+bool FileStore::readAll(Scope scope, std::vector<NamedValue> &out) {
+  countEvent(Counter::StoreReads);
+  out.clear();
+  std::string buf;
+  if (!slurp(scopeFile(scope), buf, errorMessage))
+    return false;
+
+  uint64_t version = scanHive(buf, [&](const HiveLine &hl) {
+    // A repeated name keeps its first value, as in read()
+    for (const auto &nv : out)
+      if (iequals(nv.name, hl.name))
+        return;
+    out.push_back({std::string(hl.name),
+                   StoreValue{std::string(hl.data), hl.kind, true, 0}});
+  });
+  for (auto &nv : out)
+    nv.value.version = version;
+  return true;
+}
+
+WriteStatus FileStore::write(Scope scope, const std::string &name,
+                             const std::string &data, ValueKind kind,
+                             uint64_t expected, uint64_t *newVersion,
+                             const std::function<void()> &committed) {
+  return writeAll(scope, {{name, StoreValue{data, kind, true, 0}}}, expected,
+                  newVersion, committed);
+}
+
+WriteStatus FileStore::writeAll(Scope scope,
+                                const std::vector<NamedValue> &values,
+                                uint64_t expected, uint64_t *newVersion,
+                                const std::function<void()> &committed) {
+  countEvent(Counter::StoreWrites);
+  for (const auto &nv : values) {
+    if (nv.value.data.find('\n') != std::string::npos) {
+      errorMessage = nv.name + ": value contains a line break";
+      return WriteStatus::Failed;
+    }
+    if (nv.name.empty() || nv.name.find_first_of("\t\n") != std::string::npos) {
+      errorMessage = "invalid value name \"" + nv.name + "\"";
+      return WriteStatus::Failed;
+    }
+  }
+
+  std::error_code ec;
+  fs::create_directories(rootDir, ec);
+
+  std::unique_ptr<FileLock> lock;
+  if (locking) {
+    lock = std::make_unique<FileLock>((fs::path(rootDir) / ".lock").string());
+    if (!lock->locked()) {
+      errorMessage = "cannot lock " + rootDir;
+      return WriteStatus::Failed;
+    }
+  }
+
+  std::string file = scopeFile(scope);
+  // An unreadable hive must not be rebuilt from nothing: its version would
+  // match an equally failed read, and the rename would drop every value.
+  std::string buf;
+  if (!slurp(file, buf, errorMessage))
+    return WriteStatus::Failed;
+
+  // Each name is replaced where it stands; the rest are appended.
+  std::unordered_map<std::string, size_t> pending;
+  std::vector<bool> placed(values.size(), false);
+  size_t bytes = buf.size();
+  for (size_t k = 0; k < values.size(); ++k) {
+    // A name given twice keeps its first value.
+    placed[k] = !pending.emplace(toLower(values[k].name), k).second;
+    bytes += values[k].name.size() + values[k].value.data.size() + 20;
+  }
+  auto append = [](std::string &out, std::string_view name, ValueKind kind,
+                   std::string_view value) {
+    out.append(name).append("\t").append(kindName(kind)).append("\t");
+    out.append(value).append("\n");
+  };
+
+  std::string next;
+  next.reserve(bytes + 32);
+  uint64_t version = scanHive(buf, [&](const HiveLine &hl) {
+    auto it = values.size() == 1
+                  ? (iequals(hl.name, values[0].name) ? pending.begin()
+                                                      : pending.end())
+                  : pending.find(toLower(hl.name));
+    if (it == pending.end()) {
+      append(next, hl.name, hl.kind, hl.data);
+      return;
+    }
+    // A repeated name keeps only its first line, as read() sees it.
+    if (placed[it->second])
+      return;
+    const NamedValue &nv = values[it->second];
+    append(next, hl.name, nv.value.kind, nv.value.data);
+    placed[it->second] = true;
+  });
+  if (expected != AnyVersion && version != expected)
+    return WriteStatus::Conflict;
+  for (size_t k = 0; k < values.size(); ++k)
+    if (!placed[k])
+      append(next, values[k].name, values[k].value.kind, values[k].value.data);
+  next.insert(0, "# version " + std::to_string(version + 1) + "\n");
+
+  // Unique per process, in case the lock is off.
+  std::string tmp = file + ".tmp." + std::to_string(processId());
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    out.write(next.data(), static_cast<std::streamsize>(next.size()));
+    out.flush();
+    if (!out) {
+      errorMessage = "cannot write " + tmp;
+      return WriteStatus::Failed;
+    }
+  }
+  fs::rename(tmp, file, ec);
+  if (ec) {
+    errorMessage = "cannot replace " + file + ": " + ec.message();
+    fs::remove(tmp, ec);
+    return WriteStatus::Failed;
+  }
+  if (newVersion)
+    *newVersion = version + 1;
+  if (committed)
+    committed();
+  return WriteStatus::Ok;
+}
+
+std::unique_ptr<Notifier> FileStore::makeNotifier() {
+  return std::make_unique<RecordingNotifier>(
+      (fs::path(rootDir) / "notifications.log").string());
+}
+
+std::string FileStore::journalPath() const {
+  return (fs::path(rootDir) / "journal.log").string();
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  RegistryStore
+// ─────────────────────────────────────────────────────────────────────────────
+#ifdef _WIN32
+namespace {
+
+const char *scopeKey(Scope scope) {
+  return scope == Scope::User
+             ? "Environment"
+             : "SYSTEM\\CurrentControlSet\\Control\\Session Manager\\"
+               "Environment";
+}
+
+// Last-write time of the open key, used as its version stamp.
+uint64_t keyStamp(HKEY hKey) {
+  FILETIME ft{};
+  if (RegQueryInfoKeyA(hKey, nullptr, nullptr, nullptr, nullptr, nullptr,
+                       nullptr, nullptr, nullptr, nullptr, nullptr,
+                       &ft) != ERROR_SUCCESS)
+    return 0;
+  return (static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+}
+
+} // namespace
+
+RegistryStore::~RegistryStore() {
+  if (userRoot)
+    RegCloseKey(userRoot);
+}
+
+HKEY RegistryStore::hive(Scope scope) const {
+  if (scope == Scope::System)
+    return HKEY_LOCAL_MACHINE;
+  return userRoot ? userRoot : HKEY_CURRENT_USER;
+}
+
+bool RegistryStore::read(Scope scope, const std::string &name,
+                         StoreValue &out) {
+  countEvent(Counter::StoreReads);
+  out = StoreValue{};
+  HKEY hKey;
+  LONG res =
+      RegOpenKeyExA(hive(scope), scopeKey(scope), 0, KEY_READ, &hKey);
+  if (res == ERROR_FILE_NOT_FOUND)
+    return true; // an absent key holds no values
+  if (res != ERROR_SUCCESS) {
+    errorMessage = "Failed to open registry key (code " +
+                   std::to_string(res) + ")";
+    return false;
+  }
+
+  // Size the buffer from the value itself; if a writer grows it between
+  // the two calls, ERROR_MORE_DATA reports the new size and we go again.
+  // A stamp that moves during the read means a torn snapshot; retry.
+  DWORD type = 0;
+  DWORD size = 0;
+  for (int attempt = 0; attempt < 8; ++attempt) {
+    uint64_t before = keyStamp(hKey);
+    size = 0;
+    res = RegQueryValueExA(hKey, name.c_str(), nullptr, &type, nullptr, &size);
+    while (res == ERROR_SUCCESS || res == ERROR_MORE_DATA) {
+      out.data.resize(size);
+      res = RegQueryValueExA(hKey, name.c_str(), nullptr, &type,
+                             reinterpret_cast<BYTE *>(out.data.data()), &size);
+      if (res != ERROR_MORE_DATA)
+        break;
+    }
+    out.version = keyStamp(hKey);
+    if (out.version == before)
+      break;
+  }
+  RegCloseKey(hKey);
+
+  if (res == ERROR_FILE_NOT_FOUND) {
+    out.data.clear();
+    return true;
+  }
+  if (res != ERROR_SUCCESS) {
+    out = StoreValue{};
+    errorMessage = "Failed to read registry value " + name + " (code " +
+                   std::to_string(res) + ")";
+    return false;
+  }
+  out.data.resize(size);
+  while (!out.data.empty() && out.data.back() == '\0')
+    out.data.pop_back();
+  out.kind = type == REG_SZ ? ValueKind::String : ValueKind::ExpandString;
+  out.present = true;
+  return true;
+}
+
+bool RegistryStore::readAll(Scope scope, std::vector<NamedValue> &out) {
+  countEvent(Counter::StoreReads);
+  out.clear();
+  HKEY hKey;
+  LONG res = RegOpenKeyExA(hive(scope), scopeKey(scope), 0, KEY_READ, &hKey);
+  if (res == ERROR_FILE_NOT_FOUND)
+    return true;
+  if (res != ERROR_SUCCESS) {
+    errorMessage = "Failed to open registry key (code " +
+                   std::to_string(res) + ")";
+    return false;
+  }
+
+  // Buffers sized once from the key's largest name and value.
+  DWORD count = 0, maxName = 0, maxData = 0;
+  RegQueryInfoKeyA(hKey, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+                   &count, &maxName, &maxData, nullptr, nullptr);
+  uint64_t version = keyStamp(hKey);
+  std::string name(maxName + 1, '\0');
+  std::string data(maxData + 1, '\0');
+  out.reserve(count);
+  for (DWORD i = 0;; ++i) {
+    DWORD nameLen = static_cast<DWORD>(name.size());
+    DWORD dataLen = static_cast<DWORD>(data.size());
+    DWORD type = 0;
+    res = RegEnumValueA(hKey, i, name.data(), &nameLen, nullptr, &type,
+                        reinterpret_cast<BYTE *>(data.data()), &dataLen);
+    if (res == ERROR_MORE_DATA) {
+      // Grew since the size query; resize and read this index again.
+      name.resize(name.size() * 2);
+      data.resize(std::max<size_t>(data.size() * 2, dataLen + 1));
+      --i;
+      continue;
+    }
+    if (res == ERROR_NO_MORE_ITEMS)
+      break;
+    if (res != ERROR_SUCCESS) {
+      RegCloseKey(hKey);
+      out.clear();
+      errorMessage = "Failed to list registry values (code " +
+                     std::to_string(res) + ")";
+      return false;
+    }
+    if (type != REG_SZ && type != REG_EXPAND_SZ)
+      continue;
+    std::string value(data.data(), dataLen);
+    while (!value.empty() && value.back() == '\0')
+      value.pop_back();
+    out.push_back({std::string(name.data(), nameLen),
+                   StoreValue{std::move(value),
+                              type == REG_SZ ? ValueKind::String
+                                             : ValueKind::ExpandString,
+                              true, version}});
+  }
+  RegCloseKey(hKey);
+  return true;
+}
+
+WriteStatus RegistryStore::write(Scope scope, const std::string &name,
+                                 const std::string &data, ValueKind kind,
+                                 uint64_t expected, uint64_t *newVersion,
+                                 const std::function<void()> &committed) {
+  return writeAll(scope, {{name, StoreValue{data, kind, true, 0}}}, expected,
+                  newVersion, committed);
+}
+
+WriteStatus RegistryStore::writeAll(Scope scope,
+                                    const std::vector<NamedValue> &values,
+                                    uint64_t expected, uint64_t *newVersion,
+                                    const std::function<void()> &committed) {
+  countEvent(Counter::StoreWrites);
+  HANDLE mutex = CreateMutexA(nullptr, FALSE,
+                              scope == Scope::User
+                                  ? "Local\\pathmgr-environment-user"
+                                  : "Global\\pathmgr-environment-system");
+  if (mutex)
+    WaitForSingleObject(mutex, INFINITE);
+  auto release = [&] {
+    if (mutex) {
+      ReleaseMutex(mutex);
+      CloseHandle(mutex);
+    }
+  };
+
+  HKEY hKey;
+  LONG res = RegOpenKeyExA(hive(scope), scopeKey(scope), 0,
+                           KEY_SET_VALUE | KEY_QUERY_VALUE, &hKey);
+  if (res != ERROR_SUCCESS) {
+    release();
+    errorMessage = "Failed to open registry key (code " +
+                   std::to_string(res) + ")";
+    return WriteStatus::Failed;
+  }
+
+  if (expected != AnyVersion && keyStamp(hKey) != expected) {
+    RegCloseKey(hKey);
+    release();
+    return WriteStatus::Conflict;
+  }
+
+  std::string failed;
+  for (const auto &nv : values) {
+    const std::string &data = nv.value.data;
+    res = RegSetValueExA(hKey, nv.name.c_str(), 0,
+                         nv.value.kind == ValueKind::String ? REG_SZ
+                                                            : REG_EXPAND_SZ,
+                         reinterpret_cast<const BYTE *>(data.c_str()),
+                         static_cast<DWORD>(data.size() + 1));
+    if (res != ERROR_SUCCESS) {
+      failed = nv.name;
+      break;
+    }
+  }
+  if (newVersion)
+    *newVersion = keyStamp(hKey);
+  RegCloseKey(hKey);
+  if (res == ERROR_SUCCESS && committed)
+    committed();
+  release();
+
+  if (res != ERROR_SUCCESS) {
+    errorMessage = "Failed to set registry value " + failed + " (code " +
+                   std::to_string(res) + ")";
+    return WriteStatus::Failed;
+  }
+  return WriteStatus::Ok;
+}
+
+std::unique_ptr<Notifier> RegistryStore::makeNotifier() {
+  return std::make_unique<BroadcastNotifier>();
+}
+
+std::string RegistryStore::journalPath() const {
+  const char *local = std::getenv("LOCALAPPDATA");
+  if (!local || !*local)
+    return "";
+  return (fs::path(local) / "pathmgr" / "journal.log").string();
+}
+#endif
+
+std::unique_ptr<EnvStore> openDefaultStore() {
+  if (const char *dir = std::getenv("PATHMGR_STORE"); dir && *dir)
+    return std::make_unique<FileStore>(dir);
+#ifdef _WIN32
+  return std::make_unique<RegistryStore>();
+#else
+  const char *home = std::getenv("HOME");
+  return std::make_unique<FileStore>(
+      (fs::path(home ? home : ".") / ".pathmgr").string());
+#endif
+}
+
+} // namespace pathcore
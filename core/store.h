@@ -0,0 +1,172 @@
+#pragma once
+
+#include "notify.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+// From <windows.h>, which stays out of this header
+struct HKEY__;
+typedef struct HKEY__ *HKEY;
+#endif
+
+namespace pathcore {
+
+enum class Scope : uint8_t { User = 0, System = 1 };
+
+// Registry value type the data is stored as.
+enum class ValueKind : uint8_t { String, ExpandString };
+
+enum class WriteStatus : uint8_t {
+  Ok,
+  Conflict, // the scope moved past the expected version; nothing written
+  Failed,
+};
+
+// Pass as `expected` to write unconditionally.
+constexpr uint64_t AnyVersion = ~0ull;
+
+struct StoreValue {
+  std::string data;
+  ValueKind kind = ValueKind::ExpandString;
+  bool present = false;
+  // Stamp of the scope at read time; changes whenever the scope is written.
+  uint64_t version = 0;
+};
+
+struct NamedValue {
+  std::string name;
+  StoreValue value;
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Backing store for the per-scope Environment keys
+// ─────────────────────────────────────────────────────────────────────────────
+class EnvStore {
+public:
+  virtual ~EnvStore() = default;
+
+  // Reads `name` from `scope` in a single pass, however long the value.
+  // A missing value, key or hive is not an error; `out.present` is left
+  // false. Any other failure returns false with lastError() set.
+  virtual bool read(Scope scope, const std::string &name, StoreValue &out) = 0;
+  // Reads every value of `scope` in one pass over the key.
+  virtual bool readAll(Scope scope, std::vector<NamedValue> &out) = 0;
+  // Compare-and-swap: writes only while `scope` is still at `expected`.
+  // On success `*newVersion` receives the scope's new stamp and
+  // `committed` runs before the scope is unlocked, so what it records about
+  // the write (the journal) is ordered as the writes are.
+  virtual WriteStatus write(Scope scope, const std::string &name,
+                            const std::string &data, ValueKind kind,
+                            uint64_t expected = AnyVersion,
+                            uint64_t *newVersion = nullptr,
+                            const std::function<void()> &committed = {}) = 0;
+  // write() for several values of `scope` at once: one lock, one version
+  // check and one new stamp for the whole batch.
+  virtual WriteStatus writeAll(Scope scope,
+                               const std::vector<NamedValue> &values,
+                               uint64_t expected = AnyVersion,
+                               uint64_t *newVersion = nullptr,
+                               const std::function<void()> &committed = {}) = 0;
+
+  // How running programs learn that this store changed; null if they
+  // cannot.
+  virtual std::unique_ptr<Notifier> makeNotifier() { return nullptr; }
+
+  // Where the undo journal for this store lives; empty for none.
+  virtual std::string journalPath() const { return ""; }
+
+  const std::string &lastError() const { return errorMessage; }
+
+protected:
+  std::string errorMessage;
+};
+
+// Stand-in store backed by one text file per scope (`user.env`,
+// `system.env`) in a directory. Each line is `Name<TAB>REG_SZ|REG_EXPAND_SZ
+// <TAB>value`, mirroring the columns of `reg query`, under a `# version N`
+// header that every write bumps.
+//
+// Writes take an exclusive lock on `.lock` in the directory, so the version
+// check and the rename are atomic across processes. Without the lock,
+// concurrent writers can still lose updates between check and rename.
+class FileStore : public EnvStore {
+public:
+  explicit FileStore(std::string root, bool crossProcessLock = true);
+
+  bool read(Scope scope, const std::string &name, StoreValue &out) override;
+  bool readAll(Scope scope, std::vector<NamedValue> &out) override;
+  WriteStatus write(Scope scope, const std::string &name,
+                    const std::string &data, ValueKind kind,
+                    uint64_t expected = AnyVersion,
+                    uint64_t *newVersion = nullptr,
+                    const std::function<void()> &committed = {}) override;
+  // The hive is rewritten once, however many values change.
+  WriteStatus writeAll(Scope scope, const std::vector<NamedValue> &values,
+                       uint64_t expected = AnyVersion,
+                       uint64_t *newVersion = nullptr,
+                       const std::function<void()> &committed = {}) override;
+  // Records notifications in `notifications.log` next to the hives.
+  std::unique_ptr<Notifier> makeNotifier() override;
+  std::string journalPath() const override;
+
+  const std::string &root() const { return rootDir; }
+  std::string scopeFile(Scope scope) const;
+
+private:
+  std::string rootDir;
+  bool locking;
+};
+
+#ifdef _WIN32
+// HKEY_CURRENT_USER\Environment and the Session Manager key under
+// HKEY_LOCAL_MACHINE.
+class RegistryStore : public EnvStore {
+public:
+  RegistryStore() = default;
+  // Another user's Environment key under `userRoot`, that user's hive
+  // (HKEY_USERS\<SID> or a privately loaded NTUSER.DAT). The store closes
+  // it.
+  explicit RegistryStore(HKEY userRoot) : userRoot(userRoot) {}
+  ~RegistryStore() override;
+  RegistryStore(const RegistryStore &) = delete;
+  RegistryStore &operator=(const RegistryStore &) = delete;
+
+  bool read(Scope scope, const std::string &name, StoreValue &out) override;
+  bool readAll(Scope scope, std::vector<NamedValue> &out) override;
+  // The key's last-write time is the version. The check and the set run
+  // under a named mutex, which serializes every instance of this tool;
+  // writers outside it are caught only if they land before the check.
+  WriteStatus write(Scope scope, const std::string &name,
+                    const std::string &data, ValueKind kind,
+                    uint64_t expected = AnyVersion,
+                    uint64_t *newVersion = nullptr,
+                    const std::function<void()> &committed = {}) override;
+  // Each value is set in turn under the same mutex; a failure part-way
+  // leaves the earlier ones set.
+  WriteStatus writeAll(Scope scope, const std::vector<NamedValue> &values,
+                       uint64_t expected = AnyVersion,
+                       uint64_t *newVersion = nullptr,
+                       const std::function<void()> &committed = {}) override;
+  std::unique_ptr<Notifier> makeNotifier() override;
+  // %LOCALAPPDATA%\pathmgr\journal.log
+  std::string journalPath() const override;
+
+private:
+  HKEY hive(Scope scope) const;
+
+  HKEY userRoot = nullptr;
+};
+#endif
+
+// The registry on Windows. Elsewhere, or when PATHMGR_STORE names a
+// directory, a FileStore rooted there (default `~/.pathmgr`).
+std::unique_ptr<EnvStore> openDefaultStore();
+
+const char *scopeName(Scope scope);
+
+} // namespace pathcore
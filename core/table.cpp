@@ -0,0 +1,89 @@
+#include "table.h"
+#include "text.h"
+
+#include <unordered_map>
+
+namespace pathcore {
+
+void PathTable::clear() {
+  arena.clear();
+  scopes.clear();
+  rawOffset.clear();
+  rawLength.clear();
+  expOffset.clear();
+  expLength.clear();
+  keyHashes.clear();
+  flagBits.clear();
+  userCount = 0;
+  rawBytes[0] = rawBytes[1] = 0;
+}
+
+void PathTable::reserve(size_t entries, size_t textBytes) {
+  arena.reserve(textBytes);
+  scopes.reserve(entries);
+  rawOffset.reserve(entries);
+  rawLength.reserve(entries);
+  expOffset.reserve(entries);
+  expLength.reserve(entries);
+  keyHashes.reserve(entries);
+  flagBits.reserve(entries);
+}
+
+uint32_t PathTable::append(Scope scope, std::string_view raw,
+                           std::string_view expanded) {
+  auto index = static_cast<uint32_t>(size());
+  auto rawAt = static_cast<uint32_t>(arena.size());
+  arena.append(raw);
+  uint32_t expAt = rawAt;
+  if (expanded != raw) {
+    expAt = static_cast<uint32_t>(arena.size());
+    arena.append(expanded);
+  }
+
+  scopes.push_back(scope);
+  rawOffset.push_back(rawAt);
+  rawLength.push_back(static_cast<uint32_t>(raw.size()));
+  expOffset.push_back(expAt);
+  expLength.push_back(static_cast<uint32_t>(expanded.size()));
+
+  keyHashes.push_back(canonicalHash(expanded));
+  flagBits.push_back(0);
+  rawBytes[static_cast<int>(scope)] += raw.size();
+  if (scope == Scope::User)
+    userCount++;
+  return index;
+}
+
+void PathTable::markDuplicates() {
+  std::unordered_map<uint64_t, uint32_t> first;
+  first.reserve(size());
+  for (uint32_t i = 0; i < size(); ++i) {
+    flagBits[i] &= ~Duplicate;
+    auto [it, inserted] = first.emplace(keyHashes[i], i);
+    // Equal hashes are confirmed on the keys so a collision never merges
+    // two different directories.
+    if (!inserted &&
+        canonicalKey(expanded(it->second)) == canonicalKey(expanded(i)))
+      flagBits[i] |= Duplicate;
+  }
+}
+
+std::string PathTable::joinRaw(Scope scope) const {
+  std::string out;
+  for (uint32_t i = begin(scope); i < end(scope); ++i) {
+    if (i > begin(scope))
+      out += ';';
+    out.append(raw(i));
+  }
+  return out;
+}
+
+size_t PathTable::memoryBytes() const {
+  return arena.capacity() + scopes.capacity() * sizeof(Scope) +
+         (rawOffset.capacity() + rawLength.capacity() + expOffset.capacity() +
+          expLength.capacity()) *
+             sizeof(uint32_t) +
+         keyHashes.capacity() * sizeof(uint64_t) + flagBits.capacity();
+}
+
+} // namespace pathcore
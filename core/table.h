@@ -0,0 +1,77 @@
+#pragma once
+
+#include "store.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pathcore {
+
+// Per-entry status bits kept alongside the text columns.
+enum EntryFlags : uint8_t {
+  Probed = 1 << 0,    // existence has been checked
+  Exists = 1 << 1,    // expanded text names a directory
+  Duplicate = 1 << 2, // an earlier entry has the same canonical key
+};
+
+// Struct-of-arrays table of list entries, loaded once per session. Text
+// lives in a single arena; an entry whose expanded form equals its raw
+// form shares the same bytes. User entries come first, then system.
+class PathTable {
+public:
+  void clear();
+  void reserve(size_t entries, size_t textBytes);
+  uint32_t append(Scope scope, std::string_view raw, std::string_view expanded);
+  // Sets `Duplicate` on every entry whose key appeared earlier; one pass.
+  void markDuplicates();
+
+  size_t size() const { return scopes.size(); }
+  bool empty() const { return scopes.empty(); }
+  uint32_t count(Scope scope) const {
+    return scope == Scope::User ? userCount
+                                : static_cast<uint32_t>(size()) - userCount;
+  }
+  // Index range [begin, end) of one scope's entries.
+  uint32_t begin(Scope scope) const {
+    return scope == Scope::User ? 0 : userCount;
+  }
+  uint32_t end(Scope scope) const {
+    return scope == Scope::User ? userCount : static_cast<uint32_t>(size());
+  }
+
+  Scope scope(uint32_t i) const { return scopes[i]; }
+  std::string_view raw(uint32_t i) const {
+    return {arena.data() + rawOffset[i], rawLength[i]};
+  }
+  std::string_view expanded(uint32_t i) const {
+    return {arena.data() + expOffset[i], expLength[i]};
+  }
+  uint64_t keyHash(uint32_t i) const { return keyHashes[i]; }
+  uint8_t flags(uint32_t i) const { return flagBits[i]; }
+  void setFlags(uint32_t i, uint8_t bits) { flagBits[i] |= bits; }
+
+  // Raw entries of one scope joined back into a list value.
+  std::string joinRaw(Scope scope) const;
+  // Length joinRaw(scope) would have, kept up to date by append().
+  size_t valueLength(Scope scope) const {
+    uint32_t n = count(scope);
+    return n ? rawBytes[static_cast<int>(scope)] + n - 1 : 0;
+  }
+
+  // Bytes held by the table, for footprint reporting.
+  size_t memoryBytes() const;
+
+private:
+  std::string arena;
+  std::vector<Scope> scopes;
+  std::vector<uint32_t> rawOffset, rawLength;
+  std::vector<uint32_t> expOffset, expLength;
+  std::vector<uint64_t> keyHashes;
+  std::vector<uint8_t> flagBits;
+  uint32_t userCount = 0;
+  size_t rawBytes[2] = {0, 0};
+};
+
+} // namespace pathcore
@@ -0,0 +1,218 @@
+#include "text.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace pathcore {
+
+bool iequals(std::string_view a, std::string_view b) {
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); i++)
+    if (tolower(static_cast<unsigned char>(a[i])) !=
+        tolower(static_cast<unsigned char>(b[i])))
+      return false;
+  return true;
+}
+
+std::string toLower(std::string_view s) {
+  std::string out(s);
+  for (auto &c : out)
+    c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+  return out;
+}
+
+bool icontains(std::string_view hay, std::string_view needle) {
+  if (needle.empty())
+    return true;
+  auto it = std::search(hay.begin(), hay.end(), needle.begin(), needle.end(),
+                        [](char a, char b) {
+                          return tolower(static_cast<unsigned char>(a)) ==
+                                 tolower(static_cast<unsigned char>(b));
+                        });
+  return it != hay.end();
+}
+
+std::vector<std::string> splitPath(std::string_view value) {
+  std::vector<std::string> parts;
+  size_t start = 0;
+  while (start <= value.size()) {
+    size_t end = value.find(';', start);
+    if (end == std::string_view::npos)
+      end = value.size();
+    if (end > start)
+      parts.emplace_back(value.substr(start, end - start));
+    start = end + 1;
+  }
+  return parts;
+}
+
+std::string joinPath(const std::vector<std::string> &entries) {
+  std::string out;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (i > 0)
+      out += ';';
+    out += entries[i];
+  }
+  return out;
+}
+
+namespace {
+
+inline bool isSeparator(char c) { return c == '\\' || c == '/'; }
+
+// Length of `path` once trailing separators are dropped, keeping the root
+// of `C:\` and `/`.
+size_t keyLength(std::string_view path) {
+  size_t n = path.size();
+  while (n > 1 && isSeparator(path[n - 1]) && !(n == 3 && path[1] == ':'))
+    n--;
+  return n;
+}
+
+inline char keyChar(char c) {
+  return c == '/' ? '\\'
+                  : static_cast<char>(tolower(static_cast<unsigned char>(c)));
+}
+
+} // namespace
+
+std::string canonicalKey(std::string_view path) {
+  size_t n = keyLength(path);
+  std::string key(n, '\0');
+  for (size_t i = 0; i < n; ++i)
+    key[i] = keyChar(path[i]);
+  return key;
+}
+
+uint64_t canonicalHash(std::string_view path) {
+  uint64_t h = 1469598103934665603ull;
+  size_t n = keyLength(path);
+  for (size_t i = 0; i < n; ++i) {
+    h ^= static_cast<unsigned char>(keyChar(path[i]));
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+bool globMatch(std::string_view pattern, std::string_view text) {
+  size_t p = 0, t = 0, star = std::string_view::npos, resume = 0;
+  while (t < text.size()) {
+    if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+      p++, t++;
+    } else if (p < pattern.size() && pattern[p] == '*') {
+      star = p++;
+      resume = t;
+    } else if (star != std::string_view::npos) {
+      p = star + 1;
+      t = ++resume;
+    } else {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '*')
+    p++;
+  return p == pattern.size();
+}
+
+uint64_t contentHash(std::string_view s) {
+  uint64_t h = 1469598103934665603ull;
+  for (char c : s) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+std::string jsonQuote(std::string_view s) {
+  static const char hex[] = "0123456789abcdef";
+  std::string out;
+  out.reserve(s.size() + 2);
+  out += '"';
+  for (char c : s) {
+    auto u = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (c == '\n') {
+      out += "\\n";
+    } else if (c == '\t') {
+      out += "\\t";
+    } else if (c == '\r') {
+      out += "\\r";
+    } else if (u < 0x20) {
+      out += "\\u00";
+      out += hex[u >> 4];
+      out += hex[u & 15];
+    } else {
+      out += c;
+    }
+  }
+  out += '"';
+  return out;
+}
+
+std::string Expander::expand(const std::string &str) {
+  if (str.find('%') == std::string::npos)
+    return str;
+  auto it = memo.find(str);
+  if (it != memo.end()) {
+    countEvent(Counter::ExpandHits);
+    return it->second;
+  }
+  countEvent(Counter::ExpandMisses);
+  TraceSpan span(Phase::Expand);
+
+  std::string out;
+#ifdef _WIN32
+  DWORD needed = ExpandEnvironmentStringsA(str.c_str(), nullptr, 0);
+  if (needed > 0) {
+    out.resize(needed);
+    DWORD got = ExpandEnvironmentStringsA(str.c_str(), out.data(), needed);
+    out.resize(got > 0 && got <= needed ? got - 1 : 0);
+  }
+  if (out.empty())
+    out = str;
+#else
+  // Same rules as ExpandEnvironmentStrings: unknown names stay literal.
+  size_t i = 0;
+  while (i < str.size()) {
+    size_t open = str.find('%', i);
+    size_t close =
+        open == std::string::npos ? open : str.find('%', open + 1);
+    if (close == std::string::npos) {
+      out.append(str, i, std::string::npos);
+      break;
+    }
+    out.append(str, i, open - i);
+    std::string name = str.substr(open + 1, close - open - 1);
+    const char *value = name.empty() ? nullptr : std::getenv(name.c_str());
+    if (!value && !name.empty()) {
+      std::string upper = name;
+      for (auto &c : upper)
+        c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+      value = std::getenv(upper.c_str());
+    }
+    if (value) {
+      out += value;
+      i = close + 1;
+    } else {
+      out.append(str, open, close - open);
+      i = close;
+    }
+  }
+#endif
+  memo.emplace(str, out);
+  return out;
+}
+
+} // namespace pathcore
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace pathcore {
+
+bool iequals(std::string_view a, std::string_view b);
+std::string toLower(std::string_view s);
+// Case-insensitive substring test; an empty needle is found anywhere.
+bool icontains(std::string_view hay, std::string_view needle);
+
+// Splits a `;`-separated list value, dropping empty items.
+std::vector<std::string> splitPath(std::string_view value);
+std::string joinPath(const std::vector<std::string> &entries);
+
+// Case-folded, separator-normalized form used to compare entries:
+// `C:/Tools/` and `c:\tools` share a key.
+std::string canonicalKey(std::string_view path);
+// FNV-1a hash of canonicalKey(path), computed without building the key.
+uint64_t canonicalHash(std::string_view path);
+
+// Glob over canonical keys: `*` spans any run of characters, separators
+// included; `?` is one character.
+bool globMatch(std::string_view pattern, std::string_view text);
+
+// FNV-1a hash of the exact bytes.
+uint64_t contentHash(std::string_view s);
+
+// `s` as a JSON string literal, quotes included.
+std::string jsonQuote(std::string_view s);
+
+// Expands `%NAME%` references. Results are memoized per input, so repeated
+// entries across scopes are expanded once.
+class Expander {
+public:
+  std::string expand(const std::string &str);
+  void clear() { memo.clear(); }
+
+private:
+  std::unordered_map<std::string, std::string> memo;
+};
+
+} // namespace pathcore
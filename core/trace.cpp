@@ -0,0 +1,131 @@
+#include "trace.h"
+#include "text.h"
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace pathcore {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Event {
+  Phase phase;
+  uint32_t thread;
+  uint64_t start, duration; // ns since tracing started
+};
+
+constexpr size_t kPhases = static_cast<size_t>(Phase::Count);
+constexpr size_t kCounters = static_cast<size_t>(Counter::Count);
+
+Clock::time_point origin;
+bool keepEvents = false;
+std::atomic<uint64_t> spanCounts[kPhases], spanNanos[kPhases];
+std::atomic<uint64_t> counters[kCounters];
+std::atomic<uint32_t> nextThread{0};
+std::mutex eventsMu;
+std::vector<Event> events;
+
+uint64_t nanosNow() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                           origin)
+          .count());
+}
+
+// Small, stable thread ids for the trace viewer, in order of first span.
+uint32_t threadId() {
+  thread_local uint32_t id = nextThread.fetch_add(1) + 1;
+  return id;
+}
+
+} // namespace
+
+namespace detail {
+std::atomic<bool> tracing{false};
+
+void count(Counter counter, uint64_t n) {
+  counters[static_cast<size_t>(counter)].fetch_add(n,
+                                                   std::memory_order_relaxed);
+}
+} // namespace detail
+
+const char *phaseName(Phase phase) {
+  static const char *const names[] = {"load",  "split",  "expand",
+                                      "canonicalize", "probe", "render",
+                                      "write", "broadcast"};
+  return names[static_cast<size_t>(phase)];
+}
+
+const char *counterName(Counter counter) {
+  static const char *const names[] = {"store reads",      "store writes",
+                                      "file stats",       "probe cache hits",
+                                      "expansion hits",   "expansions"};
+  return names[static_cast<size_t>(counter)];
+}
+
+void startTracing(bool events) {
+  origin = Clock::now();
+  keepEvents = events;
+  detail::tracing.store(true);
+}
+
+void TraceSpan::begin() { start = nanosNow() + 1; }
+
+void TraceSpan::end() {
+  uint64_t from = start - 1, duration = nanosNow() - from;
+  auto p = static_cast<size_t>(phase);
+  spanCounts[p].fetch_add(1, std::memory_order_relaxed);
+  spanNanos[p].fetch_add(duration, std::memory_order_relaxed);
+  if (keepEvents) {
+    std::lock_guard<std::mutex> lock(eventsMu);
+    events.push_back({phase, threadId(), from, duration});
+  }
+}
+
+PhaseTotal phaseTotal(Phase phase) {
+  auto p = static_cast<size_t>(phase);
+  return {spanCounts[p].load(), static_cast<double>(spanNanos[p].load()) / 1e6};
+}
+
+uint64_t counterTotal(Counter counter) {
+  return counters[static_cast<size_t>(counter)].load();
+}
+
+double tracingMillis() { return static_cast<double>(nanosNow()) / 1e6; }
+
+bool writeChromeTrace(const std::string &file, std::string &error) {
+  std::ofstream out(file, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    error = "cannot write " + file;
+    return false;
+  }
+  // Trace timestamps are microseconds; keep a tenth for short probes.
+  auto micros = [](uint64_t ns) {
+    return std::to_string(ns / 1000) + "." + std::to_string(ns / 100 % 10);
+  };
+
+  std::lock_guard<std::mutex> lock(eventsMu);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  for (const Event &e : events)
+    out << "{\"name\":" << jsonQuote(phaseName(e.phase))
+        << ",\"cat\":\"pathmgr\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+        << ",\"ts\":" << micros(e.start) << ",\"dur\":" << micros(e.duration)
+        << "},\n";
+  out << "{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":"
+      << micros(nanosNow()) << ",\"args\":{";
+  for (size_t c = 0; c < kCounters; ++c)
+    out << (c ? "," : "") << jsonQuote(counterName(static_cast<Counter>(c)))
+        << ":" << counters[c].load();
+  out << "}}\n]}\n";
+  if (!out) {
+    error = "cannot write " + file;
+    return false;
+  }
+  return true;
+}
+
+} // namespace pathcore
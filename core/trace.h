@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace pathcore {
+
+// Phases of a command, timed by TraceSpan. Spans nest: Expand runs inside
+// Split, which with Canonicalize builds the table that follows Load.
+enum class Phase : uint8_t {
+  Load,         // store reads
+  Split,        // raw values into table entries
+  Expand,       // %VAR% references the memo does not hold
+  Canonicalize, // entry keys and duplicate marking
+  Probe,        // one filesystem stat on a probe cache miss
+  Render,       // output
+  Write,        // store write and journal append
+  Broadcast,    // change notification, on the dispatcher thread
+  Count
+};
+
+enum class Counter : uint8_t {
+  StoreReads,   // registry / stand-in store reads
+  StoreWrites,
+  FileStats,    // stats the probe cache could not answer
+  ProbeHits,
+  ExpandHits,   // %VAR% entries served from the memo
+  ExpandMisses,
+  Count
+};
+
+const char *phaseName(Phase phase);
+const char *counterName(Counter counter);
+
+namespace detail {
+extern std::atomic<bool> tracing;
+void count(Counter counter, uint64_t n);
+} // namespace detail
+
+// Starts collecting phase totals and counters; with `events`, every span
+// is also kept for writeChromeTrace. Until then spans and counts cost one
+// relaxed load each. Call once, before starting threads.
+void startTracing(bool events);
+inline bool tracingEnabled() {
+  return detail::tracing.load(std::memory_order_relaxed);
+}
+
+inline void countEvent(Counter counter, uint64_t n = 1) {
+  if (tracingEnabled())
+    detail::count(counter, n);
+}
+
+// Times the enclosing scope as one `phase` span on the calling thread.
+class TraceSpan {
+public:
+  explicit TraceSpan(Phase phase) : phase(phase) {
+    if (tracingEnabled())
+      begin();
+  }
+  ~TraceSpan() {
+    if (start)
+      end();
+  }
+  TraceSpan(const TraceSpan &) = delete;
+  TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+  void begin();
+  void end();
+
+  Phase phase;
+  uint64_t start = 0; // ns since tracing started, offset by one; 0 if off
+};
+
+struct PhaseTotal {
+  uint64_t spans = 0;
+  double ms = 0; // summed over threads, so parallel probes can exceed wall time
+};
+
+// Totals since startTracing.
+PhaseTotal phaseTotal(Phase phase);
+uint64_t counterTotal(Counter counter);
+double tracingMillis();
+
+// Writes the kept spans, and the counters as a final counter event, in the
+// Chrome trace-event format (chrome://tracing, Perfetto).
+bool writeChromeTrace(const std::string &file, std::string &error);
+
+} // namespace pathcore
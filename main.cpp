@@ -2,116 +2,520 @@
 
 using namespace Colors;
 
-class PathManager {
-private:
-  std::vector<std::string> userPaths;
-  std::vector<std::string> systemPaths;
+// Escape sequence for a run of Colors manipulators, for Screen styles.
+template <typename... M> std::string sgr(M... m) {
+  std::ostringstream os;
+  (os << ... << m);
+  return os.str();
+}
 
-  std::string getEnvironmentVariable(const std::string &varName,
-                                     HKEY hive = HKEY_CURRENT_USER) {
-    DWORD bufSize = 128;
-    std::string buffer;
-    DWORD copied = 0;
+// ─────────────────────────────────────────────────────────────────────────────
+//  Browser: full-screen view of the loaded table (browse)
+// ─────────────────────────────────────────────────────────────────────────────
+// Only the rows on screen are probed and drawn, and each frame is flushed
+// as a diff of the previous one, so the cost of a keystroke does not grow
+// with the PATH. Edits to user entries are staged and written back as one
+// update.
+class Browser {
+public:
+  Browser(pathcore::Session &session, std::string var)
+      : session(session), var(std::move(var)) {
+    reload();
+  }
+
+  void run() {
+    pathcore::Terminal term;
+    if (!term.ok()) {
+      std::cerr << "❌ browse needs an interactive console.\n";
+      return;
+    }
+    plain = screen.style("");
+    title = screen.style(sgr(Colors::bold, Colors::text::bright_white,
+                             Colors::bg::bg_purple));
+    header = screen.style(sgr(Colors::bold, Colors::text::purple));
+    user = screen.style(sgr(Colors::text::teal));
+    system = screen.style(sgr(Colors::text::turquoise));
+    good = screen.style(sgr(Colors::text::bright_green));
+    bad = screen.style(sgr(Colors::text::bright_red));
+    staged = screen.style(sgr(Colors::text::bright_yellow));
+    cursorRow = screen.style(sgr(Colors::reverse));
+    dim = screen.style(sgr(Colors::text::bright_black));
+    input = screen.style(sgr(Colors::bold, Colors::text::bright_cyan));
 
-    // Try environment variable first
     for (;;) {
-      buffer.resize(bufSize);
-      copied = GetEnvironmentVariableA(varName.c_str(), buffer.data(), bufSize);
-      if (copied == 0)
+      int h, w;
+      term.size(h, w);
+      if (h != screen.rows() || w != screen.cols())
+        screen.resize(h, w);
+      draw();
+      term.write(screen.flush());
+      if (!handle(term.read()))
         break;
-      if (copied < bufSize) {
-        buffer.resize(copied);
-        return buffer;
-      }
-      bufSize = copied + 1;
-    }
-
-    // If not found, try registry
-    HKEY hKey;
-    std::string regPath = (hive == HKEY_CURRENT_USER)
-                              ? "Environment"
-                              : "SYSTEM\\CurrentControlSet\\Control\\Session "
-                                "Manager\\Environment";
-
-    LONG res = RegOpenKeyExA(hive, regPath.c_str(), 0, KEY_READ, &hKey);
-    if (res == ERROR_SUCCESS) {
-      bufSize = 32768; // Larger buffer for registry
-      buffer.resize(bufSize);
-      DWORD type;
-      res = RegQueryValueExA(hKey, varName.c_str(), nullptr, &type,
-                             reinterpret_cast<BYTE *>(buffer.data()), &bufSize);
-      RegCloseKey(hKey);
-
-      if (res == ERROR_SUCCESS && bufSize > 0) {
-        buffer.resize(bufSize - 1); // Remove null terminator
-        return buffer;
-      }
     }
+  }
 
-    return "";
+private:
+  struct Row {
+    std::string raw, expanded, folded;
+    pathcore::Scope scope;
+    int origin; // index in `loaded`, -1 if added here
+  };
+  enum class Mode { Browse, Filter, Edit, Add, ConfirmQuit };
+
+  // Rebuilds the rows from a fresh read, dropping anything staged.
+  void reload() {
+    session.load(var);
+    const auto &t = session.table();
+    rows.clear();
+    loaded.clear();
+    rows.reserve(t.size());
+    for (uint32_t i = 0; i < t.size(); ++i) {
+      bool u = t.scope(i) == pathcore::Scope::User;
+      if (u)
+        loaded.emplace_back(t.raw(i));
+      rows.push_back(makeRow(std::string(t.raw(i)), t.scope(i),
+                             u ? static_cast<int>(i) : -1));
+    }
+    userRows = loaded.size();
+    refilter();
   }
 
-public:
-  void loadPaths() {
-    std::string userPath = getEnvironmentVariable("PATH", HKEY_CURRENT_USER);
-    std::string systemPath = getEnvironmentVariable("PATH", HKEY_LOCAL_MACHINE);
-    if (userPath == systemPath) {
-      userPaths = splitPath(userPath);
-      systemPaths.clear(); // don’t double‑count
+  Row makeRow(std::string raw, pathcore::Scope scope, int origin) {
+    std::string expanded = session.expand(raw);
+    std::string folded = pathcore::toLower(expanded);
+    return {std::move(raw), std::move(expanded), std::move(folded), scope,
+            origin};
+  }
+
+  // Keeps the selected row selected if it still matches.
+  void refilter() {
+    size_t selected = visible.empty() ? 0 : visible[cursor];
+    std::string needle = pathcore::toLower(filter);
+    visible.clear();
+    for (size_t r = 0; r < rows.size(); ++r)
+      if (needle.empty() || rows[r].folded.find(needle) != std::string::npos)
+        visible.push_back(r);
+    auto it = std::lower_bound(visible.begin(), visible.end(), selected);
+    cursor = it == visible.end() ? (visible.empty() ? 0 : visible.size() - 1)
+                                 : static_cast<size_t>(it - visible.begin());
+  }
+
+  bool isUser(size_t r) const { return r < userRows; }
+  size_t selected() const { return visible.empty() ? rows.size() : visible[cursor]; }
+
+  std::vector<std::string> stagedEntries() const {
+    std::vector<std::string> out;
+    for (size_t r = 0; r < userRows; ++r)
+      out.push_back(rows[r].raw);
+    return out;
+  }
+
+  void select(size_t row) {
+    refilter();
+    auto it = std::find(visible.begin(), visible.end(), row);
+    if (it == visible.end()) { // hidden by the filter; show everything
+      filter.clear();
+      refilter();
+      it = std::find(visible.begin(), visible.end(), row);
+    }
+    cursor = static_cast<size_t>(it - visible.begin());
+  }
+
+  // ── Staging ────────────────────────────────────────────────────────────────
+  void move(int delta) {
+    size_t r = selected();
+    if (!isUser(r) || (delta < 0 && r == 0) || (delta > 0 && r + 1 >= userRows))
+      return;
+    size_t to = delta < 0 ? r - 1 : r + 1;
+    std::swap(rows[r], rows[to]);
+    select(to);
+  }
+
+  void remove() {
+    size_t r = selected();
+    if (!isUser(r))
+      return;
+    rows.erase(rows.begin() + static_cast<std::ptrdiff_t>(r));
+    userRows--;
+    refilter();
+  }
+
+  void commitInput() {
+    if (line.empty())
+      return;
+    if (mode == Mode::Edit) {
+      size_t r = selected();
+      rows[r] = makeRow(line, pathcore::Scope::User, rows[r].origin);
+      select(r);
     } else {
-      userPaths = splitPath(userPath);
-      systemPaths = splitPath(systemPath);
+      size_t at = isUser(selected()) ? selected() + 1 : userRows;
+      rows.insert(rows.begin() + static_cast<std::ptrdiff_t>(at),
+                  makeRow(line, pathcore::Scope::User, -1));
+      userRows++;
+      select(at);
     }
   }
 
-  std::vector<std::string> splitPath(const std::string &path) {
-    std::vector<std::string> parts;
-    std::stringstream iss(path);
-    std::string token;
+  void write() {
+    auto proposed = stagedEntries();
+    if (proposed == loaded) {
+      message = "Nothing staged.";
+      return;
+    }
+    auto edit = [&](std::vector<std::string> &entries) {
+      if (entries != loaded)
+        return pathcore::EditResult::Abort;
+      entries = proposed;
+      return pathcore::EditResult::Changed;
+    };
+    auto result = session.update(pathcore::Scope::User, edit);
+    switch (result.status) {
+    case pathcore::CommitStatus::Committed:
+    case pathcore::CommitStatus::Unchanged: {
+      size_t row = selected();
+      reload();
+      if (row < rows.size())
+        select(row);
+      message = "✓ User " + var + " written.";
+      break;
+    }
+    case pathcore::CommitStatus::Aborted:
+      message = "✗ " + var + " changed outside; press R to reload.";
+      break;
+    case pathcore::CommitStatus::Conflict:
+      message = "✗ " + var + " kept changing; nothing written.";
+      break;
+    default:
+      message = "✗ " + session.lastError();
+    }
+  }
 
-    while (std::getline(iss, token, ';')) {
-      if (!token.empty()) {
-        // Expand environment variables
-        std::string expanded = expandEnvironmentStrings(token);
-        parts.push_back(expanded);
+  // "+a -d ~c" against the loaded list, empty if nothing is staged.
+  std::string changes() const {
+    size_t added = 0, kept = 0, edited = 0;
+    bool moved = false;
+    int last = -1;
+    for (size_t r = 0; r < userRows; ++r) {
+      int o = rows[r].origin;
+      if (o < 0) {
+        added++;
+        continue;
       }
+      kept++;
+      if (rows[r].raw != loaded[static_cast<size_t>(o)])
+        edited++;
+      moved |= o < last;
+      last = o;
     }
-    return parts;
+    size_t removed = loaded.size() - kept;
+    if (!added && !removed && !edited && !moved)
+      return "";
+    std::string s = "staged:";
+    if (added)
+      s += " +" + std::to_string(added);
+    if (removed)
+      s += " -" + std::to_string(removed);
+    if (edited)
+      s += " ~" + std::to_string(edited);
+    if (moved)
+      s += " reordered";
+    return s;
   }
 
-  std::string expandEnvironmentStrings(const std::string &str) {
-    char buffer[32768];
-    DWORD result =
-        ExpandEnvironmentStringsA(str.c_str(), buffer, sizeof(buffer));
-    if (result > 0 && result <= sizeof(buffer)) {
-      return std::string(buffer);
+  // ── Input ──────────────────────────────────────────────────────────────────
+  // Returns false to leave the browser.
+  bool handle(pathcore::Key key) {
+    using pathcore::KeyCode;
+    if (key.code == KeyCode::None)
+      return true;
+    message.clear();
+
+    if (mode == Mode::ConfirmQuit) {
+      if (key.code == KeyCode::Char && (key.ch == 'y' || key.ch == 'Y'))
+        return false;
+      mode = Mode::Browse;
+      return true;
     }
-    return str;
+
+    if (mode == Mode::Filter || mode == Mode::Edit || mode == Mode::Add) {
+      std::string &text = mode == Mode::Filter ? filter : line;
+      switch (key.code) {
+      case KeyCode::Enter:
+        if (mode != Mode::Filter)
+          commitInput();
+        mode = Mode::Browse;
+        return true;
+      case KeyCode::Escape:
+        if (mode == Mode::Filter) {
+          filter.clear();
+          refilter();
+        }
+        mode = Mode::Browse;
+        return true;
+      case KeyCode::Backspace:
+        while (!text.empty() && (text.back() & 0xC0) == 0x80)
+          text.pop_back();
+        if (!text.empty())
+          text.pop_back();
+        break;
+      case KeyCode::Char:
+        appendUtf8(text, key.ch);
+        break;
+      default:
+        break;
+      }
+      if (mode == Mode::Filter)
+        refilter();
+      return true;
+    }
+
+    size_t page = static_cast<size_t>(std::max(listHeight() - 1, 1));
+    switch (key.code) {
+    case KeyCode::Up: cursor -= cursor > 0; break;
+    case KeyCode::Down: cursor += cursor + 1 < visible.size(); break;
+    case KeyCode::PageUp: cursor -= std::min(cursor, page); break;
+    case KeyCode::PageDown:
+      cursor = visible.empty() ? 0 : std::min(cursor + page, visible.size() - 1);
+      break;
+    case KeyCode::Home: cursor = 0; break;
+    case KeyCode::End: cursor = visible.empty() ? 0 : visible.size() - 1; break;
+    case KeyCode::Delete: remove(); break;
+    case KeyCode::Escape:
+      if (!filter.empty()) {
+        filter.clear();
+        refilter();
+        break;
+      }
+      return quit();
+    case KeyCode::Enter:
+      return edit();
+    case KeyCode::Char:
+      switch (key.ch) {
+      case 'q': case 3: return quit();
+      case '/': mode = Mode::Filter; break;
+      case 'e': return edit();
+      case 'a': mode = Mode::Add; line.clear(); break;
+      case 'd': remove(); break;
+      case 'K': move(-1); break;
+      case 'J': move(+1); break;
+      case 'w': write(); break;
+      case 'R': reload(); message = "Reloaded; staged changes dropped."; break;
+      case 'k': cursor -= cursor > 0; break;
+      case 'j': cursor += cursor + 1 < visible.size(); break;
+      }
+      break;
+    default:
+      break;
+    }
+    return true;
   }
 
-  bool isequals(const std::string &a, const std::string &b) {
-    if (a.size() != b.size())
-      return false;
-    for (size_t i = 0; i < a.size(); i++)
-      if (tolower(a[i]) != tolower(b[i]))
-        return false;
+  bool edit() {
+    if (!isUser(selected())) {
+      message = "System entries are read-only.";
+      return true;
+    }
+    line = rows[selected()].raw;
+    mode = Mode::Edit;
     return true;
   }
 
-  bool directoryExists(const std::string &path) {
-    try {
-      return std::filesystem::exists(path) &&
-             std::filesystem::is_directory(path);
-    } catch (...) {
+  bool quit() {
+    if (changes().empty())
       return false;
+    mode = Mode::ConfirmQuit;
+    return true;
+  }
+
+  static void appendUtf8(std::string &s, char32_t u) {
+    if (u < 0x20)
+      return;
+    if (u < 0x80) {
+      s += static_cast<char>(u);
+    } else if (u < 0x800) {
+      s += static_cast<char>(0xC0 | (u >> 6));
+      s += static_cast<char>(0x80 | (u & 0x3F));
+    } else if (u < 0x10000) {
+      s += static_cast<char>(0xE0 | (u >> 12));
+      s += static_cast<char>(0x80 | ((u >> 6) & 0x3F));
+      s += static_cast<char>(0x80 | (u & 0x3F));
+    } else {
+      s += static_cast<char>(0xF0 | (u >> 18));
+      s += static_cast<char>(0x80 | ((u >> 12) & 0x3F));
+      s += static_cast<char>(0x80 | ((u >> 6) & 0x3F));
+      s += static_cast<char>(0x80 | (u & 0x3F));
+    }
+  }
+
+  // Last `n` code points of `s`, led by "..." if cut.
+  static std::string tail(std::string_view s, size_t n) {
+    size_t points = 0;
+    for (char c : s)
+      points += (c & 0xC0) != 0x80;
+    if (points <= n)
+      return std::string(s);
+    size_t skip = points - std::min(n, points) + 3, i = 0;
+    for (; i < s.size() && skip; --skip)
+      while (++i < s.size() && (s[i] & 0xC0) == 0x80)
+        ;
+    return "..." + std::string(s.substr(i));
+  }
+
+  // ── Drawing ────────────────────────────────────────────────────────────────
+  int listHeight() const { return screen.rows() - 5; }
+
+  void draw() {
+    int h = screen.rows(), w = screen.cols();
+    screen.clear();
+    if (h < 6 || w < 20)
+      return;
+
+    std::string status = changes();
+    int c = screen.put(0, 0, " " + var + " BROWSER  " +
+                                 std::to_string(rows.size()) + " entries (" +
+                                 std::to_string(userRows) + " user, " +
+                                 std::to_string(rows.size() - userRows) +
+                                 " system)", title);
+    screen.fill(0, c, title);
+    if (!status.empty())
+      screen.put(0, std::max(c + 2, w - static_cast<int>(status.size()) - 1),
+                 status, title);
+
+    c = screen.put(1, 0, " / ", mode == Mode::Filter ? input : dim);
+    c = screen.put(1, c, filter.empty() && mode != Mode::Filter ? "filter" : filter,
+                   mode == Mode::Filter ? input : dim);
+    std::string shown = std::to_string(visible.size()) + " shown";
+    screen.put(1, std::max(c + 2, w - static_cast<int>(shown.size()) - 1), shown,
+               dim);
+
+    screen.put(2, 0, "     #  ok  Type  Path", header);
+
+    // Keep the cursor inside the window
+    size_t window = static_cast<size_t>(listHeight());
+    if (cursor < top)
+      top = cursor;
+    if (cursor >= top + window)
+      top = cursor - window + 1;
+    if (top + window > visible.size())
+      top = visible.size() > window ? visible.size() - window : 0;
+
+    for (size_t k = 0; k < window && top + k < visible.size(); ++k) {
+      size_t r = visible[top + k];
+      const Row &row = rows[r];
+      int y = 3 + static_cast<int>(k);
+      bool here = top + k == cursor;
+      bool ok = session.valid(row.expanded);
+      bool changed = isUser(r) && (row.origin < 0 ||
+                                   row.raw != loaded[static_cast<size_t>(row.origin)]);
+      std::string idx = std::to_string(r + 1);
+      c = screen.put(y, 0, here ? " > " : "   ", here ? cursorRow : plain);
+      c = screen.put(y, c, std::string(4 - std::min<size_t>(idx.size(), 4), ' ') + idx,
+                     here ? cursorRow : dim);
+      c = screen.put(y, c, ok ? "  ✓   " : "  ✗   ", ok ? good : bad);
+      c = screen.put(y, c, isUser(r) ? "USER  " : "SYS   ",
+                     isUser(r) ? user : system);
+      size_t room = static_cast<size_t>(std::max(w - c - 1, 4));
+      uint16_t pathStyle = here ? cursorRow : changed ? staged : plain;
+      c = screen.put(y, c, tail(row.expanded, room), pathStyle);
+      if (here)
+        screen.fill(y, c, cursorRow);
+    }
+    if (visible.empty())
+      screen.put(3, 3, "No entries match.", dim);
+
+    int y = h - 2;
+    if (mode == Mode::Edit || mode == Mode::Add) {
+      c = screen.put(y, 0, mode == Mode::Edit ? " edit: " : " add: ", header);
+      c = screen.put(y, c, line, input);
+      screen.put(y, c, "_", input);
+    } else if (mode == Mode::ConfirmQuit) {
+      screen.put(y, 0, " Discard staged changes and quit? (y/N)", staged);
+    } else if (!message.empty()) {
+      screen.put(y, 0, " " + message,
+                 message.rfind("✗", 0) == 0 ? bad : good);
+    } else if (!visible.empty()) {
+      const Row &row = rows[selected()];
+      if (row.raw != row.expanded)
+        screen.put(y, 0, " " + tail(row.raw, static_cast<size_t>(w - 2)), dim);
     }
+    screen.put(h - 1, 0,
+               " ↑↓ move  / filter  e edit  a add  d delete  J/K reorder  "
+               "w write  R reload  q quit",
+               dim);
+  }
+
+  pathcore::Session &session;
+  std::string var;
+  pathcore::Screen screen;
+  uint16_t plain = 0, title = 0, header = 0, user = 0, system = 0, good = 0,
+           bad = 0, staged = 0, cursorRow = 0, dim = 0, input = 0;
+
+  std::vector<Row> rows; // staged user rows, then system rows
+  size_t userRows = 0;
+  std::vector<std::string> loaded; // user raw entries as last read
+  std::vector<size_t> visible;     // rows matching the filter
+  size_t cursor = 0, top = 0;      // positions in `visible`
+  Mode mode = Mode::Browse;
+  std::string filter, line, message;
+};
+
+class PathManager {
+private:
+  pathcore::Session session;
+  std::string var = "PATH"; // list variable the commands work on (--var)
+
+  const pathcore::PathTable &table() const { return session.table(); }
+
+  // cost and optimize simulate program lookup, which only PATH drives.
+  bool requirePath(const char *command) {
+    if (pathcore::iequals(var, "PATH"))
+      return true;
+    std::cerr << "❌ '" << command << "' only works on PATH, not " << var
+              << ".\n\n";
+    return false;
+  }
+
+public:
+  void setVariable(const std::string &name) { var = name; }
+
+  // Commands that show or compare entries need the whole table...
+  // False, with the store error on stderr, if either scope cannot be read.
+  bool loadPaths() {
+    if (session.load(var))
+      return true;
+    std::cerr << "❌ " << session.lastError() << "\n";
+    return false;
   }
+  // ...while edits of the user value read only that, and only when used.
+  void selectPaths() { session.select(var); }
 
-  std::string getShortenedPath(const std::string &path, size_t maxLength = 60) {
-    if (path.length() <= maxLength)
-      return path;
-    size_t start = path.length() - maxLength + 3;
-    return "..." + path.substr(start);
+  void setNotify(bool enabled) { session.setNotify(enabled); }
+
+  // Blocks until the change broadcast went out (--wait).
+  void waitForNotifications() {
+    if (session.waitForNotifications(std::chrono::seconds(30)))
+      std::cout << Colors::text::bright_black
+                << "📣 Change notification delivered.\n\n" << Colors::reset;
+    else
+      std::cout << Colors::text::yellow
+                << "⚠️  Change notification still pending.\n\n"
+                << Colors::reset;
+  }
+
+  std::string expandEnvironmentStrings(const std::string &str) {
+    return session.expand(str);
+  }
+
+  bool isequals(const std::string &a, const std::string &b) {
+    return pathcore::iequals(a, b);
+  }
+
+  bool directoryExists(const std::string &path) {
+    return session.directoryExists(path);
+  }
+
+  std::string getShortenedPath(std::string_view path, size_t maxLength = 60) {
+    return pathcore::shortenPath(path, maxLength);
   }
 
   static std::string pad(const std::string &s, int width) {
@@ -145,51 +549,25 @@ void printTableHeader() {
               << Colors::reset;
 }
 
-void printSeparator() {
-    std::cout << Colors::text::purple
-              << "├────┼─────┼──────┼──────────────────────────────────────────"
-                 "────────────────────┤\n"
-              << Colors::reset;
-}
-
-void listAllPaths() {
-    loadPaths();
-    printHeader("COMPLETE PATH ANALYSIS");
+// Rows stream out as soon as their probe finishes; probes run in parallel
+// a little ahead of the row being printed, so the first row does not wait
+// for the slowest entry. The summary, which needs them all, is the footer.
+void listAllPaths(size_t offset = 0, size_t limit = SIZE_MAX) {
+    if (!loadPaths())
+      return;
+    printHeader("COMPLETE " + var + " ANALYSIS");
 
-    // Combine & analyze
-    std::vector<std::pair<std::string, std::string>> allPaths;
-    for (auto &p : userPaths)
-      allPaths.emplace_back(p, "USER");
-    for (auto &p : systemPaths)
-      allPaths.emplace_back(p, "SYS ");
-    int valid = 0, invalid = 0, dup = 0;
-    std::set<std::string> seen;
-    for (auto &e : allPaths) {
-      auto low = e.first;
-      std::transform(low.begin(), low.end(), low.begin(), ::tolower);
-      if (seen.count(low))
-        dup++;
-      seen.insert(low);
-      directoryExists(e.first) ? ++valid : ++invalid;
+    const auto &t = table();
+    if (t.empty()) {
+      std::cout << Colors::text::bright_black << "🔍 No " << var << " entries found.\n\n"
+                << Colors::reset;
+      return;
     }
-
-    // Summary
-    std::cout << Colors::text::bright_yellow << "📊 SUMMARY:\n"
-              << Colors::text::white << "   Total entries: " << Colors::text::bright_cyan
-              << allPaths.size() << Colors::text::white
-              << " (User: " << Colors::text::bright_cyan << userPaths.size()
-              << Colors::text::white << ", System: " << Colors::text::bright_cyan
-              << systemPaths.size() << ")\n"
-              << "   " << Colors::text::bright_green << "✅ Valid paths: " << valid
-              << "\n"
-              << "   " << Colors::text::bright_red << "❌ Invalid paths: " << invalid
-              << "\n"
-              << "   " << Colors::text::bright_magenta
-              << "🔄 Potential duplicates: " << dup << "\n\n"
-              << Colors::reset;
-
-    if (allPaths.empty()) {
-      std::cout << Colors::text::bright_black << "🔍 No PATH entries found.\n\n"
+    size_t first = std::min<size_t>(offset, t.size());
+    size_t count = std::min(limit, t.size() - first);
+    if (count == 0) {
+      std::cout << Colors::text::bright_black << "🔍 No entries past #" << first
+                << " (" << t.size() << " in total).\n\n"
                 << Colors::reset;
       return;
     }
@@ -201,35 +579,31 @@ void listAllPaths() {
               << Colors::reset;
     printTableHeader();
 
-    for (size_t i = 0; i < allPaths.size(); ++i) {
-        auto &e = allPaths[i];
-        bool ok = directoryExists(e.first);
-
-        // Build padded fields with proper widths
-        std::string idx = pad(std::to_string(i+1), 3);
-        std::string mark = ok ? "✅" : "❌";
-        std::string type = pad(e.second, 5); // Changed from 4 to 5 to match "Type " header
-        std::string path = pad(getShortenedPath(e.first, 60), 60); // Increased path width
-
-        // Print with colors around padded fields
-        std::cout
-            << Colors::text::purple << "│" << Colors::reset
-            << Colors::text::bright_cyan << idx << Colors::reset
-            << Colors::text::purple << " │ " << Colors::reset
-            << (ok ? Colors::text::bright_green : Colors::text::bright_red) << mark << Colors::reset
-            << Colors::text::purple << " │ " << Colors::reset;
-
-        if (e.second == "USER") {
-            std::cout << Colors::text::teal;
-        } else {
-            std::cout << Colors::text::turquoise;
-        }
-        std::cout << type << Colors::reset
-                  << Colors::text::purple << " │ " << Colors::reset
-                  << Colors::text::white << path << Colors::reset
-                  << Colors::text::purple << " │\n" << Colors::reset;
-
-        if (i+1 < allPaths.size()) printSeparator();
+    pathcore::TraceSpan render(pathcore::Phase::Render);
+    pathcore::OrderedProbes probes(
+        count,
+        [&](size_t k) { return session.exists(static_cast<uint32_t>(first + k)); },
+        std::max(1u, std::thread::hardware_concurrency()));
+    const pathcore::ListStyle style = {
+        sgr(Colors::text::purple),       sgr(Colors::text::bright_cyan),
+        sgr(Colors::text::bright_green), sgr(Colors::text::bright_red),
+        sgr(Colors::text::teal),         sgr(Colors::text::turquoise),
+        sgr(Colors::text::white),        sgr(Colors::reset)};
+    std::string row;
+    int valid = 0, invalid = 0, dup = 0;
+    for (size_t k = 0; k < count; ++k) {
+        uint32_t i = static_cast<uint32_t>(first + k);
+        bool ok = probes.get(k);
+        ok ? ++valid : ++invalid;
+        if (t.flags(i) & pathcore::Duplicate)
+          dup++;
+
+        row.clear();
+        pathcore::appendListRow(row, style, t, i, ok, k + 1 == count);
+        std::cout << row;
+        // Show what is ready while the next probe is still running
+        if (!probes.ready(k + 1))
+          std::cout.flush();
     }
 
     std::cout << Colors::text::purple
@@ -237,84 +611,274 @@ void listAllPaths() {
                  "────────────────────┘\n"
               << Colors::reset;
 
+    // Summary
+    std::cout << "\n"
+              << Colors::text::bright_yellow << "📊 SUMMARY:\n"
+              << Colors::text::white << "   Total entries: " << Colors::text::bright_cyan
+              << t.size() << Colors::text::white
+              << " (User: " << Colors::text::bright_cyan
+              << t.count(pathcore::Scope::User) << Colors::text::white
+              << ", System: " << Colors::text::bright_cyan
+              << t.count(pathcore::Scope::System) << ")\n";
+    if (count < t.size())
+      std::cout << "   Showing: " << Colors::text::bright_cyan << "#" << first + 1
+                << "–#" << first + count << Colors::text::white
+                << " (counts below cover these)\n";
+    std::cout << "   " << Colors::text::bright_green << "✅ Valid paths: " << valid
+              << "\n"
+              << "   " << Colors::text::bright_red << "❌ Invalid paths: " << invalid
+              << "\n"
+              << "   " << Colors::text::bright_magenta
+              << "🔄 Potential duplicates: " << dup << "\n"
+              << Colors::reset;
+
     printLegend();
 }
 
 void printLegend() {
+    bool dirs = session.kind() == pathcore::ListKind::Directories;
     std::cout << "\n"
               << Colors::text::bright_yellow << "📋 LEGEND:\n"
               << Colors::reset << "   " << Colors::text::bright_green << "✅" << Colors::reset
-              << " = Directory exists    " << Colors::text::bright_red << "❌" << Colors::reset
-              << " = Directory missing\n"
+              << (dirs ? " = Directory exists    " : " = Entry valid         ")
+              << Colors::text::bright_red << "❌" << Colors::reset
+              << (dirs ? " = Directory missing\n" : " = Entry invalid\n")
               << "   " << Colors::text::teal << "USER" << Colors::reset
-              << " = User PATH         " << Colors::text::cyan << "SYS" << Colors::reset
-              << " = System PATH\n"
+              << pad(" = User " + var, 21) << Colors::text::cyan << "SYS" << Colors::reset
+              << " = System " << var << "\n"
               << "   ... = Path truncated for display\n\n";
 }
 
 
   void findDuplicates() {
-    loadPaths();
-    printHeader("DUPLICATE PATH ANALYSIS");
+    if (!loadPaths())
+      return;
+    printHeader("DUPLICATE " + var + " ANALYSIS");
+
+    // Group entries that reach the same directory, by spelling or through
+    // a symlink or junction, as indexes into the table. Only keys that
+    // repeat get a group.
+    const auto &t = table();
+    const auto &keys = session.identityKeys();
+    std::unordered_map<uint64_t, std::vector<uint32_t>> groups;
+    std::vector<uint64_t> order;
+    for (uint32_t i = 0; i < t.size(); ++i) {
+      auto &group = groups[keys[i]];
+      group.push_back(i);
+      if (group.size() == 2)
+        order.push_back(keys[i]);
+    }
 
-    std::map<std::string, std::vector<std::pair<std::string, std::string>>>
-        pathMap;
+    bool foundDuplicates = false;
+    for (uint64_t key : order) {
+      foundDuplicates = true;
+      std::cout << "🔄 Duplicate found:\n";
+      for (uint32_t i : groups[key]) {
+        std::cout << "   [" << pathcore::scopeName(t.scope(i)) << "] "
+                  << t.expanded(i) << "\n";
+      }
+      std::cout << "\n";
+    }
 
-    // Group paths by normalized version
-    for (const auto &p : userPaths) {
-      std::string normalized = p;
-      std::transform(normalized.begin(), normalized.end(), normalized.begin(),
-                     ::tolower);
-      pathMap[normalized].push_back({p, "USER"});
+    if (!foundDuplicates) {
+      std::cout << "✅ No duplicates found!\n\n";
     }
+  }
 
-    for (const auto &p : systemPaths) {
-      std::string normalized = p;
-      std::transform(normalized.begin(), normalized.end(), normalized.begin(),
-                     ::tolower);
-      pathMap[normalized].push_back({p, "SYSTEM"});
+  // Drops repeated entries in one pass, keeping the first of each; with
+  // `apply` each changed scope is written once.
+  void dedupePaths(pathcore::DedupePolicy policy, bool apply) {
+    if (!loadPaths())
+      return;
+    printHeader(var + " DEDUPLICATION");
+
+    const auto &t = table();
+    const auto &keys = session.identityKeys();
+    auto drop = pathcore::duplicateEntries(t, keys, policy);
+    if (drop.empty()) {
+      std::cout << "✅ No duplicates found!\n\n";
+      return;
     }
 
-    bool foundDuplicates = false;
-    for (const auto &entry : pathMap) {
-      if (entry.second.size() > 1) {
-        foundDuplicates = true;
-        std::cout << "🔄 Duplicate found:\n";
-        for (const auto &path : entry.second) {
-          std::cout << "   [" << path.second << "] " << path.first << "\n";
+    std::cout << "🔄 " << drop.size() << " duplicate entr"
+              << (drop.size() == 1 ? "y" : "ies") << " to drop:\n";
+    for (uint32_t i : drop)
+      std::cout << "   [" << pathcore::scopeName(t.scope(i)) << "] "
+                << t.expanded(i) << "\n";
+    std::cout << "\n";
+    if (!apply) {
+      std::cout << Colors::text::yellow
+                << "💡 Run 'dedupe --apply' to remove them.\n\n"
+                << Colors::reset;
+      return;
+    }
+
+    auto preferred = policy == pathcore::DedupePolicy::PreferUser
+                         ? pathcore::Scope::User
+                         : pathcore::Scope::System;
+    // Copy what is needed from the table first: a commit rebuilds it.
+    bool dropsIn[2] = {false, false};
+    for (uint32_t i : drop)
+      dropsIn[static_cast<int>(t.scope(i))] = true;
+    size_t removed = 0;
+    for (auto scope : {pathcore::Scope::User, pathcore::Scope::System}) {
+      if (!dropsIn[static_cast<int>(scope)])
+        continue;
+      bool againstPreferred =
+          scope != preferred && policy != pathcore::DedupePolicy::KeepBoth;
+      pathcore::EditOutcome outcome;
+      // The preferred scope's keys are read on every attempt, so a retry
+      // drops against its value as it is then, not as first loaded.
+      pathcore::Edit edit = [&](std::vector<std::string> &entries) {
+        std::unordered_set<uint64_t> preferredKeys;
+        std::string current;
+        if (againstPreferred) {
+          if (!session.readRaw(preferred, var, current))
+            return pathcore::EditResult::Abort;
+          for (const auto &e : pathcore::splitPath(current))
+            preferredKeys.insert(
+                session.identityCache().key(session.expand(e)));
         }
-        std::cout << "\n";
-      }
+        return pathcore::dedupeEntries(session, std::move(preferredKeys),
+                                       outcome)(entries);
+      };
+      if (commitEdit(scope, edit))
+        removed += outcome.removed;
     }
+    if (removed)
+      std::cout << "✅ Removed " << removed << " duplicate " << var
+                << " entries.\n";
+    std::cout << "\n";
+  }
 
-    if (!foundDuplicates) {
-      std::cout << "✅ No duplicates found!\n\n";
+  // Finds directories and tools that are byte-identical copies of each
+  // other, which string and identity dedupe cannot see. Hashes are kept
+  // next to the journal and reused while size and mtime hold.
+  void findSameContent(std::chrono::seconds timeLimit, bool useCache) {
+    if (!requirePath("same-content"))
+      return;
+    if (!loadPaths())
+      return;
+    printHeader("SAME-CONTENT " + var + " ANALYSIS");
+
+    // Each existing directory once, in search order
+    const auto &t = table();
+    const auto &keys = session.identityKeys();
+    std::unordered_set<uint64_t> seen;
+    std::vector<std::string> dirs;
+    for (uint32_t i : pathcore::searchOrder(t))
+      if (session.exists(i) && seen.insert(keys[i]).second)
+        dirs.emplace_back(t.expanded(i));
+
+    std::unique_ptr<pathcore::ContentHashCache> cache;
+    std::string file = cacheFile("content.cache");
+    std::string error;
+    if (useCache && !file.empty()) {
+      cache = std::make_unique<pathcore::ContentHashCache>(file);
+      if (!cache->load(error))
+        std::cerr << "⚠️  " << error << "\n";
     }
+
+    pathcore::ContentScanOptions options;
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    options.timeLimit = timeLimit;
+    options.cache = cache.get();
+    auto start = std::chrono::steady_clock::now();
+    auto report = pathcore::scanContent(dirs, options);
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    if (cache && !cache->save(error))
+      std::cerr << "⚠️  " << error << "\n";
+
+    auto megabytes = [](uint64_t bytes) {
+      std::ostringstream os;
+      os << std::fixed << std::setprecision(1) << bytes / 1048576.0 << " MB";
+      return os.str();
+    };
+    auto where = [&](uint32_t f) {
+      const auto &file = report.files[f];
+      return (std::filesystem::path(report.directories[file.dir]) / file.name)
+          .string();
+    };
+
+    std::cout << Colors::text::bright_yellow << "📊 SUMMARY:\n"
+              << Colors::text::white << "   Directories: " << Colors::text::bright_cyan
+              << dirs.size() << Colors::text::white << ", executables: "
+              << Colors::text::bright_cyan << report.files.size()
+              << Colors::text::white << "\n"
+              << "   Same-size candidates: " << Colors::text::bright_cyan
+              << report.candidates << Colors::text::white << " ("
+              << report.hashed << " read, " << report.cached << " cached, "
+              << report.skipped << " skipped)\n"
+              << "   Read: " << Colors::text::bright_cyan
+              << megabytes(report.bytesRead) << Colors::text::white << " in "
+              << std::fixed << std::setprecision(2) << seconds << " s\n\n"
+              << Colors::reset;
+    if (!report.complete)
+      std::cout << Colors::text::yellow << "⚠️  Stopped at the "
+                << timeLimit.count()
+                << " s limit; run again to continue from the cache.\n\n"
+                << Colors::reset;
+
+    if (report.groups.empty()) {
+      std::cout << "✅ No identical tools in different directories!\n\n";
+      return;
+    }
+
+    for (const auto &same : report.sameDirectories) {
+      std::cout << "📁 Identical directories:\n";
+      for (uint32_t d : same)
+        std::cout << "   " << report.directories[d] << "\n";
+      std::cout << "\n";
+    }
+
+    uint64_t duplicated = 0;
+    for (const auto &g : report.groups)
+      duplicated += report.files[g[0]].size * (g.size() - 1);
+    std::cout << "🔄 " << report.groups.size() << " tool"
+              << (report.groups.size() == 1 ? "" : "s")
+              << " with identical copies (" << megabytes(duplicated)
+              << " duplicated):\n";
+    const size_t shown = 20;
+    for (size_t k = 0; k < report.groups.size() && k < shown; ++k) {
+      const auto &g = report.groups[k];
+      std::cout << "   " << Colors::text::bright_cyan
+                << report.files[g[0]].name << Colors::reset << " ("
+                << megabytes(report.files[g[0]].size) << ", " << g.size()
+                << " copies)\n";
+      for (uint32_t f : g)
+        std::cout << "      " << where(f) << "\n";
+    }
+    if (report.groups.size() > shown)
+      std::cout << Colors::text::bright_black << "   ... and "
+                << report.groups.size() - shown << " more\n"
+                << Colors::reset;
+    std::cout << "\n";
   }
 
   void cleanupInvalidPaths() {
-    loadPaths();
-    printHeader("PATH CLEANUP");
+    if (!loadPaths())
+      return;
+    printHeader(var + " CLEANUP");
 
-    std::vector<std::string> validUserPaths;
-    std::vector<std::string> removedPaths;
+    const auto &t = table();
+    const auto user = pathcore::Scope::User;
+    std::vector<uint32_t> removedPaths;
 
-    for (const auto &path : userPaths) {
-      if (directoryExists(path)) {
-        validUserPaths.push_back(path);
-      } else {
-        removedPaths.push_back(path);
-      }
+    for (uint32_t i = t.begin(user); i < t.end(user); ++i) {
+      if (!session.exists(i))
+        removedPaths.push_back(i);
     }
 
     if (removedPaths.empty()) {
-      std::cout << "✅ All user PATH entries are valid!\n\n";
+      std::cout << "✅ All user " << var << " entries are valid!\n\n";
       return;
     }
 
     std::cout << "❌ Found " << removedPaths.size() << " invalid path(s):\n";
-    for (const auto &path : removedPaths) {
-      std::cout << "   • " << path << "\n";
+    for (uint32_t i : removedPaths) {
+      std::cout << "   • " << t.expanded(i) << "\n";
     }
 
     std::cout << "\nDo you want to remove these invalid paths? (y/N): ";
@@ -322,16 +886,16 @@ void printLegend() {
     std::getline(std::cin, response);
 
     if (response == "y" || response == "Y") {
-      // Build new PATH
-      std::string newPath;
-      for (size_t i = 0; i < validUserPaths.size(); ++i) {
-        if (i > 0)
-          newPath += ";";
-        newPath += validUserPaths[i];
-      }
-
-      if (setUserPath(newPath)) {
-        std::cout << "✅ Successfully cleaned up PATH! Removed "
+      // Drop exactly the entries shown above, even if the value changed
+      // since it was loaded.
+      std::unordered_set<uint64_t> doomed;
+      for (uint32_t i : removedPaths)
+        doomed.insert(t.keyHash(i));
+      pathcore::EditOutcome outcome;
+      auto edit = pathcore::removeKeys(session, std::move(doomed), outcome);
+
+      if (commitUserEdit(edit)) {
+        std::cout << "✅ Successfully cleaned up " << var << "! Removed "
                   << removedPaths.size() << " invalid entries.\n";
       }
     } else {
@@ -341,12 +905,14 @@ void printLegend() {
   }
 
   void exportPath() {
-    loadPaths();
+    if (!loadPaths())
+      return;
 
     auto now = std::chrono::system_clock::now();
     auto time_t = std::chrono::system_clock::to_time_t(now);
 
-    std::string filename = "path_backup_" + std::to_string(time_t) + ".log";
+    std::string filename = pathcore::toLower(var) + "_backup_" +
+                           std::to_string(time_t) + ".log";
     std::ofstream file(filename);
 
     if (!file) {
@@ -354,116 +920,293 @@ void printLegend() {
       return;
     }
 
-    file << "# PATH Backup created at " << std::ctime(&time_t);
-    file << "# User PATH entries:\n";
-    for (const auto &path : userPaths) {
-      file << path << "\n";
+    file << "# " << var << " Backup created at " << std::ctime(&time_t);
+    const auto &t = table();
+    file << "# User " << var << " entries:\n";
+    for (uint32_t i = t.begin(pathcore::Scope::User);
+         i < t.end(pathcore::Scope::User); ++i) {
+      file << t.expanded(i) << "\n";
     }
 
-    file << "\n# System PATH entries:\n";
-    for (const auto &path : systemPaths) {
-      file << path << "\n";
+    file << "\n# System " << var << " entries:\n";
+    for (uint32_t i = t.begin(pathcore::Scope::System);
+         i < t.end(pathcore::Scope::System); ++i) {
+      file << t.expanded(i) << "\n";
     }
 
     file.close();
-    std::cout << "💾 PATH exported to: " << filename << "\n\n";
+    std::cout << "💾 " << var << " exported to: " << filename << "\n\n";
   }
 
-  void searchInPath(const std::string &searchTerm) {
-    loadPaths();
-    printHeader("PATH SEARCH RESULTS");
-
-    std::cout << "🔍 Searching for: \"" << searchTerm << "\"\n\n";
+  // Writes every value of both Environment keys as a .reg file regedit and
+  // `reg import` accept.
+  void exportRegFile(const std::string &filename, pathcore::RegEncoding encoding) {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      std::cerr << "❌ Failed to create " << filename << "\n";
+      return;
+    }
 
-    bool found = false;
-    std::vector<std::pair<std::string, std::string>> matches;
-
-    // Search user paths
-    for (const auto &path : userPaths) {
-      std::string lowerPath = path;
-      std::string lowerTerm = searchTerm;
-      std::transform(lowerPath.begin(), lowerPath.end(), lowerPath.begin(),
-                     ::tolower);
-      std::transform(lowerTerm.begin(), lowerTerm.end(), lowerTerm.begin(),
-                     ::tolower);
-
-      if (lowerPath.find(lowerTerm) != std::string::npos) {
-        matches.push_back({path, "USER"});
-        found = true;
+    pathcore::RegWriter reg(file, encoding);
+    size_t count = 0;
+    for (auto scope : {pathcore::Scope::System, pathcore::Scope::User}) {
+      std::vector<pathcore::NamedValue> values;
+      if (!session.store().readAll(scope, values)) {
+        std::cerr << "❌ " << session.lastError() << "\n";
+        return;
       }
+      reg.key(pathcore::environmentKey(scope));
+      for (const auto &v : values)
+        reg.value(v.name, v.value.data, v.value.kind);
+      count += values.size();
     }
+    file.flush();
+    if (!reg.ok()) {
+      std::cerr << "❌ Failed to write " << filename << "\n";
+      return;
+    }
+    std::cout << "💾 " << count << " environment values exported to: "
+              << filename << "\n\n";
+  }
 
-    // Search system paths
-    for (const auto &path : systemPaths) {
-      std::string lowerPath = path;
-      std::string lowerTerm = searchTerm;
-      std::transform(lowerPath.begin(), lowerPath.end(), lowerPath.begin(),
-                     ::tolower);
-      std::transform(lowerTerm.begin(), lowerTerm.end(), lowerTerm.begin(),
-                     ::tolower);
+  // Pulls the Environment keys out of a .reg file, which may be a whole
+  // hive export, and shows the variable as it would be imported. With
+  // `apply` the variable is written to both scopes; with `all` every value
+  // found is.
+  void importRegFile(const std::string &filename, const std::string &sid,
+                     bool apply, bool all) {
+    printHeader(".REG IMPORT");
+
+    pathcore::RegEnvironment env;
+    std::string error;
+    if (!pathcore::importEnvironment(filename, sid, env, error)) {
+      std::cerr << "❌ " << error << "\n\n";
+      return;
+    }
+
+    const pathcore::StoreValue *found[2] = {nullptr, nullptr};
+    for (auto scope : {pathcore::Scope::User, pathcore::Scope::System}) {
+      const auto &values = env.values[static_cast<int>(scope)];
+      for (const auto &v : values)
+        if (pathcore::iequals(v.name, var))
+          found[static_cast<int>(scope)] = &v.value;
+
+      std::cout << Colors::text::bright_yellow << "📥 "
+                << (scope == pathcore::Scope::User ? "User" : "System")
+                << " environment: " << Colors::reset << values.size()
+                << " value" << (values.size() == 1 ? "" : "s");
+      if (scope == pathcore::Scope::User && !env.userKey.empty())
+        std::cout << Colors::text::bright_black << "  (" << env.userKey << ")"
+                  << Colors::reset;
+      std::cout << "\n";
 
-      if (lowerPath.find(lowerTerm) != std::string::npos) {
-        matches.push_back({path, "SYSTEM"});
-        found = true;
+      const auto *value = found[static_cast<int>(scope)];
+      if (!value) {
+        std::cout << "   " << Colors::text::bright_black << "No " << var
+                  << " value.\n" << Colors::reset;
+        continue;
       }
+      auto entries = pathcore::splitPath(value->data);
+      for (size_t k = 0; k < entries.size(); ++k)
+        std::cout << "   " << Colors::text::bright_cyan << std::setw(3)
+                  << std::right << k + 1 << Colors::reset << " "
+                  << getShortenedPath(entries[k], 70) << "\n";
+    }
+    std::cout << "\n";
+    if (!env.otherUsers.empty()) {
+      std::cout << Colors::text::yellow << "👥 Also found "
+                << env.otherUsers.size() << " other user key"
+                << (env.otherUsers.size() == 1 ? "" : "s")
+                << "; pick one with --sid:\n" << Colors::reset;
+      for (const auto &s : env.otherUsers)
+        std::cout << "   • " << s << "\n";
+      std::cout << "\n";
+    }
+    if (env.skipped)
+      std::cout << Colors::text::bright_black << "   " << env.skipped
+                << " deleted or non-string values skipped.\n\n"
+                << Colors::reset;
+
+    if (!apply) {
+      std::cout << Colors::text::yellow
+                << "💡 Run again with --apply to write " << var
+                << (all ? " and every other value" : "") << " to the store.\n\n"
+                << Colors::reset;
+      return;
     }
 
-    if (found) {
-      for (const auto &match : matches) {
-        bool exists = directoryExists(match.first);
-        std::cout << "[" << match.second << "] " << (exists ? "✅" : "❌")
-                  << " " << match.first << "\n";
+    // Everything is journaled and can be undone. With --all each scope is
+    // one batch under one store lock; the notifications of the two
+    // batches coalesce into one broadcast.
+    selectPaths();
+    size_t written = 0;
+    for (auto scope : {pathcore::Scope::User, pathcore::Scope::System}) {
+      const auto &values = env.values[static_cast<int>(scope)];
+      if (all) {
+        auto result = session.updateValues(scope, values);
+        if (result.status != pathcore::CommitStatus::Unchanged &&
+            !reportCommit(result))
+          return;
+        written += values.size();
+        continue;
       }
-    } else {
+      if (const auto *value = found[static_cast<int>(scope)]) {
+        auto imported = pathcore::splitPath(value->data);
+        auto edit = [&](std::vector<std::string> &entries) {
+          if (entries == imported)
+            return pathcore::EditResult::Unchanged;
+          entries = imported;
+          return pathcore::EditResult::Changed;
+        };
+        if (commitEdit(scope, edit))
+          written++;
+      }
+    }
+    std::cout << "✅ Imported " << written << " value"
+              << (written == 1 ? "" : "s") << " from " << filename << ".\n\n";
+  }
+
+  void searchInPath(const std::string &searchTerm) {
+    if (!loadPaths())
+      return;
+    printHeader(var + " SEARCH RESULTS");
+
+    std::cout << "🔍 Searching for: \"" << searchTerm << "\"\n\n";
+
+    const auto &t = table();
+    pathcore::TraceSpan render(pathcore::Phase::Render);
+    auto hits = pathcore::searchEntries(t, searchTerm);
+    for (uint32_t i : hits) {
+      bool exists = session.exists(i);
+      std::cout << "[" << pathcore::scopeName(t.scope(i)) << "] "
+                << (exists ? "✅" : "❌") << " " << t.expanded(i) << "\n";
+    }
+
+    if (hits.empty()) {
       std::cout << "❌ No matches found.\n";
     }
     std::cout << "\n";
   }
 
-  bool setUserPath(const std::string &newPath) {
-    HKEY hKey;
-    LONG res = RegOpenKeyExA(HKEY_CURRENT_USER, "Environment", 0, KEY_SET_VALUE,
-                             &hKey);
-    if (res != ERROR_SUCCESS) {
-      std::cerr << "❌ Failed to open registry key (code " << res << ")\n";
-      return false;
+  // Applies `edit` to the user variable with compare-and-swap, retrying on
+  // concurrent writes. Explains on stderr when nothing was written.
+  bool commitUserEdit(const pathcore::Edit &edit) {
+    return commitEdit(pathcore::Scope::User, edit);
+  }
+
+  // Cache files live next to the journal; empty if the store keeps none.
+  std::string cacheFile(const char *name) {
+    std::string journal = session.store().journalPath();
+    if (journal.empty())
+      return "";
+    return (std::filesystem::path(journal).parent_path() / name).string();
+  }
+
+  // Lists the commands that would run a different file, or none at all,
+  // once `edit` is applied to `scope`. Says nothing if the edit changes
+  // nothing or the variable is not PATH.
+  void printImpact(pathcore::Scope scope, const pathcore::Edit &edit) {
+    if (!pathcore::iequals(var, "PATH"))
+      return;
+    pathcore::NameIndex index(cacheFile("names.cache"));
+    std::string error;
+    index.load(error);
+    pathcore::EditResult result;
+    auto impact = pathcore::previewImpact(session, scope, edit, index, result);
+    index.save(error);
+    if (result != pathcore::EditResult::Changed)
+      return;
+    if (impact.empty()) {
+      std::cout << Colors::text::bright_black
+                << "🔀 No command resolves differently.\n\n" << Colors::reset;
+      return;
     }
 
-    res = RegSetValueExA(hKey, "Path", 0, REG_EXPAND_SZ,
-                         reinterpret_cast<const BYTE *>(newPath.c_str()),
-                         static_cast<DWORD>(newPath.size() + 1));
-    RegCloseKey(hKey);
+    size_t affected =
+        impact.changed.size() + impact.gained.size() + impact.lost.size();
+    std::cout << Colors::text::bright_yellow << "🔀 " << affected << " command"
+              << (affected == 1 ? "" : "s") << " would resolve differently:\n"
+              << Colors::reset;
+    for (const auto &c : impact.changed)
+      std::cout << "   " << Colors::text::yellow << "~ " << pad(c.name, 16)
+                << Colors::reset << c.before << " → " << c.after << "\n";
+    for (const auto &c : impact.lost)
+      std::cout << "   " << Colors::text::bright_red << "- " << pad(c.name, 16)
+                << Colors::reset << c.before << " (no longer found)\n";
+    const size_t shown = 10;
+    for (size_t k = 0; k < impact.gained.size() && k < shown; ++k)
+      std::cout << "   " << Colors::text::bright_green << "+ "
+                << pad(impact.gained[k].name, 16) << Colors::reset << "→ "
+                << impact.gained[k].after << "\n";
+    if (impact.gained.size() > shown)
+      std::cout << Colors::text::bright_black << "   ... and "
+                << impact.gained.size() - shown << " more new commands\n"
+                << Colors::reset;
+    std::cout << "\n";
+  }
 
-    if (res != ERROR_SUCCESS) {
-      std::cerr << "❌ Failed to set registry value (code " << res << ")\n";
+  bool commitEdit(pathcore::Scope scope, const pathcore::Edit &edit) {
+    return reportCommit(session.update(scope, edit));
+  }
+
+  // Explains on stderr why a commit wrote nothing; true if it wrote.
+  bool reportCommit(const pathcore::CommitResult &result) {
+    switch (result.status) {
+    case pathcore::CommitStatus::Committed:
+      return true;
+    case pathcore::CommitStatus::Conflict:
+      std::cerr << "❌ " << var << " kept changing during the update; gave up after "
+                << result.attempts << " attempts.\n";
+      return false;
+    case pathcore::CommitStatus::Failed:
+      std::cerr << "❌ " << session.lastError() << "\n";
+      return false;
+    case pathcore::CommitStatus::Aborted:
+      std::cerr << "❌ " << var
+                << " changed since it was read; nothing was written.\n";
+      return false;
+    default:
       return false;
     }
-
-    // Broadcast the change
-    SendMessageTimeoutA(HWND_BROADCAST, WM_SETTINGCHANGE, 0,
-                        reinterpret_cast<LPARAM>("Environment"),
-                        SMTO_ABORTIFHUNG, 5000, nullptr);
-    return true;
   }
 
   void addToUserPath(const std::string &newDir) {
-    loadPaths();
+    selectPaths();
 
+    const pathcore::StoreValue *user = session.value(pathcore::Scope::User);
+    if (!user) {
+      std::cerr << "❌ " << session.lastError() << "\n";
+      return;
+    }
     // Check if already exists
-    for (const auto &p : userPaths) {
-      if (isequals(p, newDir)) {
+    auto entries = pathcore::splitPath(user->data);
+    for (const auto &e : entries) {
+      if (isequals(expandEnvironmentStrings(e), newDir)) {
         std::cout << Colors::text::teal << "✅ \"" << newDir
-                  << "\" is already in your user PATH.\n\n"
+                  << "\" is already in your user " << var << ".\n\n"
                   << Colors::reset;
         return;
       }
     }
 
-    // Check if directory exists
-    if (!directoryExists(newDir)) {
-      std::cout << Colors::text::yellow << "⚠️  WARNING: Directory \"" << newDir
-                << "\" does not exist.\n"
-                << Colors::reset;
+    // Check the length budget before asking anything else
+    pathcore::LengthBudget budget;
+    budget.reset(entries);
+    if (!budget.fits(newDir)) {
+      printOverBudget(budget.lengthWith(newDir), budget.limit(), newDir);
+      return;
+    }
+
+    // Check the entry is valid for this kind of list
+    if (!session.valid(expandEnvironmentStrings(newDir))) {
+      std::cout << Colors::text::yellow;
+      if (session.kind() == pathcore::ListKind::Directories)
+        std::cout << "⚠️  WARNING: Directory \"" << newDir
+                  << "\" does not exist.\n";
+      else
+        std::cout << "⚠️  WARNING: \"" << newDir << "\" is not a valid " << var
+                  << " entry.\n";
+      std::cout << Colors::reset;
       std::cout << "Do you want to add it anyway? (y/N): ";
       std::string response;
       std::getline(std::cin, response);
@@ -474,75 +1217,835 @@ void printLegend() {
       }
     }
 
-    // Build new path
-    std::string oldPath = getEnvironmentVariable("PATH", HKEY_CURRENT_USER);
-    std::string newPath = oldPath;
-    if (!newPath.empty() && newPath.back() != ';')
-      newPath += ';';
-    newPath += newDir;
+    // Append, unless another writer added it in the meantime
+    pathcore::EditOutcome outcome;
+    auto edit = pathcore::addEntry(session, newDir, budget.limit(), outcome);
+    printImpact(pathcore::Scope::User, edit);
 
-    if (setUserPath(newPath)) {
+    if (commitUserEdit(edit)) {
       std::cout << Colors::text::teal << "✅ Successfully added \"" << newDir
-                << "\" to your user PATH.\n"
+                << "\" to your user " << var << ".\n"
                 << Colors::reset;
       std::cout << Colors::text::yellow
                 << "🔄 Note: You may need to restart applications for the "
                    "change to take effect.\n\n"
                 << Colors::reset;
+    } else if (outcome.present) {
+      std::cout << Colors::text::teal << "✅ \"" << newDir
+                << "\" is already in your user " << var << ".\n\n"
+                << Colors::reset;
+    } else if (outcome.overBudget) {
+      printOverBudget(outcome.length, budget.limit(), newDir);
     }
   }
 
+  void printOverBudget(size_t length, size_t limit, const std::string &newDir) {
+    std::cout << Colors::text::red << "❌ Adding \"" << newDir
+              << "\" would make the user " << var << " " << length
+              << " characters long, over the budget of " << limit
+              << ".\n"
+              << Colors::reset << Colors::text::yellow
+              << "💡 Try 'compact' or 'clean' first, or raise PATHMGR_PATH_BUDGET.\n\n"
+              << Colors::reset;
+  }
+
+  void compactUserPath() {
+    if (!loadPaths())
+      return;
+    printHeader(var + " COMPACTION");
+    if (session.kind() == pathcore::ListKind::Extensions) {
+      std::cout << "✅ " << var << " holds no paths to compact.\n\n";
+      return;
+    }
+
+    pathcore::VariableTrie trie;
+    for (const auto &name : pathcore::prefixVariables()) {
+      std::string value = expandEnvironmentStrings("%" + name + "%");
+      if (value.find('%') == std::string::npos)
+        trie.insert(name, value);
+    }
+
+    const auto &t = table();
+    const auto user = pathcore::Scope::User;
+    pathcore::LengthBudget budget;
+    budget.reset(t.valueLength(user), t.count(user));
+    size_t before = budget.length();
+
+    // raw entry -> shorter spelling that expands to the same directory
+    std::unordered_map<std::string, std::string> rewrites;
+    for (uint32_t i = t.begin(user); i < t.end(user); ++i) {
+      std::string raw(t.raw(i));
+      auto known = rewrites.find(raw);
+      if (known != rewrites.end()) {
+        budget.replace(raw, known->second); // a repeat of a rewritten entry
+        continue;
+      }
+      // Entries that already use a variable keep one
+      std::string shorter = trie.shorten(t.expanded(i));
+      if (shorter.size() >= raw.size() ||
+          (raw.find('%') != std::string::npos &&
+           shorter.find('%') == std::string::npos) ||
+          pathcore::canonicalKey(expandEnvironmentStrings(shorter)) !=
+              pathcore::canonicalKey(t.expanded(i)))
+        continue;
+      budget.replace(raw, shorter);
+      std::cout << "   • " << Colors::text::bright_black << raw << Colors::reset
+                << "\n     → " << Colors::text::bright_green << shorter
+                << Colors::reset << Colors::text::bright_black << "  (-"
+                << raw.size() - shorter.size() << ")\n"
+                << Colors::reset;
+      rewrites.emplace(std::move(raw), std::move(shorter));
+    }
+
+    size_t after = budget.length();
+    std::cout << (rewrites.empty() ? "" : "\n") << Colors::text::bright_yellow
+              << "📊 SUMMARY:\n"
+              << Colors::text::white << "   Variables available: "
+              << Colors::text::bright_cyan << trie.variables() << "\n"
+              << Colors::text::white << "   User " << var << " length: "
+              << Colors::text::bright_cyan << before << " → " << after
+              << Colors::text::white << " characters (budget " << budget.limit()
+              << ")\n"
+              << "   Saved: " << Colors::text::bright_green << before - after
+              << " characters, " << 2 * (before - after)
+              << " bytes as stored\n\n"
+              << Colors::reset;
+
+    if (rewrites.empty()) {
+      std::cout << "✅ Nothing to compact!\n\n";
+      return;
+    }
+
+    std::cout << "Rewrite these entries? (y/N): ";
+    std::string response;
+    std::getline(std::cin, response);
+    if (response != "y" && response != "Y") {
+      std::cout << "❌ Compaction cancelled.\n\n";
+      return;
+    }
+
+    auto edit = [&](std::vector<std::string> &entries) {
+      bool changed = false;
+      for (auto &e : entries) {
+        auto it = rewrites.find(e);
+        if (it != rewrites.end()) {
+          e = it->second;
+          changed = true;
+        }
+      }
+      return changed ? pathcore::EditResult::Changed
+                     : pathcore::EditResult::Unchanged;
+    };
+
+    if (commitUserEdit(edit))
+      std::cout << "✅ User " << var << " compacted; saved as REG_EXPAND_SZ.\n";
+    std::cout << "\n";
+  }
+
   void removeFromUserPath(const std::string &targetDir) {
-    loadPaths();
+    selectPaths();
 
-    std::string expanded = expandEnvironmentStrings(targetDir);
+    pathcore::EditOutcome outcome;
+    auto edit = pathcore::removeEntry(session, targetDir, outcome);
+    printImpact(pathcore::Scope::User, edit);
+    bool committed = commitUserEdit(edit);
 
-    namespace fs = std::filesystem;
+    if (!outcome.removed) {
+      std::cout << "❌ \"" << targetDir << Colors::text::red
+                << "\" not found in user " << var << ".\n\n"
+                << Colors::reset;
+      return;
+    }
 
-    std::error_code ec;
-    fs::path tpath = fs::absolute(fs::path(expanded));
-    fs::path tcanon = fs::weakly_canonical(tpath, ec);
-    std::string normTarget = ec.value() ? tpath.string() : tcanon.string();
+    if (committed) {
+      std::cout << "✅ Successfully removed \"" << targetDir
+                << "\" from user " << var << ".\n\n";
+    }
+  }
 
-    bool found = false;
-    std::vector<std::string> newPaths;
+  // remove/keep/move --match: previews what `action` does to the user
+  // entries `matcher` selects, and with `apply` commits it in one write.
+  void selectUserEntries(const pathcore::EntryMatcher &matcher,
+                         pathcore::Selection action, bool apply) {
+    if (!loadPaths())
+      return;
+    using pathcore::Selection;
+    static const char *const titles[] = {"REMOVE", "KEEP", "MOVE", "MOVE"};
+    printHeader(var + " PATTERN " + titles[static_cast<int>(action)]);
+
+    const auto &t = table();
+    const auto user = pathcore::Scope::User;
+    std::vector<uint32_t> selected, rest;
+    for (uint32_t i = t.begin(user); i < t.end(user); ++i)
+      (matcher.matches(t.raw(i), t.expanded(i)) ? selected : rest).push_back(i);
+
+    std::cout << "🎯 " << selected.size() << " of " << t.count(user)
+              << " user entries match.\n\n";
+    if (selected.empty())
+      return;
 
-    for (const auto &p : userPaths) {
+    if (action == Selection::Remove || action == Selection::Keep) {
+      const auto &drop = action == Selection::Remove ? selected : rest;
+      if (drop.empty()) {
+        std::cout << "✅ Every user entry matches; nothing to drop.\n\n";
+        return;
+      }
+      std::cout << "🗑️  Dropping " << drop.size() << " entr"
+                << (drop.size() == 1 ? "y" : "ies") << ":\n";
+      for (uint32_t i : drop)
+        std::cout << "   • " << t.raw(i) << "\n";
+      std::cout << "\n";
+    } else {
+      std::vector<uint32_t> order = action == Selection::MoveFront ? selected : rest;
+      const auto &tail = action == Selection::MoveFront ? rest : selected;
+      order.insert(order.end(), tail.begin(), tail.end());
+      bool changed = false;
+      for (size_t k = 0; k < order.size(); ++k)
+        changed |= order[k] - t.begin(user) != k;
+      if (!changed) {
+        std::cout << "✅ The matching entries are already "
+                  << (action == Selection::MoveFront ? "first" : "last")
+                  << ".\n\n";
+        return;
+      }
+      std::cout << "📋 New user " << var << " order:\n";
+      for (size_t k = 0; k < order.size(); ++k) {
+        uint32_t i = order[k];
+        bool moved = i - t.begin(user) != k;
+        std::cout << "   " << Colors::text::bright_cyan << std::setw(3) << std::right
+                  << k + 1 << Colors::reset << " "
+                  << (moved ? Colors::text::bright_yellow : Colors::text::white)
+                  << getShortenedPath(t.raw(i), 70) << Colors::reset << "\n";
+      }
+      std::cout << "\n";
+    }
+
+    pathcore::EditOutcome outcome;
+    auto edit = pathcore::selectEntries(session, matcher, action, outcome);
+    printImpact(user, edit);
+    if (!apply) {
+      std::cout << Colors::text::yellow
+                << "💡 Run again with --apply to write this change.\n\n"
+                << Colors::reset;
+      return;
+    }
 
-      fs::path up = fs::absolute(fs::path(expandEnvironmentStrings(p)));
-      fs::path ucanon = fs::weakly_canonical(up, ec);
-      std::string normStored = ec.value() ? up.string() : ucanon.string();
+    if (commitUserEdit(edit)) {
+      if (outcome.removed)
+        std::cout << "✅ Removed " << outcome.removed << " user " << var
+                  << " entries.\n";
+      else
+        std::cout << "✅ Moved " << outcome.matched << " user " << var
+                  << " entries to the "
+                  << (action == Selection::MoveFront ? "front" : "back") << ".\n";
+    }
+    std::cout << "\n";
+  }
 
-      if (std::equal(normStored.begin(), normStored.end(), normTarget.begin(),
-                     normTarget.end(),
-                     [](char a, char b) { return tolower(a) == tolower(b); })) {
-        found = true;
-      } else {
-        newPaths.push_back(p);
+  void showLookupCost(const std::string &workloadFile) {
+    if (!requirePath("cost"))
+      return;
+    if (!loadPaths())
+      return;
+    printHeader("PATH LOOKUP COST");
+
+    pathcore::Workload workload;
+    std::string error;
+    if (workloadFile.empty()) {
+      workload = pathcore::defaultWorkload();
+    } else if (!pathcore::loadWorkload(workloadFile, workload, error)) {
+      std::cerr << "❌ " << error << "\n\n";
+      return;
+    }
+
+    const auto &t = table();
+    auto order = pathcore::searchOrder(t);
+    pathcore::LookupProfiler profiler(t, pathcore::lookupExtensions(),
+                                      &session.identityKeys());
+    profiler.measure();
+    auto report = profiler.profile(workload, order);
+
+    size_t unresolved = 0;
+    for (const auto &l : report.lookups)
+      if (l.resolvedAt < 0)
+        unresolved++;
+
+    std::cout << Colors::text::bright_yellow << "📊 SUMMARY:\n"
+              << Colors::text::white << "   Workload: " << Colors::text::bright_cyan
+              << workload.names.size() << Colors::text::white << " commands, "
+              << Colors::text::bright_cyan << report.launches << Colors::text::white
+              << " launches"
+              << (workloadFile.empty() ? " (built-in sample)" : "") << "\n"
+              << "   Extensions tried: " << Colors::text::bright_cyan
+              << std::max<size_t>(profiler.extensions().size(), 1)
+              << Colors::text::white << " per directory\n"
+              << "   Probes per launch: " << Colors::text::bright_cyan
+              << std::fixed << std::setprecision(1) << report.probesPerLaunch
+              << Colors::text::white << "\n"
+              << "   Search time per launch: " << Colors::text::bright_cyan
+              << report.microsPerLaunch << " µs" << Colors::text::white << "\n"
+              << "   " << Colors::text::bright_red << "❓ Not found on PATH: "
+              << unresolved << "\n\n"
+              << Colors::reset;
+
+    if (t.empty() || report.launches <= 0) {
+      std::cout << Colors::text::bright_black << "🔍 Nothing to profile.\n\n"
+                << Colors::reset;
+      return;
+    }
+
+    // Entries in the order a launch searches them
+    std::cout << Colors::text::bright_yellow << "🔎 PER ENTRY (search order):\n"
+              << Colors::reset << Colors::bold << "   "
+              << std::right << std::setw(4) << "#" << "  " << std::left
+              << std::setw(5) << "Type" << std::right << std::setw(10)
+              << "miss/run" << std::setw(10) << "µs/probe" << std::setw(10)
+              << "µs/run" << std::setw(7) << "cum%" << "  Path\n"
+              << Colors::reset;
+
+    double cumulative = 0;
+    for (const auto &e : report.entries) {
+      cumulative += e.micros;
+      double missPerRun = e.missProbes / report.launches;
+      double perRun = e.micros / report.launches;
+      double share = report.microsPerLaunch > 0
+                         ? 100.0 * cumulative / report.launches /
+                               report.microsPerLaunch
+                         : 0;
+      bool user = t.scope(e.entry) == pathcore::Scope::User;
+      std::cout << "   " << Colors::text::bright_cyan << std::right
+                << std::setw(4) << e.entry + 1 << Colors::reset << "  ";
+      if (user)
+        std::cout << Colors::text::teal;
+      else
+        std::cout << Colors::text::turquoise;
+      std::cout << std::left << std::setw(5) << (user ? "USER" : "SYS")
+                << Colors::reset << std::right << std::setprecision(1)
+                << std::setw(10) << missPerRun << std::setprecision(2)
+                << std::setw(10) << e.probeMicros << std::setprecision(1)
+                << std::setw(10) << perRun << std::setw(6) << share << "%"
+                << "  ";
+      if (!session.exists(e.entry))
+        std::cout << Colors::text::bright_red;
+      else if (t.flags(e.entry) & pathcore::Duplicate)
+        std::cout << Colors::text::bright_magenta;
+      else
+        std::cout << Colors::text::white;
+      std::cout << getShortenedPath(t.expanded(e.entry), 40) << Colors::reset
+                << "\n";
+    }
+
+    // Most expensive commands, by total time over the workload
+    std::vector<size_t> byCost(workload.names.size());
+    for (size_t w = 0; w < byCost.size(); ++w)
+      byCost[w] = w;
+    std::sort(byCost.begin(), byCost.end(), [&](size_t a, size_t b) {
+      return report.lookups[a].micros * workload.counts[a] >
+             report.lookups[b].micros * workload.counts[b];
+    });
+    if (byCost.size() > 10)
+      byCost.resize(10);
+
+    std::cout << "\n" << Colors::text::bright_yellow
+              << "💸 MOST EXPENSIVE LOOKUPS:\n" << Colors::reset;
+    for (size_t w : byCost) {
+      const auto &l = report.lookups[w];
+      std::cout << "   " << Colors::text::bright_green << std::left
+                << std::setw(20) << workload.names[w] << Colors::reset
+                << std::right << std::setw(6) << l.probes << " probes "
+                << std::setprecision(1) << std::setw(10) << l.micros << " µs  ";
+      if (l.resolvedAt >= 0)
+        std::cout << Colors::text::bright_black << "→ "
+                  << getShortenedPath(t.expanded(
+                                          static_cast<uint32_t>(l.resolvedAt)),
+                                      40)
+                  << Colors::reset << "\n";
+      else
+        std::cout << Colors::text::bright_red << "not found" << Colors::reset
+                  << "\n";
+    }
+    std::cout << std::defaultfloat << std::setprecision(6) << "\n";
+  }
+
+  void optimizeUserPath(const std::string &workloadFile, bool allowChanges) {
+    if (!requirePath("optimize"))
+      return;
+    if (!loadPaths())
+      return;
+    printHeader("PATH OPTIMIZATION");
+
+    pathcore::Workload workload;
+    std::string error;
+    if (workloadFile.empty()) {
+      workload = pathcore::defaultWorkload();
+    } else if (!pathcore::loadWorkload(workloadFile, workload, error)) {
+      std::cerr << "❌ " << error << "\n\n";
+      return;
+    }
+
+    const auto &t = table();
+    pathcore::LookupProfiler profiler(t, pathcore::lookupExtensions(),
+                                      &session.identityKeys());
+    profiler.measure();
+    auto plan = pathcore::planReorder(t, profiler, workload, allowChanges);
+
+    if (plan.unchanged(t)) {
+      std::cout << "✅ User PATH is already in the best order for this workload!\n\n";
+      return;
+    }
+
+    auto saving = [](double before, double after) {
+      return before > 0 ? 100.0 * (before - after) / before : 0.0;
+    };
+    std::cout << Colors::text::bright_yellow << "📊 PREDICTED SAVING:\n"
+              << Colors::text::white << std::fixed << std::setprecision(1)
+              << "   Probes per launch: " << Colors::text::bright_cyan
+              << plan.before.probesPerLaunch << " → "
+              << plan.after.probesPerLaunch << Colors::text::bright_green << "  (-"
+              << saving(plan.before.probesPerLaunch, plan.after.probesPerLaunch)
+              << "%)\n"
+              << Colors::text::white << "   Search time per launch: "
+              << Colors::text::bright_cyan << plan.before.microsPerLaunch << " µs → "
+              << plan.after.microsPerLaunch << " µs" << Colors::text::bright_green
+              << "  (-"
+              << saving(plan.before.microsPerLaunch, plan.after.microsPerLaunch)
+              << "%)\n\n"
+              << Colors::reset << std::defaultfloat << std::setprecision(6);
+
+    if (!plan.dropped.empty()) {
+      std::cout << "🗑️  Dropping " << plan.dropped.size() << " entr"
+                << (plan.dropped.size() == 1 ? "y" : "ies") << ":\n";
+      for (const auto &[i, why] : plan.dropped)
+        std::cout << "   • " << t.raw(i) << Colors::text::bright_black
+                  << (why == pathcore::ReorderPlan::Drop::Empty
+                          ? "  (no files)"
+                          : "  (already searched earlier)")
+                  << Colors::reset << "\n";
+      std::cout << "\n";
+    }
+
+    std::cout << "📋 New user PATH order:\n";
+    for (size_t k = 0; k < plan.order.size(); ++k) {
+      uint32_t i = plan.order[k];
+      bool moved = i - t.begin(pathcore::Scope::User) != k;
+      std::cout << "   " << Colors::text::bright_cyan << std::setw(3) << std::right
+                << k + 1 << Colors::reset << " "
+                << (moved ? Colors::text::bright_yellow : Colors::text::white)
+                << getShortenedPath(t.raw(i), 70) << Colors::reset << "\n";
+    }
+    std::cout << "\n";
+
+    if (!plan.changed.empty()) {
+      std::cout << Colors::text::yellow << "⚠️  These commands would resolve elsewhere:\n"
+                << Colors::reset;
+      for (size_t w : plan.changed)
+        std::cout << "   • " << workload.names[w] << "\n";
+      std::cout << "\n";
+    }
+
+    std::cout << "Apply this order? (y/N): ";
+    std::string response;
+    std::getline(std::cin, response);
+    if (response != "y" && response != "Y") {
+      std::cout << "❌ Optimization cancelled.\n\n";
+      return;
+    }
+
+    // The plan only holds for the list it was computed from.
+    std::vector<std::string> loaded, proposed;
+    for (uint32_t i = t.begin(pathcore::Scope::User);
+         i < t.end(pathcore::Scope::User); ++i)
+      loaded.emplace_back(t.raw(i));
+    for (uint32_t i : plan.order)
+      proposed.emplace_back(t.raw(i));
+    auto edit = [&](std::vector<std::string> &entries) {
+      if (entries != loaded)
+        return pathcore::EditResult::Abort;
+      entries = proposed;
+      return pathcore::EditResult::Changed;
+    };
+
+    if (commitUserEdit(edit))
+      std::cout << "✅ User PATH optimized.\n";
+    std::cout << "\n";
+  }
+
+  // Violations go to stdout as JSON lines, the summary to stderr. Returns
+  // the exit code: 1 if any error-level rule was broken.
+  int lintPaths(const std::string &rulesFile,
+                const std::vector<std::string> &snapshots) {
+    pathcore::RuleSet rules;
+    std::string error;
+    if (!rules.load(rulesFile, error)) {
+      std::cerr << "❌ " << error << "\n";
+      return 2;
+    }
+
+    std::vector<std::vector<pathcore::Violation>> results;
+    if (snapshots.empty()) {
+      if (!loadPaths())
+        return 2;
+      results.push_back(rules.check(table(), "live", [&](uint32_t i) {
+        return session.exists(i);
+      }));
+    } else {
+      results = pathcore::lintFiles(rules, snapshots,
+                                    std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    size_t errors = 0, warnings = 0;
+    for (const auto &list : results) {
+      for (const auto &v : list) {
+        std::cout << v.toJson() << "\n";
+        (v.severity == pathcore::Severity::Error ? errors : warnings)++;
       }
     }
+    std::cout.flush();
+    std::cerr << (errors ? "❌ " : "✅ ") << results.size()
+              << (results.size() == 1 ? " snapshot, " : " snapshots, ")
+              << rules.size() << " rules: " << errors << " errors, " << warnings
+              << " warnings\n";
+    return errors ? 1 : 0;
+  }
 
-    if (!found) {
-      std::cout << "❌ \"" << targetDir << Colors::text::red
-                << "\" not found in user PATH.\n\n"
+  void auditAllLists() {
+    printHeader("LIST VARIABLE AUDIT");
+
+    auto audits =
+        session.auditLists(std::max(1u, std::thread::hardware_concurrency()));
+    if (audits.empty()) {
+      std::cout << "🔍 No list variables found.\n\n";
+      return;
+    }
+
+    const auto user = pathcore::Scope::User, system = pathcore::Scope::System;
+    size_t budget = pathcore::LengthBudget::configured();
+    std::cout << Colors::bold << pad("Variable", 22) << pad("User", 7)
+              << pad("System", 8) << pad("Invalid", 9) << pad("Dups", 6)
+              << "Length (user/system)" << Colors::reset << "\n";
+    size_t problems = 0;
+    for (const auto &a : audits) {
+      const auto &t = a.table;
+      size_t userLen = t.valueLength(user), systemLen = t.valueLength(system);
+      bool over = userLen > budget || systemLen > budget;
+      problems += a.invalid.size() + a.duplicates + (over ? 1 : 0);
+      std::cout << Colors::text::bright_cyan << pad(a.name, 22) << Colors::reset
+                << pad(std::to_string(t.count(user)), 7)
+                << pad(std::to_string(t.count(system)), 8);
+      if (a.invalid.empty())
+        std::cout << Colors::text::bright_green;
+      else
+        std::cout << Colors::text::bright_red;
+      std::cout << pad(std::to_string(a.invalid.size()), 9) << Colors::reset;
+      if (a.duplicates == 0)
+        std::cout << Colors::text::bright_green;
+      else
+        std::cout << Colors::text::bright_magenta;
+      std::cout << pad(std::to_string(a.duplicates), 6) << Colors::reset;
+      if (over)
+        std::cout << Colors::text::bright_red;
+      std::cout << userLen << "/" << systemLen << Colors::reset << "\n";
+    }
+    std::cout << "\n";
+
+    for (const auto &a : audits) {
+      if (a.invalid.empty() && a.duplicates == 0)
+        continue;
+      std::cout << Colors::text::bright_yellow << "📋 " << a.name << ":\n"
+                << Colors::reset;
+      const auto &t = a.table;
+      for (uint32_t i : a.invalid)
+        std::cout << "   " << Colors::text::bright_red << "❌" << Colors::reset
+                  << " [" << pathcore::scopeName(t.scope(i)) << "] "
+                  << t.expanded(i) << "\n";
+      for (uint32_t i = 0; i < t.size(); ++i)
+        if (t.flags(i) & pathcore::Duplicate)
+          std::cout << "   " << Colors::text::bright_magenta << "🔄"
+                    << Colors::reset << " [" << pathcore::scopeName(t.scope(i))
+                    << "] " << t.expanded(i) << "\n";
+      std::cout << "\n";
+    }
+
+    if (problems == 0)
+      std::cout << "✅ All " << audits.size() << " list variables are clean!\n\n";
+    else
+      std::cout << Colors::text::yellow << "💡 Fix one with --var NAME clean, "
+                << "or --var NAME duplicates for details.\n\n"
                 << Colors::reset;
+  }
+
+  void auditUserProfiles(const std::string &dirArg) {
+    if (!loadPaths())
+      return;
+    printHeader("USER PROFILE AUDIT");
+
+    std::string dir = dirArg.empty() ? pathcore::defaultProfileDir() : dirArg;
+    std::vector<pathcore::UserProfile> profiles;
+    std::string error;
+    if (!pathcore::listProfiles(dir, profiles, error)) {
+      std::cerr << "❌ " << error << "\n\n";
+      return;
+    }
+    if (profiles.empty()) {
+      std::cout << "🔍 No user profiles found.\n\n";
       return;
     }
 
-    std::string rebuilt;
-    for (size_t i = 0; i < newPaths.size(); ++i) {
-      if (i > 0)
-        rebuilt += ';';
-      rebuilt += newPaths[i];
+    auto start = std::chrono::steady_clock::now();
+    auto report = pathcore::auditProfiles(
+        dir, profiles, var, table(), session.probeCache(),
+        std::max(1u, std::thread::hardware_concurrency()));
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    std::cout << Colors::bold << pad("Profile", 46) << pad("Entries", 9)
+              << pad("Invalid", 9) << pad("Dups", 6) << pad("In SYS", 8)
+              << "Length" << Colors::reset << "\n";
+    size_t invalid = 0, dups = 0, redundant = 0;
+    for (const auto &p : report.profiles) {
+      std::cout << Colors::text::bright_cyan << pad(getShortenedPath(p.id, 44), 46)
+                << Colors::reset;
+      if (!p.error.empty()) {
+        std::cout << Colors::text::bright_red << "⚠️  " << p.error << Colors::reset
+                  << "\n";
+        continue;
+      }
+      invalid += p.invalid;
+      dups += p.duplicates;
+      redundant += p.inSystem;
+      std::cout << pad(std::to_string(p.entries), 9);
+      if (p.invalid)
+        std::cout << Colors::text::bright_red;
+      std::cout << pad(std::to_string(p.invalid), 9) << Colors::reset;
+      if (p.duplicates)
+        std::cout << Colors::text::bright_magenta;
+      std::cout << pad(std::to_string(p.duplicates), 6) << Colors::reset;
+      if (p.inSystem)
+        std::cout << Colors::text::bright_yellow;
+      std::cout << pad(std::to_string(p.inSystem), 8) << Colors::reset
+                << p.length << "\n";
     }
 
-    if (setUserPath(rebuilt)) {
-      std::cout << "✅ Successfully removed \"" << targetDir
-                << "\" from user PATH.\n\n";
+    std::cout << "\n"
+              << Colors::text::bright_yellow << "📊 SUMMARY:\n"
+              << Colors::text::white << "   Profiles read: "
+              << Colors::text::bright_cyan << report.readable << "/"
+              << report.profiles.size() << Colors::text::white << " in "
+              << std::fixed << std::setprecision(2) << seconds << " s\n"
+              << std::defaultfloat << std::setprecision(6)
+              << "   " << Colors::text::bright_red << "❌ Invalid entries: "
+              << invalid << "\n"
+              << "   " << Colors::text::bright_magenta
+              << "🔄 Duplicate entries: " << dups << "\n"
+              << "   " << Colors::text::bright_yellow
+              << "🗂️  Entries already in system " << var << ": " << redundant
+              << "\n\n"
+              << Colors::reset;
+
+    if (!report.common.empty()) {
+      std::cout << "📋 Every user has these; they belong in the system " << var
+                << ":\n";
+      for (const auto &e : report.common)
+        std::cout << "   • " << e << "\n";
+      std::cout << "\n";
+    }
+  }
+
+  void browse() {
+    Browser(session, var).run();
+  }
+
+  // Runs until killed; returns the exit code on a setup error.
+  int serveQueries(const std::string &endpoint) {
+    pathcore::QueryServer server(pathcore::openDefaultStore(), var);
+    std::string where =
+        endpoint.empty() ? pathcore::QueryServer::defaultEndpoint() : endpoint;
+    std::cout << Colors::text::teal << "📡 Serving " << var << " queries on "
+              << where << " (Ctrl+C to stop)\n"
+              << Colors::reset << std::flush;
+    // Ctrl+C stops the server cleanly, so the socket is removed
+    static pathcore::QueryServer *running;
+    running = &server;
+    auto onSignal = [](int) { running->stop(); };
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::string error;
+    bool ok = server.serve(where, error);
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    if (!ok) {
+      std::cerr << "❌ " << error << "\n";
+      return 1;
+    }
+    std::cout << Colors::text::teal << "📡 Stopped.\n" << Colors::reset;
+    return 0;
+  }
+
+  void showHistory(pathcore::Scope scope) {
+    printHeader(std::string(pathcore::scopeName(scope)) + " " + var + " HISTORY");
+
+    pathcore::Journal *journal = session.journal();
+    // Newest last, like a log; only the tail is interesting
+    auto chain = journal ? journal->history(scope, var, 20)
+                         : std::vector<pathcore::Generation>{};
+    if (chain.empty()) {
+      std::cout << "📜 No recorded changes yet.\n\n";
+      return;
+    }
+
+    size_t first = chain.size() > 20 ? chain.size() - 20 : 0;
+    for (size_t k = first; k < chain.size(); ++k) {
+      const auto &g = chain[k];
+      std::time_t when = static_cast<std::time_t>(g.timeMs / 1000);
+      std::cout << Colors::text::bright_cyan << "#" << std::setw(4) << std::left
+                << g.number << Colors::reset << " "
+                << std::put_time(std::localtime(&when), "%Y-%m-%d %H:%M:%S")
+                << "  " << Colors::text::bright_green << "+"
+                << g.delta.count('+') << Colors::text::bright_red << " -"
+                << g.delta.count('-') << Colors::text::bright_yellow << " ~"
+                << g.delta.count('>') << Colors::reset;
+      if (g.kind == 'X')
+        std::cout << Colors::text::bright_black << "  (changed outside, "
+                  << pathcore::splitPath(g.value).size() << " entries)"
+                  << Colors::reset;
+      else if (g.restores)
+        std::cout << Colors::text::bright_black << "  (undo to #" << g.restores
+                  << ")" << Colors::reset;
+      std::cout << "\n";
+      for (const auto &op : g.delta.ops) {
+        if (op.kind == '+')
+          std::cout << Colors::text::bright_green << "      + ";
+        else if (op.kind == '-')
+          std::cout << Colors::text::bright_red << "      - ";
+        else
+          std::cout << Colors::text::bright_yellow << "      ~ ";
+        std::cout << op.text << Colors::reset << "\n";
+      }
+    }
+    std::cout << "\n";
+  }
+
+  void undoChanges(int steps, pathcore::Scope scope) {
+    selectPaths();
+
+    pathcore::Journal *journal = session.journal();
+    std::vector<pathcore::Generation> chain;
+    // Undos are journaled too; stepping back skips them and what they
+    // took back, so repeated undos keep walking back.
+    uint64_t target =
+        journal && steps >= 1
+            ? journal->stepBack(scope, var,
+                                static_cast<unsigned>(steps), chain)
+            : 0;
+    if (target == 0) {
+      std::cout << Colors::text::red << "❌ Not enough history to undo "
+                << steps << " change(s).\n\n"
+                << Colors::reset;
+      return;
+    }
+
+    const pathcore::StoreValue *stored = session.value(scope);
+    if (!stored) {
+      std::cerr << "❌ " << session.lastError() << "\n";
+      return;
+    }
+    const std::string &current = stored->data;
+    std::string value;
+    if (!pathcore::Journal::reconstruct(chain, target, current, value)) {
+      std::cout << Colors::text::red << "❌ Generation #" << target
+                << " cannot be rebuilt from the journal.\n\n"
+                << Colors::reset;
+      return;
+    }
+
+    // Restore only over the value the reconstruction started from
+    uint64_t seen = pathcore::contentHash(
+        pathcore::joinPath(pathcore::splitPath(current)));
+    auto edit = [&](std::vector<std::string> &entries) {
+      if (pathcore::contentHash(pathcore::joinPath(entries)) != seen)
+        return pathcore::EditResult::Abort;
+      auto restored = pathcore::splitPath(value);
+      if (restored == entries)
+        return pathcore::EditResult::Unchanged;
+      entries = std::move(restored);
+      return pathcore::EditResult::Changed;
+    };
+
+    auto result = session.restore(scope, target, edit);
+    if (result.status == pathcore::CommitStatus::Committed ||
+        result.status == pathcore::CommitStatus::Unchanged) {
+      std::cout << Colors::text::teal << "↩️  "
+                << (scope == pathcore::Scope::User ? "User " : "System ") << var
+                << " restored to generation #"
+                << target << ".\n\n"
+                << Colors::reset;
+    } else if (result.status == pathcore::CommitStatus::Aborted) {
+      std::cout << Colors::text::red
+                << "❌ " << var << " changed while undoing; run undo again.\n\n"
+                << Colors::reset;
+    } else {
+      std::cerr << "❌ " << session.lastError() << "\n";
     }
   }
 };
 
+// ─────────────────────────────────────────────────────────────────────────────
+//  --stats / --trace
+// ─────────────────────────────────────────────────────────────────────────────
+// Reports on the way out of main, after the PathManager (and the change
+// broadcast it may still be sending) is gone.
+struct TraceReport {
+  bool stats = false;
+  std::string file;
+
+  ~TraceReport() {
+    if (!pathcore::tracingEnabled())
+      return;
+    if (!file.empty()) {
+      std::string error;
+      if (!pathcore::writeChromeTrace(file, error))
+        std::cerr << "❌ " << error << "\n";
+    }
+    if (stats)
+      print();
+  }
+
+  void print() const {
+    using namespace Colors;
+    double wall = pathcore::tracingMillis();
+    std::cerr << "\n" << text::bright_yellow << "⏱️  STATS:\n" << reset
+              << text::purple << "   " << std::left << std::setw(14) << "phase"
+              << std::right << std::setw(8) << "spans" << std::setw(12) << "ms"
+              << std::setw(10) << "% wall" << "\n" << reset;
+    for (int p = 0; p < static_cast<int>(pathcore::Phase::Count); ++p) {
+      auto phase = static_cast<pathcore::Phase>(p);
+      auto total = pathcore::phaseTotal(phase);
+      if (!total.spans)
+        continue;
+      std::cerr << "   " << text::bright_cyan << std::left << std::setw(14)
+                << pathcore::phaseName(phase) << text::white << std::right
+                << std::setw(8) << total.spans << std::setw(12) << std::fixed
+                << std::setprecision(3) << total.ms << std::setw(9)
+                << std::setprecision(1) << (wall > 0 ? 100 * total.ms / wall : 0)
+                << "%\n";
+    }
+    std::cerr << "   " << text::bright_cyan << std::left << std::setw(14)
+              << "total" << text::white << std::right << std::setw(20)
+              << std::setprecision(3) << wall << "\n\n"
+              << reset;
+    for (int c = 0; c < static_cast<int>(pathcore::Counter::Count); ++c) {
+      auto counter = static_cast<pathcore::Counter>(c);
+      std::cerr << "   " << text::white << std::left << std::setw(22)
+                << pathcore::counterName(counter) << text::bright_cyan
+                << std::right << std::setw(12) << pathcore::counterTotal(counter)
+                << "\n";
+    }
+    std::cerr << reset << "\n";
+  }
+};
+
 void showUsage(const char *programName) {
   using namespace Colors;
   std::cout << "\n";
@@ -566,19 +2069,69 @@ void showUsage(const char *programName) {
             << "   " << text::bright_green // green for verbs
             << "add-path" << text::white << " show" <<
             "                                 # Display all PATH entries\n"
+            << "   " << text::bright_green << "add-path show" << text::white
+            << " --offset <n> --limit <n>      # Display one page of entries\n"
             << "   " << text::bright_green << "add-path add" << text::white
             << " <directory>" << 
                             "                      # Add directory to user PATH\n"
             << "   " << text::bright_green << "add-path remove" << text::white
             << " <directory>                   # Remove directory from user PATH\n"
+            << "   " << text::bright_green << "add-path remove" << text::white
+            << " --match <glob> [--apply]      # Remove every matching entry (also --regex)\n"
+            << "   " << text::bright_green << "add-path keep" << text::white
+            << " --match <glob> [--apply]        # Remove every entry that does not match\n"
+            << "   " << text::bright_green << "add-path move" << text::white
+            << " --match <glob> --front|--back [--apply]  # Move matching entries\n"
             << "   " << text::bright_green << "add-path search" << text::white
             << " <term>                        # Search PATH for term\n"
             << "   " << text::bright_green << "add-path clean" << text::white
             << "                                # Cleanup invalid user PATH entries\n"
             << "   " << text::bright_green << "add-path duplicates" << text::white
             << "                           # Find duplicate PATH entries\n"
+            << "   " << text::bright_green << "add-path dedupe" << text::white
+            << " [--prefer system|user|none] [--apply]  # Drop duplicates, keeping the first\n"
+            << "   " << text::bright_green << "add-path same-content" << text::white
+            << " [--time-limit <s>] [--no-cache]  # Find byte-identical tools in PATH\n"
             << "   " << text::bright_green << "add-path export" << text::white
             << "                               # Export current PATH to a log file\n"
+            << "   " << text::bright_green << "add-path export-reg" << text::white
+            << " <file.reg> [--utf8]        # Export both Environment keys as a .reg file\n"
+            << "   " << text::bright_green << "add-path import-reg" << text::white
+            << " <file.reg> [--sid <SID>] [--all] [--apply]  # Import from a .reg or hive export\n"
+            << "   " << text::bright_green << "add-path cost" << text::white
+            << " [workload]                    # Estimate lookup cost of each PATH entry\n"
+            << "   " << text::bright_green << "add-path optimize" << text::white
+            << " [workload]                # Reorder user PATH for faster lookups\n"
+            << "   " << text::bright_green << "add-path compact" << text::white
+            << "                              # Shorten entries with %VAR% prefixes\n"
+            << "   " << text::bright_green << "add-path lint" << text::white
+            << " <rules> [snapshots...]         # Check PATH or exports against policy rules\n"
+            << "   " << text::bright_green << "add-path audit-all" << text::white
+            << "                            # Check every list variable (PATHEXT, INCLUDE, ...)\n"
+            << "   " << text::bright_green << "add-path users" << text::white
+            << " [dir]                           # Audit every user profile's PATH\n"
+            << "   " << text::bright_green << "add-path browse" << text::white
+            << "                               # Browse, filter and edit entries full-screen\n"
+            << "   " << text::bright_green << "add-path serve" << text::white
+            << " [socket]                       # Answer NDJSON PATH queries on a local socket\n"
+            << "   " << text::bright_green << "add-path history" << text::white
+            << " [--system]                   # Show recorded PATH changes\n"
+            << "   " << text::bright_green << "add-path undo" << text::white
+            << " [n] [--system]                  # Revert the last n PATH changes\n"
+            << reset;
+
+  std::cout << "\n" << text::yellow << bold << "⚙️  OPTIONS:\n" << reset;
+  std::cout << text::white
+            << "   " << text::bright_green << "--wait" << text::white
+            << "                                        # Wait for the change broadcast to be delivered\n"
+            << "   " << text::bright_green << "--no-notify" << text::white
+            << "                                   # Write without broadcasting the change\n"
+            << "   " << text::bright_green << "--var" << text::white << " NAME"
+            << "                                    # Work on another list variable instead of PATH\n"
+            << "   " << text::bright_green << "--stats" << text::white
+            << "                                       # Print time per phase and work counters\n"
+            << "   " << text::bright_green << "--trace" << text::white << " FILE"
+            << "                                  # Write a Chrome trace (chrome://tracing, Perfetto)\n"
             << reset;
 
   // Examples label
@@ -597,36 +2150,227 @@ void showUsage(const char *programName) {
 }
 
 int main(int argc, char *argv[]) {
+#ifdef _WIN32
   SetConsoleOutputCP(CP_UTF8);
+#endif
   if (argc < 2) {
     showUsage(argv[0]);
     return 1;
   }
 
-  PathManager pm;
-  std::string cmd = argv[1];
+  // Global options may appear anywhere; everything else is the command and
+  // its arguments.
+  std::vector<std::string> args;
+  bool waitNotify = false, notify = true;
+  std::string var;
+  TraceReport report;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--wait")
+      waitNotify = true;
+    else if (a == "--no-notify")
+      notify = false;
+    else if (a == "--var" && i + 1 < argc)
+      var = argv[++i];
+    else if (a == "--stats")
+      report.stats = true;
+    else if (a == "--trace" && i + 1 < argc)
+      report.file = argv[++i];
+    else
+      args.push_back(a);
+  }
+  if (args.empty()) {
+    showUsage(argv[0]);
+    return 1;
+  }
+  if (report.stats || !report.file.empty())
+    pathcore::startTracing(!report.file.empty());
+
+  std::string cmd = args[0];
+  int exitCode = 0;
   std::transform(cmd.begin(), cmd.end(), cmd.begin(), ::tolower);
 
+  // Answered before the store is opened
+  if (cmd == "version" || cmd == "--version" || cmd == "-v") {
+    std::cout << "\n" << Colors::bold << VERSION << Colors::reset << "\n\n";
+    return 0;
+  }
+
+  PathManager pm;
+  pm.setNotify(notify);
+  if (!var.empty())
+    pm.setVariable(var);
+
   if (cmd == "show" || cmd == "list") {
-    pm.listAllPaths();
-  } else if (cmd == "add" && argc == 3) {
-    pm.addToUserPath(argv[2]);
-  } else if (cmd == "remove" && argc == 3) {
-    pm.removeFromUserPath(argv[2]);
+    size_t offset = 0, limit = SIZE_MAX;
+    for (size_t i = 1; i + 1 < args.size(); i += 2) {
+      if (args[i] == "--offset")
+        offset = std::strtoull(args[i + 1].c_str(), nullptr, 10);
+      else if (args[i] == "--limit")
+        limit = std::strtoull(args[i + 1].c_str(), nullptr, 10);
+    }
+    pm.listAllPaths(offset, limit);
+  } else if (cmd == "add" && args.size() == 2) {
+    pm.addToUserPath(args[1]);
+  } else if ((cmd == "remove" || cmd == "keep" || cmd == "move") &&
+             args.size() > 2) {
+    // Pattern selectors: --match <glob>, --regex <re>, any number of each
+    pathcore::EntryMatcher matcher;
+    auto action = cmd == "remove" ? pathcore::Selection::Remove
+                  : cmd == "keep" ? pathcore::Selection::Keep
+                                  : pathcore::Selection::MoveFront;
+    bool apply = false, placed = cmd != "move";
+    for (size_t i = 1; i < args.size(); ++i) {
+      std::string error;
+      if (args[i] == "--apply") {
+        apply = true;
+      } else if (args[i] == "--front" && cmd == "move") {
+        action = pathcore::Selection::MoveFront;
+        placed = true;
+      } else if (args[i] == "--back" && cmd == "move") {
+        action = pathcore::Selection::MoveBack;
+        placed = true;
+      } else if (args[i] == "--match" && i + 1 < args.size()) {
+        matcher.addGlob(args[++i]);
+      } else if (args[i] == "--regex" && i + 1 < args.size()) {
+        if (!matcher.addRegex(args[++i], error)) {
+          std::cerr << "❌ " << error << "\n";
+          return 2;
+        }
+      } else {
+        showUsage(argv[0]);
+        return 1;
+      }
+    }
+    if (matcher.empty() || !placed) {
+      showUsage(argv[0]);
+      return 1;
+    }
+    pm.selectUserEntries(matcher, action, apply);
+  } else if (cmd == "remove" && args.size() == 2) {
+    pm.removeFromUserPath(args[1]);
   } else if (cmd == "clean") {
     pm.cleanupInvalidPaths();
   } else if (cmd == "duplicates" || cmd == "dups") {
     pm.findDuplicates();
+  } else if (cmd == "dedupe") {
+    auto policy = pathcore::DedupePolicy::PreferSystem;
+    bool apply = false;
+    for (size_t i = 1; i < args.size(); ++i) {
+      if (args[i] == "--apply")
+        apply = true;
+      else if (args[i] == "--prefer" && i + 1 < args.size()) {
+        std::string p = args[++i];
+        if (p == "user")
+          policy = pathcore::DedupePolicy::PreferUser;
+        else if (p == "none")
+          policy = pathcore::DedupePolicy::KeepBoth;
+        else if (p != "system") {
+          showUsage(argv[0]);
+          return 1;
+        }
+      } else {
+        showUsage(argv[0]);
+        return 1;
+      }
+    }
+    pm.dedupePaths(policy, apply);
+  } else if (cmd == "same-content") {
+    std::chrono::seconds limit(60);
+    bool useCache = true;
+    for (size_t i = 1; i < args.size(); ++i) {
+      if (args[i] == "--no-cache")
+        useCache = false;
+      else if (args[i] == "--time-limit" && i + 1 < args.size())
+        limit = std::chrono::seconds(std::atoi(args[++i].c_str()));
+      else {
+        showUsage(argv[0]);
+        return 1;
+      }
+    }
+    pm.findSameContent(limit, useCache);
   } else if (cmd == "export" || cmd == "backup") {
     pm.exportPath();
-  } else if (cmd == "search" && argc == 3) {
-    pm.searchInPath(argv[2]);
-  } else if (cmd == "version" || cmd == "--version" || cmd == "-v") {
-    std::cout << "\n" << Colors::bold << VERSION << Colors::reset << "\n\n";
+  } else if (cmd == "export-reg" && args.size() >= 2) {
+    auto encoding = pathcore::RegEncoding::Utf16;
+    for (size_t i = 2; i < args.size(); ++i) {
+      if (args[i] != "--utf8") {
+        showUsage(argv[0]);
+        return 1;
+      }
+      encoding = pathcore::RegEncoding::Utf8;
+    }
+    pm.exportRegFile(args[1], encoding);
+  } else if (cmd == "import-reg" && args.size() >= 2) {
+    std::string sid;
+    bool apply = false, all = false;
+    for (size_t i = 2; i < args.size(); ++i) {
+      if (args[i] == "--apply")
+        apply = true;
+      else if (args[i] == "--all")
+        all = true;
+      else if (args[i] == "--sid" && i + 1 < args.size())
+        sid = args[++i];
+      else {
+        showUsage(argv[0]);
+        return 1;
+      }
+    }
+    pm.importRegFile(args[1], sid, apply, all);
+  } else if (cmd == "search" && args.size() == 2) {
+    pm.searchInPath(args[1]);
+  } else if (cmd == "cost" && args.size() <= 2) {
+    pm.showLookupCost(args.size() == 2 ? args[1] : "");
+  } else if (cmd == "optimize") {
+    bool allowChanges = false;
+    std::string workload;
+    for (size_t i = 1; i < args.size(); ++i) {
+      if (args[i] == "--allow-changes")
+        allowChanges = true;
+      else
+        workload = args[i];
+    }
+    pm.optimizeUserPath(workload, allowChanges);
+  } else if (cmd == "compact") {
+    pm.compactUserPath();
+  } else if (cmd == "lint" && args.size() >= 2) {
+    exitCode = pm.lintPaths(
+        args[1], std::vector<std::string>(args.begin() + 2, args.end()));
+  } else if (cmd == "audit-all") {
+    pm.auditAllLists();
+  } else if (cmd == "users" && args.size() <= 2) {
+    pm.auditUserProfiles(args.size() == 2 ? args[1] : "");
+  } else if (cmd == "browse" || cmd == "tui") {
+    pm.browse();
+  } else if (cmd == "serve" && args.size() <= 2) {
+    exitCode = pm.serveQueries(args.size() == 2 ? args[1] : "");
+  } else if (cmd == "history" || cmd == "undo") {
+    // Either scope's writes are journaled; --system picks the system one.
+    auto scope = pathcore::Scope::User;
+    int steps = 1;
+    bool counted = false;
+    for (size_t i = 1; i < args.size(); ++i) {
+      if (args[i] == "--system") {
+        scope = pathcore::Scope::System;
+      } else if (cmd == "undo" && !counted && !args[i].empty() &&
+                 args[i].find_first_not_of("0123456789") == std::string::npos) {
+        steps = std::atoi(args[i].c_str());
+        counted = true;
+      } else {
+        showUsage(argv[0]);
+        return 1;
+      }
+    }
+    if (cmd == "history")
+      pm.showHistory(scope);
+    else
+      pm.undoChanges(steps, scope);
   } else {
     showUsage(argv[0]);
     return 1;
   }
 
-  return 0;
+  if (waitNotify)
+    pm.waitForNotifications();
+  return exitCode;
 }
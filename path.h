@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <csignal>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
@@ -14,8 +15,34 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
 #include <windows.h>
+#endif
+
+#include "core/compact.h"
+#include "core/content.h"
+#include "core/cost.h"
+#include "core/edits.h"
+#include "core/impact.h"
+#include "core/lint.h"
+#include "core/match.h"
+#include "core/optimize.h"
+#include "core/profiles.h"
+#include "core/regfile.h"
+#include "core/render.h"
+#include "core/screen.h"
+#include "core/server.h"
+#include "core/session.h"
+#include "core/trace.h"
 
 namespace Colors {
 struct Reset {};          